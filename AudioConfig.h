@@ -0,0 +1,39 @@
+#pragma once
+
+// OpenAL is optional, like the device sinks: it is used when <AL/al.h> is
+// found, unless the build defines ECHOES_NO_OPENAL (the Makefile does when
+// pkg-config has no openal). Without it only the software and null backends
+// exist, and the types and formats below stand in for OpenAL's, since the
+// decoders and the mixer describe PCM with them.
+#if !defined(ECHOES_NO_OPENAL) && defined(__has_include)
+#if __has_include(<AL/al.h>)
+#define ECHOES_HAVE_OPENAL 1
+#include <AL/al.h>
+#include <AL/alc.h>
+#endif
+#endif
+
+#ifndef ECHOES_HAVE_OPENAL
+typedef char ALboolean;
+typedef char ALchar;
+typedef int ALint;
+typedef unsigned int ALuint;
+typedef int ALsizei;
+typedef int ALenum;
+typedef float ALfloat;
+typedef void ALvoid;
+
+typedef struct ALCdevice ALCdevice;
+typedef struct ALCcontext ALCcontext;
+typedef char ALCboolean;
+typedef char ALCchar;
+typedef int ALCint;
+typedef int ALCsizei;
+typedef int ALCenum;
+typedef void ALCvoid;
+
+#define AL_FORMAT_MONO8 0x1100
+#define AL_FORMAT_MONO16 0x1101
+#define AL_FORMAT_STEREO8 0x1102
+#define AL_FORMAT_STEREO16 0x1103
+#endif
@@ -0,0 +1,202 @@
+#include "AudioDecoder.h"
+#include "MappedFile.h"
+#include "WavFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+// stb_vorbis is optional: drop stb_vorbis.c next to the sources (or anywhere
+// on the include path) to enable .ogg support
+#if defined(__has_include)
+#if __has_include("stb_vorbis.c")
+#define ECHOES_HAVE_VORBIS 1
+#endif
+#endif
+
+#ifdef ECHOES_HAVE_VORBIS
+#include "stb_vorbis.c"
+#endif
+
+namespace {
+
+std::string lowerExtension(const std::string& filename) {
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string extension = filename.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+// Streams a mapped WAV file. 8/16-bit PCM is copied out as it is; 24-bit and
+// float samples are converted to 16-bit as they are read.
+class WavDecoder : public AudioDecoder {
+private:
+    MappedFile file;
+    WavInfo wav;
+    ALenum format;
+    uint32_t frameBytes;        // of the output, not the file
+    uint64_t totalFrames;
+    uint64_t position;          // in frames
+
+public:
+    WavDecoder() : wav(), format(AL_FORMAT_MONO16), frameBytes(1), totalFrames(0), position(0) {}
+
+    bool open(const std::string& filename) {
+        if (!file.open(filename, MappedAccess::SEQUENTIAL)) {
+            std::cerr << "Failed to open audio file: " << filename << std::endl;
+            return false;
+        }
+
+        std::string error;
+        if (!parseWav(file.data(), file.size(), wav, error)) {
+            std::cerr << "Invalid WAV file (" << error << "): " << filename << std::endl;
+            return false;
+        }
+
+        bool stereo = wav.channels == 2;
+        if (wav.encoding == WavEncoding::PCM_U8) {
+            format = stereo ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
+            frameBytes = wav.blockAlign;
+        } else {
+            format = stereo ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+            frameBytes = wav.channels * sizeof(int16_t);
+        }
+        totalFrames = wav.sampleBytes / wav.blockAlign;
+        position = 0;
+        return true;
+    }
+
+    ALenum getFormat() const override { return format; }
+    ALsizei getSampleRate() const override { return static_cast<ALsizei>(wav.sampleRate); }
+    uint32_t getFrameBytes() const override { return frameBytes; }
+    uint64_t getTotalFrames() const override { return totalFrames; }
+
+    size_t read(char* out, size_t maxBytes) override {
+        uint64_t frames = std::min(static_cast<uint64_t>(maxBytes / frameBytes), totalFrames - position);
+        if (frames == 0) return 0;
+
+        const unsigned char* source = wav.samples + position * wav.blockAlign;
+        size_t count = static_cast<size_t>(frames) * wav.channels;
+
+        switch (wav.encoding) {
+            case WavEncoding::PCM_U8:
+            case WavEncoding::PCM_S16:
+                std::memcpy(out, source, static_cast<size_t>(frames) * frameBytes);
+                break;
+            case WavEncoding::PCM_S24:
+                for (size_t i = 0; i < count; ++i) {
+                    int16_t sample = floatToS16(sampleFromS24(source + i * 3));
+                    std::memcpy(out + i * sizeof(int16_t), &sample, sizeof(int16_t));
+                }
+                break;
+            case WavEncoding::FLOAT32:
+                for (size_t i = 0; i < count; ++i) {
+                    float value;
+                    std::memcpy(&value, source + i * sizeof(float), sizeof(float));
+                    int16_t sample = floatToS16(value);
+                    std::memcpy(out + i * sizeof(int16_t), &sample, sizeof(int16_t));
+                }
+                break;
+        }
+
+        position += frames;
+        return static_cast<size_t>(frames) * frameBytes;
+    }
+
+    bool seek(uint64_t frame) override {
+        position = std::min(frame, totalFrames);
+        return true;
+    }
+};
+
+#ifdef ECHOES_HAVE_VORBIS
+
+// Ogg Vorbis through stb_vorbis, decoded to interleaved 16-bit
+class VorbisDecoder : public AudioDecoder {
+private:
+    stb_vorbis* vorbis;
+    int channels;
+    ALsizei sampleRate;
+    uint64_t totalFrames;
+
+public:
+    VorbisDecoder() : vorbis(nullptr), channels(0), sampleRate(0), totalFrames(0) {}
+    ~VorbisDecoder() override {
+        if (vorbis) stb_vorbis_close(vorbis);
+    }
+
+    bool open(const std::string& filename) {
+        int error = 0;
+        vorbis = stb_vorbis_open_filename(filename.c_str(), &error, nullptr);
+        if (!vorbis) {
+            std::cerr << "Failed to open Ogg Vorbis file (error " << error << "): " << filename << std::endl;
+            return false;
+        }
+
+        stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+        if (info.channels != 1 && info.channels != 2) {
+            std::cerr << "Unsupported channel count " << info.channels << ": " << filename << std::endl;
+            return false;
+        }
+        channels = info.channels;
+        sampleRate = static_cast<ALsizei>(info.sample_rate);
+        totalFrames = stb_vorbis_stream_length_in_samples(vorbis);
+        return true;
+    }
+
+    ALenum getFormat() const override { return channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16; }
+    ALsizei getSampleRate() const override { return sampleRate; }
+    uint32_t getFrameBytes() const override { return static_cast<uint32_t>(channels * sizeof(short)); }
+    uint64_t getTotalFrames() const override { return totalFrames; }
+
+    size_t read(char* out, size_t maxBytes) override {
+        int shorts = static_cast<int>(maxBytes / sizeof(short));
+        shorts -= shorts % channels;
+        if (shorts == 0) return 0;
+
+        int frames = stb_vorbis_get_samples_short_interleaved(vorbis, channels, reinterpret_cast<short*>(out),
+                                                              shorts);
+        return static_cast<size_t>(frames) * getFrameBytes();
+    }
+
+    bool seek(uint64_t frame) override {
+        return stb_vorbis_seek(vorbis, static_cast<unsigned int>(frame)) != 0;
+    }
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<AudioDecoder> openAudioDecoder(const std::string& filename) {
+    std::string extension = lowerExtension(filename);
+
+    if (extension == "wav") {
+        auto decoder = std::make_unique<WavDecoder>();
+        if (!decoder->open(filename)) return nullptr;
+        return decoder;
+    }
+
+    if (extension == "ogg") {
+#ifdef ECHOES_HAVE_VORBIS
+        auto decoder = std::make_unique<VorbisDecoder>();
+        if (!decoder->open(filename)) return nullptr;
+        return decoder;
+#else
+        // Without a decoder, use a .wav of the same name if there is one
+        std::string fallback = filename.substr(0, filename.size() - extension.size()) + "wav";
+        std::cerr << "Ogg Vorbis support not built in (stb_vorbis.c not found), trying " << fallback
+                  << std::endl;
+        return openAudioDecoder(fallback);
+#endif
+    }
+
+    std::cerr << "Unknown audio format: " << filename << std::endl;
+    return nullptr;
+}
+
+bool isCompressedAudio(const std::string& filename) {
+    return lowerExtension(filename) != "wav";
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "AudioConfig.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Pulls PCM out of an audio file a piece at a time, already in a format
+// OpenAL accepts. Used for streamed music and for decoding compressed sound
+// effects into memory on worker threads. Not thread safe; one owner at a time.
+class AudioDecoder {
+public:
+    virtual ~AudioDecoder() = default;
+
+    virtual ALenum getFormat() const = 0;
+    virtual ALsizei getSampleRate() const = 0;
+    virtual uint32_t getFrameBytes() const = 0;
+
+    // Length in frames, or 0 if the container does not say
+    virtual uint64_t getTotalFrames() const = 0;
+
+    // Decode up to maxBytes (rounded down to whole frames) into out. Returns
+    // the bytes written; 0 means the end of the file.
+    virtual size_t read(char* out, size_t maxBytes) = 0;
+
+    // Continue decoding from the given frame
+    virtual bool seek(uint64_t frame) = 0;
+};
+
+// Picks a decoder from the file extension: .wav always, .ogg when the build
+// has stb_vorbis. Returns nullptr (after logging why) if the file cannot be
+// opened or decoded.
+std::unique_ptr<AudioDecoder> openAudioDecoder(const std::string& filename);
+
+// True for formats that need decoding rather than a straight copy
+bool isCompressedAudio(const std::string& filename);
@@ -1,27 +1,258 @@
 #include "AudioEngine.h"
+#include "WavFile.h"
+#include "AudioDecoder.h"
+#include "MixerKernels.h"
 #include <iostream>
-#include <fstream>
 #include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// From AL_EXT_float32; not every SDK ships alext.h
+#ifndef AL_FORMAT_MONO_FLOAT32
+#define AL_FORMAT_MONO_FLOAT32 0x10010
+#define AL_FORMAT_STEREO_FLOAT32 0x10011
+#endif
+
+// From ALC_SOFT_loopback
+#ifndef ALC_FORMAT_CHANNELS_SOFT
+#define ALC_FORMAT_CHANNELS_SOFT 0x1990
+#define ALC_FORMAT_TYPE_SOFT 0x1991
+#define ALC_SHORT_SOFT 0x1402
+#define ALC_STEREO_SOFT 0x1501
+#endif
+
+// From ALC_EXT_EFX (efx.h)
+#ifndef AL_FILTER_LOWPASS
+#define AL_DIRECT_FILTER 0x20005
+#define AL_FILTER_TYPE 0x8001
+#define AL_FILTER_NULL 0x0000
+#define AL_FILTER_LOWPASS 0x0001
+#define AL_LOWPASS_GAIN 0x0001
+#define AL_LOWPASS_GAINHF 0x0002
+#endif
+
+namespace {
+
+bool getMixerFormat(ALenum format, int& channels, MixerSampleType& type) {
+    switch (format) {
+    case AL_FORMAT_MONO8: channels = 1; type = MixerSampleType::U8; return true;
+    case AL_FORMAT_MONO16: channels = 1; type = MixerSampleType::S16; return true;
+    case AL_FORMAT_STEREO8: channels = 2; type = MixerSampleType::U8; return true;
+    case AL_FORMAT_STEREO16: channels = 2; type = MixerSampleType::S16; return true;
+    case AL_FORMAT_MONO_FLOAT32: channels = 1; type = MixerSampleType::F32; return true;
+    case AL_FORMAT_STEREO_FLOAT32: channels = 2; type = MixerSampleType::F32; return true;
+    default: return false;
+    }
+}
+
+int getFormatFrameBytes(ALenum format) {
+    switch (format) {
+    case AL_FORMAT_MONO8: return 1;
+    case AL_FORMAT_MONO16: return 2;
+    case AL_FORMAT_STEREO8: return 2;
+    case AL_FORMAT_STEREO16: return 4;
+    case AL_FORMAT_MONO_FLOAT32: return 4;
+    case AL_FORMAT_STEREO_FLOAT32: return 8;
+    default: return 0;
+    }
+}
+
+const char* getBackendName(AudioBackend backend) {
+    switch (backend) {
+    case AudioBackend::OPENAL: return "OpenAL";
+    case AudioBackend::OPENAL_LOOPBACK: return "OpenAL loopback";
+    case AudioBackend::SOFTWARE: return "software mixer";
+    case AudioBackend::SOFTWARE_LOOPBACK: return "software mixer loopback";
+    case AudioBackend::NULL_OUTPUT: return "null output";
+    }
+    return "unknown";
+}
+
+using LoopbackOpenDeviceFn = ALCdevice* (*)(const ALCchar*);
+using IsRenderFormatSupportedFn = ALCboolean (*)(ALCdevice*, ALCsizei, ALCenum, ALCenum);
+
+} // namespace
 
 AudioEngine::AudioEngine() 
-    : device(nullptr), context(nullptr), musicSource(0), currentMusicBuffer(0),
-      musicPlaying(false), musicVolume(0.5f), sfxVolume(1.0f), initialized(false) {
+    : device(nullptr), context(nullptr), backend(AudioBackend::OPENAL), renderSamples(nullptr),
+      genFilters(nullptr), deleteFilters(nullptr), filteri(nullptr), filterf(nullptr),
+      mixerResampler(MixerResampler::LINEAR), jobSystem(nullptr), floatFormats(false),
+      listenerX(0.0f), listenerY(0.0f), listenerZ(0.0f), listenerOrientation{0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f},
+      listenerVelocity{0.0f, 0.0f, 0.0f}, listenerDirty(false), nextPlaybackId(1),
+      commands(std::make_unique<MPSCQueue<Command, COMMAND_CAPACITY>>()), audioThreadQuit(false),
+      commandStalls(0), counters(), publishedStats(), publishedCounters(), virtualVoiceCount(0),
+      musicSources{0, 0}, activeMusic(0), musicPlaying(false), musicVolume(0.5f), sfxVolume(1.0f),
+      sfxGain(1.0f), initialized(false) {
+    for (int i = 0; i < MAX_SOUNDS; i++) {
+        soundBuffers[i] = 0;
+        soundDurations[i] = 0.0f;
+        soundStates[i].store(SoundState::EMPTY, std::memory_order_relaxed);
+    }
 }
 
 AudioEngine::~AudioEngine() {
     cleanup();
 }
 
-bool AudioEngine::initialize() {
+bool AudioEngine::initialize(AudioBackend requested) {
+    backend = requested;
+    
+    bool opened = false;
+    switch (backend) {
+    case AudioBackend::OPENAL:
+        opened = openDevice();
+        break;
+    case AudioBackend::OPENAL_LOOPBACK:
+        opened = openLoopbackDevice();
+        break;
+    case AudioBackend::SOFTWARE:
+        sink = openSystemAudioSink(OFFLINE_SAMPLE_RATE);
+        opened = sink != nullptr;
+        break;
+    case AudioBackend::SOFTWARE_LOOPBACK:
+    case AudioBackend::NULL_OUTPUT:
+        opened = true;
+        break;
+    }
+    if (!opened) return false;
+    
+    // The software mixer works in float, so it can keep full depth
+    floatFormats = backend != AudioBackend::NULL_OUTPUT;
+#ifdef ECHOES_HAVE_OPENAL
+    if (usesOpenAL()) {
+        floatFormats = alIsExtensionPresent("AL_EXT_float32") == AL_TRUE;
+    }
+#endif
+    if (backend == AudioBackend::SOFTWARE || backend == AudioBackend::SOFTWARE_LOOPBACK) {
+        mixer = std::make_unique<SoftwareMixer>(OFFLINE_SAMPLE_RATE, MAX_SOURCES);
+        mixer->setResampler(mixerResampler);
+        mixOutput.resize(static_cast<size_t>(MIX_PERIOD_FRAMES) * 2);
+        std::cout << "Software mixer using " << getMixerKernelName(getMixerKernelLevel()) << " kernels"
+                  << std::endl;
+    }
+    
+    // Create sound sources
+    voices.initialize(MAX_SOURCES, usesOpenAL());
+    if (usesOpenAL()) createVoiceFilters();
+    
+    // Everything but a real OpenAL device counts time in mixed frames
+    voices.setManualClock(backend != AudioBackend::OPENAL);
+    
+    // Create music streamers, fed into the mixer or sources
+    for (int i = 0; i < MUSIC_STREAMS; i++) {
+        if (mixer) {
+            MixerStream* stream = mixer->addStream(MUSIC_MIXER_FRAMES);
+            music[i] = std::make_unique<MusicStream>(createMixerMusicOutput(stream));
+        }
+#ifdef ECHOES_HAVE_OPENAL
+        else if (usesOpenAL()) {
+            musicSources[i] = createSource();
+            if (musicSources[i] != 0) {
+                music[i] = std::make_unique<MusicStream>(createOpenALMusicOutput(musicSources[i]));
+            }
+        }
+#endif
+    }
+    
+    // Set default listener orientation
+    applyListener();
+    counters = AudioCounters();
+    
+    // From here on only the audio thread touches sources and buffers.
+    // Offline backends get their ticks from render() instead.
+    if (!isOffline()) {
+        audioThreadQuit.store(false);
+        audioThread = std::thread(&AudioEngine::audioThreadLoop, this);
+    }
+    
+    initialized = true;
+    std::cout << "AudioEngine initialized successfully (" << getBackendName(backend) << ")" << std::endl;
+    return true;
+}
+
+#ifdef ECHOES_HAVE_OPENAL
+
+bool AudioEngine::openDevice() {
     // Open default audio device
     device = alcOpenDevice(nullptr);
     if (!device) {
         std::cerr << "Failed to open audio device" << std::endl;
         return false;
     }
+    return createContext(nullptr);
+}
+
+bool AudioEngine::openLoopbackDevice() {
+    if (alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback") != ALC_TRUE) {
+        std::cerr << "Loopback audio needs OpenAL Soft (ALC_SOFT_loopback not available)" << std::endl;
+        return false;
+    }
+    
+    auto openLoopback = reinterpret_cast<LoopbackOpenDeviceFn>(
+        alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+    auto isFormatSupported = reinterpret_cast<IsRenderFormatSupportedFn>(
+        alcGetProcAddress(nullptr, "alcIsRenderFormatSupportedSOFT"));
+    renderSamples = reinterpret_cast<RenderSamplesFn>(alcGetProcAddress(nullptr, "alcRenderSamplesSOFT"));
+    if (!openLoopback || !isFormatSupported || !renderSamples) {
+        std::cerr << "Failed to load ALC_SOFT_loopback functions" << std::endl;
+        return false;
+    }
+    
+    device = openLoopback(nullptr);
+    if (!device) {
+        std::cerr << "Failed to open loopback audio device" << std::endl;
+        return false;
+    }
+    
+    if (!isFormatSupported(device, OFFLINE_SAMPLE_RATE, ALC_STEREO_SOFT, ALC_SHORT_SOFT)) {
+        std::cerr << "Loopback device cannot render 16-bit stereo at " << OFFLINE_SAMPLE_RATE << " Hz" << std::endl;
+        alcCloseDevice(device);
+        device = nullptr;
+        return false;
+    }
+    
+    const ALCint attributes[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+        ALC_FREQUENCY, OFFLINE_SAMPLE_RATE,
+        0
+    };
+    return createContext(attributes);
+}
+
+void AudioEngine::createVoiceFilters() {
+    if (alcIsExtensionPresent(device, "ALC_EXT_EFX") != ALC_TRUE) {
+        std::cout << "ALC_EXT_EFX not available; occluded sounds will not be muffled" << std::endl;
+        return;
+    }
     
+    genFilters = reinterpret_cast<GenFiltersFn>(alGetProcAddress("alGenFilters"));
+    deleteFilters = reinterpret_cast<DeleteFiltersFn>(alGetProcAddress("alDeleteFilters"));
+    filteri = reinterpret_cast<FilteriFn>(alGetProcAddress("alFilteri"));
+    filterf = reinterpret_cast<FilterfFn>(alGetProcAddress("alFilterf"));
+    if (!genFilters || !deleteFilters || !filteri || !filterf) {
+        std::cerr << "Failed to load ALC_EXT_EFX functions" << std::endl;
+        genFilters = nullptr;
+        return;
+    }
+    
+    voiceFilters.assign(MAX_SOURCES, 0);
+    alGetError();
+    genFilters(MAX_SOURCES, voiceFilters.data());
+    if (alGetError() != AL_NO_ERROR) {
+        std::cerr << "Failed to create low-pass filters" << std::endl;
+        voiceFilters.clear();
+        return;
+    }
+    for (ALuint filter : voiceFilters) {
+        filteri(filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+    }
+}
+
+bool AudioEngine::createContext(const ALCint* attributes) {
     // Create context
-    context = alcCreateContext(device, nullptr);
+    context = alcCreateContext(device, attributes);
     if (!context) {
         std::cerr << "Failed to create audio context" << std::endl;
         alcCloseDevice(device);
@@ -38,68 +269,117 @@ bool AudioEngine::initialize() {
         device = nullptr;
         return false;
     }
-    
-    // Create sound sources
-    for (int i = 0; i < MAX_SOURCES; i++) {
-        ALuint source = createSource();
-        if (source != 0) {
-            sources.push_back(source);
-        }
-    }
-    
-    // Create music source
-    musicSource = createSource();
-    
-    // Set default listener orientation
-    ALfloat listenerOri[] = { 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f };
-    alListener3f(AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alListener3f(AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alListenerfv(AL_ORIENTATION, listenerOri);
-    
-    initialized = true;
-    std::cout << "AudioEngine initialized successfully" << std::endl;
     return true;
 }
 
+#else
+
+bool AudioEngine::openDevice() {
+    std::cerr << "Built without OpenAL; use a software or null audio backend" << std::endl;
+    return false;
+}
+
+bool AudioEngine::openLoopbackDevice() {
+    return openDevice();
+}
+
+void AudioEngine::createVoiceFilters() {}
+
+bool AudioEngine::createContext(const ALCint*) {
+    return false;
+}
+
+#endif
+
 void AudioEngine::cleanup() {
     if (!initialized) return;
     
     stopAllSounds();
     stopMusic();
+    for (auto& stream : music) {
+        stream.reset();
+    }
+    
+    // The audio thread drains everything queued so far before it exits, so
+    // every load has been handed over and every voice stopped
+    audioThreadQuit.store(true, std::memory_order_release);
+    if (audioThread.joinable()) {
+        audioThread.join();
+    } else {
+        runTick();
+    }
+    
+    // Jobs write into the pending entries, so let them finish first
+    for (auto& pending : pendingSounds) {
+        if (jobSystem) jobSystem->wait(pending->counter);
+    }
+    pendingSounds.clear();
     
-    // Delete sources
-    for (ALuint source : sources) {
-        alDeleteSources(1, &source);
+    for (auto& pair : musicPrefetches) {
+        if (jobSystem) jobSystem->wait(pair.second->counter);
+    }
+    for (auto& prefetch : retiredPrefetches) {
+        if (jobSystem) jobSystem->wait(prefetch->counter);
     }
-    sources.clear();
+    musicPrefetches.clear();
+    retiredPrefetches.clear();
     
-    if (musicSource != 0) {
-        alDeleteSources(1, &musicSource);
-        musicSource = 0;
+    const VoiceStats& stats = voices.getStats();
+    std::cout << "Audio voices: peak " << stats.peakActive << "/" << stats.total << ", " << stats.started
+              << " started, " << stats.stolen << " stolen, " << stats.dropped << " dropped" << std::endl;
+    if (commandStalls.load() > 0) {
+        std::cout << "Audio command queue was full " << commandStalls.load() << " times" << std::endl;
     }
     
-    // Delete buffers
-    for (auto& pair : soundBuffers) {
-        alDeleteBuffers(1, &pair.second);
+    // Delete sources, then the filters they were using
+    voices.release();
+    if (!voiceFilters.empty()) {
+        deleteFilters(static_cast<ALsizei>(voiceFilters.size()), voiceFilters.data());
+        voiceFilters.clear();
     }
-    soundBuffers.clear();
+    genFilters = nullptr;
     
-    // Cleanup context and device
+#ifdef ECHOES_HAVE_OPENAL
+    for (ALuint& source : musicSources) {
+        if (source != 0) {
+            alDeleteSources(1, &source);
+            source = 0;
+        }
+    }
+    
+    // Delete buffers, then the context and device
+    for (ALuint buffer : soundBuffers) {
+        if (buffer != 0 && usesOpenAL()) alDeleteBuffers(1, &buffer);
+    }
     if (context) {
         alcMakeContextCurrent(nullptr);
         alcDestroyContext(context);
         context = nullptr;
     }
-    
     if (device) {
         alcCloseDevice(device);
         device = nullptr;
     }
+#endif
+    renderSamples = nullptr;
+    
+    mixer.reset();
+    sink.reset();
+    mixBus.clear();
+    mixOutput.clear();
+    for (int i = 0; i < MAX_SOUNDS; i++) {
+        soundBuffers[i] = 0;
+        soundDurations[i] = 0.0f;
+        soundStates[i].store(SoundState::EMPTY);
+    }
+    soundNames.clear();
+    criticalSounds.clear();
     
     initialized = false;
 }
 
 ALuint AudioEngine::createSource() {
+#ifdef ECHOES_HAVE_OPENAL
     ALuint source;
     alGenSources(1, &source);
     
@@ -117,272 +397,1041 @@ ALuint AudioEngine::createSource() {
     alSourcei(source, AL_LOOPING, AL_FALSE);
     
     return source;
+#else
+    return 0;
+#endif
 }
 
-bool AudioEngine::loadWAVFile(const std::string& filename, ALuint& buffer) {
-    // Simple WAV file loader (supports basic PCM WAV files)
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open audio file: " << filename << std::endl;
-        return false;
+bool AudioEngine::decodeSoundFile(const std::string& filename, DecodedSound& sound, bool useFloat) {
+    // Sound effects always live fully in memory; music goes through MusicStream
+    if (isCompressedAudio(filename)) {
+        return decodeCompressedFile(filename, sound);
     }
+    return decodeWAVFile(filename, sound, useFloat);
+}
+
+bool AudioEngine::decodeCompressedFile(const std::string& filename, DecodedSound& sound) {
+    std::unique_ptr<AudioDecoder> decoder = openAudioDecoder(filename);
+    if (!decoder) return false;
     
-    // Read RIFF header
-    char riff[4];
-    file.read(riff, 4);
-    if (std::strncmp(riff, "RIFF", 4) != 0) {
-        std::cerr << "Invalid WAV file (no RIFF): " << filename << std::endl;
-        return false;
-    }
+    // Size the buffer from the stream length when known, so decoding is one pass
+    size_t frameBytes = decoder->getFrameBytes();
+    size_t expected = static_cast<size_t>(decoder->getTotalFrames()) * frameBytes;
+    sound.converted.resize(expected > 0 ? expected : 64 * 1024);
     
-    uint32_t fileSize;
-    file.read(reinterpret_cast<char*>(&fileSize), 4);
+    size_t filled = 0;
+    while (true) {
+        if (filled == sound.converted.size()) {
+            sound.converted.resize(sound.converted.size() * 2);
+        }
+        size_t got = decoder->read(sound.converted.data() + filled, sound.converted.size() - filled);
+        if (got == 0) break;
+        filled += got;
+    }
+    sound.converted.resize(filled);
+    sound.converted.shrink_to_fit();
     
-    char wave[4];
-    file.read(wave, 4);
-    if (std::strncmp(wave, "WAVE", 4) != 0) {
-        std::cerr << "Invalid WAV file (no WAVE): " << filename << std::endl;
+    sound.format = decoder->getFormat();
+    sound.sampleRate = decoder->getSampleRate();
+    sound.samples = sound.converted.data();
+    sound.sampleBytes = static_cast<ALsizei>(sound.converted.size());
+    return true;
+}
+
+bool AudioEngine::decodeWAVFile(const std::string& filename, DecodedSound& sound, bool useFloat) {
+    // Touches no OpenAL state, so it is safe to run on a worker thread
+    if (!sound.file.open(filename, MappedAccess::SEQUENTIAL)) {
+        std::cerr << "Failed to open audio file: " << filename << std::endl;
         return false;
     }
     
-    // Find fmt chunk
-    char fmt[4];
-    file.read(fmt, 4);
-    if (std::strncmp(fmt, "fmt ", 4) != 0) {
-        std::cerr << "Invalid WAV file (no fmt): " << filename << std::endl;
+    WavInfo wav;
+    std::string error;
+    if (!parseWav(sound.file.data(), sound.file.size(), wav, error)) {
+        std::cerr << "Invalid WAV file (" << error << "): " << filename << std::endl;
+        sound.file.close();
         return false;
     }
     
-    uint32_t fmtSize;
-    file.read(reinterpret_cast<char*>(&fmtSize), 4);
-    
-    uint16_t audioFormat;
-    file.read(reinterpret_cast<char*>(&audioFormat), 2);
-    
-    uint16_t numChannels;
-    file.read(reinterpret_cast<char*>(&numChannels), 2);
-    
-    uint32_t sampleRate;
-    file.read(reinterpret_cast<char*>(&sampleRate), 4);
+    // Samples used in place are first read by the upload on the audio
+    // thread; fault them in here so that thread never waits on the disk
+    sound.file.prefault(wav.samples, wav.sampleBytes);
     
-    uint32_t byteRate;
-    file.read(reinterpret_cast<char*>(&byteRate), 4);
+    bool stereo = wav.channels == 2;
+    sound.sampleRate = static_cast<ALsizei>(wav.sampleRate);
+    sound.samples = wav.samples;
+    sound.sampleBytes = static_cast<ALsizei>(wav.sampleBytes);
     
-    uint16_t blockAlign;
-    file.read(reinterpret_cast<char*>(&blockAlign), 2);
-    
-    uint16_t bitsPerSample;
-    file.read(reinterpret_cast<char*>(&bitsPerSample), 2);
-    
-    // Skip to data chunk
-    file.seekg(36, std::ios::beg);
-    
-    char data[4];
-    file.read(data, 4);
-    if (std::strncmp(data, "data", 4) != 0) {
-        std::cerr << "Invalid WAV file (no data): " << filename << std::endl;
-        return false;
+    switch (wav.encoding) {
+        case WavEncoding::PCM_U8:
+            sound.format = stereo ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
+            return true;
+        case WavEncoding::PCM_S16:
+            sound.format = stereo ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+            return true;
+        case WavEncoding::FLOAT32:
+            if (useFloat) {
+                sound.format = stereo ? AL_FORMAT_STEREO_FLOAT32 : AL_FORMAT_MONO_FLOAT32;
+                return true;
+            }
+            break;
+        case WavEncoding::PCM_S24:
+            break;
     }
     
-    uint32_t dataSize;
-    file.read(reinterpret_cast<char*>(&dataSize), 4);
-    
-    // Read audio data
-    std::vector<char> audioData(dataSize);
-    file.read(audioData.data(), dataSize);
-    file.close();
+    // OpenAL has no 24-bit format, and float needs the extension: convert to
+    // float when we can, 16-bit otherwise, then drop the mapping
+    size_t count = wav.sampleBytes / (wav.blockAlign / wav.channels);
+    const unsigned char* source = wav.samples;
     
-    // Determine OpenAL format
-    ALenum format;
-    if (numChannels == 1) {
-        format = (bitsPerSample == 8) ? AL_FORMAT_MONO8 : AL_FORMAT_MONO16;
+    if (useFloat) {
+        sound.converted.resize(count * sizeof(float));
+        float* out = reinterpret_cast<float*>(sound.converted.data());
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = sampleFromS24(source + i * 3);
+        }
+        sound.format = stereo ? AL_FORMAT_STEREO_FLOAT32 : AL_FORMAT_MONO_FLOAT32;
     } else {
-        format = (bitsPerSample == 8) ? AL_FORMAT_STEREO8 : AL_FORMAT_STEREO16;
+        sound.converted.resize(count * sizeof(int16_t));
+        int16_t* out = reinterpret_cast<int16_t*>(sound.converted.data());
+        for (size_t i = 0; i < count; ++i) {
+            if (wav.encoding == WavEncoding::PCM_S24) {
+                // Keep the top 16 bits
+                out[i] = static_cast<int16_t>(source[i * 3 + 1] | (source[i * 3 + 2] << 8));
+            } else {
+                float value;
+                std::memcpy(&value, source + i * 4, sizeof(float));
+                out[i] = floatToS16(value);
+            }
+        }
+        sound.format = stereo ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
     }
     
-    // Create OpenAL buffer
+    sound.samples = sound.converted.data();
+    sound.sampleBytes = static_cast<ALsizei>(sound.converted.size());
+    sound.file.close();
+    return true;
+}
+
+ALuint AudioEngine::uploadSound(const DecodedSound* sound, const std::string& filename) {
+#ifdef ECHOES_HAVE_OPENAL
+    ALuint buffer;
     alGenBuffers(1, &buffer);
-    alBufferData(buffer, format, audioData.data(), dataSize, sampleRate);
     
-    ALenum error = alGetError();
-    if (error != AL_NO_ERROR) {
+    if (sound) {
+        alBufferData(buffer, sound->format, sound->samples, sound->sampleBytes, sound->sampleRate);
+        
+        ALenum error = alGetError();
+        if (error == AL_NO_ERROR) {
+            return buffer;
+        }
         std::cerr << "Failed to load audio data: " << error << std::endl;
-        return false;
     }
     
-    return true;
+    // If WAV loading fails, use a small silent buffer as fallback
+    std::cerr << "Warning: Could not load " << filename << ", using silent buffer" << std::endl;
+    short silence[1024] = {0};
+    alBufferData(buffer, AL_FORMAT_MONO16, silence, sizeof(silence), 22050);
+    return buffer;
+#else
+    (void)sound;
+    (void)filename;
+    return 0;
+#endif
+}
+
+ALuint AudioEngine::uploadToMixer(const DecodedSound* sound, const std::string& filename) {
+    int channels = 0;
+    MixerSampleType type = MixerSampleType::S16;
+    if (sound && getMixerFormat(sound->format, channels, type)) {
+        int id = mixer->addSound(sound->samples, static_cast<size_t>(sound->sampleBytes), channels, type,
+                                 sound->sampleRate);
+        if (id > 0) return static_cast<ALuint>(id);
+    }
+    
+    // Same fallback as uploadSound: a short silent sound
+    std::cerr << "Warning: Could not load " << filename << ", using silent buffer" << std::endl;
+    short silence[1024] = {0};
+    return static_cast<ALuint>(mixer->addSound(silence, sizeof(silence), 1, MixerSampleType::S16, 22050));
+}
+
+SoundHandle AudioEngine::reserveSound(const std::string& name) {
+    uint32_t id = soundNames.intern(name);
+    if (id == StringInterner::INVALID_ID) return INVALID_SOUND;
+    
+    // The buffer table is fixed so the audio thread can index it while new
+    // names are added here
+    if (id >= static_cast<uint32_t>(MAX_SOUNDS)) {
+        std::cerr << "Too many sounds (max " << MAX_SOUNDS << "), cannot load: " << name << std::endl;
+        return INVALID_SOUND;
+    }
+    return static_cast<SoundHandle>(id);
+}
+
+bool AudioEngine::isLoading(SoundHandle handle) const {
+    return handle >= 0 && handle < MAX_SOUNDS && soundStates[handle].load() == SoundState::LOADING;
+}
+
+void AudioEngine::submitLoad(std::unique_ptr<PendingSound> pending) {
+    soundStates[pending->handle].store(SoundState::LOADING);
+    
+    Command command = {};
+    command.type = CommandType::LOAD;
+    command.sound = pending->handle;
+    command.pending = pending.release();
+    post(command);
 }
 
 bool AudioEngine::loadSound(const std::string& name, const std::string& filename) {
     if (!initialized) return false;
     
     // Check if already loaded
-    if (soundBuffers.find(name) != soundBuffers.end()) {
+    SoundHandle existing = getSoundHandle(name);
+    if (isSoundReady(existing) || isLoading(existing)) {
         std::cout << "Sound already loaded: " << name << std::endl;
         return true;
     }
     
-    ALuint buffer;
-    if (!loadWAVFile(filename, buffer)) {
-        // If WAV loading fails, create a silent buffer as fallback
-        std::cerr << "Warning: Could not load " << filename << ", using silent buffer" << std::endl;
+    SoundHandle handle = reserveSound(name);
+    if (handle == INVALID_SOUND) return false;
+    
+    auto pending = std::make_unique<PendingSound>();
+    pending->handle = handle;
+    pending->filename = filename;
+    pending->critical = true;
+    pending->decoded = decodeSoundFile(filename, pending->sound, floatFormats);
+    pending->discarded = false;
+    submitLoad(std::move(pending));
+    
+    // Callers expect the sound to be playable on return
+    waitWhileLoading(handle);
+    return true;
+}
+
+SoundHandle AudioEngine::loadSoundAsync(const std::string& name, const std::string& filename, bool critical) {
+    if (!initialized) return INVALID_SOUND;
+    
+    SoundHandle existing = getSoundHandle(name);
+    if (isSoundReady(existing) || isLoading(existing)) {
+        return existing;
+    }
+    
+    if (!jobSystem) {
+        loadSound(name, filename);
+        return getSoundHandle(name);
+    }
+    
+    SoundHandle handle = reserveSound(name);
+    if (handle == INVALID_SOUND) return INVALID_SOUND;
+    
+    auto pending = std::make_unique<PendingSound>();
+    pending->handle = handle;
+    pending->filename = filename;
+    pending->critical = critical;
+    pending->decoded = false;
+    pending->discarded = false;
+    
+    // The entry stays put in memory while the job runs; only the pointer
+    // moves, first to the job and then to the audio thread
+    PendingSound* job = pending.get();
+    bool useFloat = floatFormats;
+    jobSystem->submit([job, useFloat]() {
+        job->decoded = decodeSoundFile(job->filename, job->sound, useFloat);
+    }, &job->counter);
+    
+    if (critical) criticalSounds.push_back(handle);
+    submitLoad(std::move(pending));
+    return handle;
+}
+
+void AudioEngine::waitForCriticalSounds() {
+    // The audio thread owns the loads now; wait for it to upload them
+    for (SoundHandle handle : criticalSounds) {
+        waitWhileLoading(handle);
+    }
+    criticalSounds.clear();
+}
+
+void AudioEngine::waitWhileLoading(SoundHandle handle) {
+    while (isLoading(handle)) {
+        if (audioThread.joinable()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } else {
+            // Offline backend: nobody else will tick, so do it here
+            runTick();
+            std::this_thread::yield();
+        }
+    }
+}
+
+void AudioEngine::uploadFinishedSounds() {
+    for (auto& pending : pendingSounds) {
+        if (!pending->counter.isDone()) continue;
         
-        // Create a small silent buffer
-        alGenBuffers(1, &buffer);
-        short silence[1024] = {0};
-        alBufferData(buffer, AL_FORMAT_MONO16, silence, sizeof(silence), 22050);
+        if (!pending->discarded) {
+            SoundHandle handle = pending->handle;
+            if (mixer) {
+                if (soundBuffers[handle] != 0) mixer->removeSound(static_cast<int>(soundBuffers[handle]));
+                soundBuffers[handle] = uploadToMixer(pending->decoded ? &pending->sound : nullptr,
+                                                     pending->filename);
+                soundDurations[handle] = mixer->getSoundDuration(static_cast<int>(soundBuffers[handle]));
+            } else if (!usesOpenAL()) {
+                // Nothing to upload to; a placeholder id marks the slot loaded
+                soundBuffers[handle] = static_cast<ALuint>(handle) + 1;
+                soundDurations[handle] = pending->decoded ? getDecodedDuration(pending->sound) : 0.0f;
+            } else {
+#ifdef ECHOES_HAVE_OPENAL
+                if (soundBuffers[handle] != 0) alDeleteBuffers(1, &soundBuffers[handle]);
+#endif
+                soundBuffers[handle] = uploadSound(pending->decoded ? &pending->sound : nullptr,
+                                                   pending->filename);
+                soundDurations[handle] = getBufferDuration(soundBuffers[handle]);
+            }
+            soundStates[handle].store(SoundState::READY);
+            counters.uploads++;
+            std::cout << "Loaded sound: " << pending->filename << std::endl;
+        }
+        pending.reset();
     }
     
-    soundBuffers[name] = buffer;
-    std::cout << "Loaded sound: " << name << " from " << filename << std::endl;
-    return true;
+    pendingSounds.erase(std::remove(pendingSounds.begin(), pendingSounds.end(), nullptr),
+                        pendingSounds.end());
 }
 
 void AudioEngine::unloadSound(const std::string& name) {
-    auto it = soundBuffers.find(name);
-    if (it != soundBuffers.end()) {
-        alDeleteBuffers(1, &it->second);
-        soundBuffers.erase(it);
+    // The name keeps its handle, so a later reload reuses the same slot
+    SoundHandle handle = getSoundHandle(name);
+    if (handle == INVALID_SOUND) return;
+    
+    soundStates[handle].store(SoundState::EMPTY);
+    
+    Command command = {};
+    command.type = CommandType::UNLOAD;
+    command.sound = handle;
+    post(command);
+}
+
+void AudioEngine::discardSound(SoundHandle handle) {
+    // A buffer still attached to a source cannot be deleted
+    for (int i = 0; i < static_cast<int>(playbacks.size()); i++) {
+        if (playbacks[i].active && playbacks[i].sound == handle) finishPlayback(i);
+    }
+    if (soundBuffers[handle] != 0) {
+        if (mixer) mixer->removeSound(static_cast<int>(soundBuffers[handle]));
+#ifdef ECHOES_HAVE_OPENAL
+        if (usesOpenAL()) alDeleteBuffers(1, &soundBuffers[handle]);
+#endif
+        soundBuffers[handle] = 0;
     }
+    for (auto& pending : pendingSounds) {
+        if (pending->handle == handle) pending->discarded = true;
+    }
+    
+    // A reload may already have been requested; leave that marked as loading
+    SoundState ready = SoundState::READY;
+    soundStates[handle].compare_exchange_strong(ready, SoundState::EMPTY);
+}
+
+SoundHandle AudioEngine::getSoundHandle(const std::string& name) const {
+    uint32_t id = soundNames.find(name);
+    return id != StringInterner::INVALID_ID ? static_cast<SoundHandle>(id) : INVALID_SOUND;
+}
+
+SoundHandle AudioEngine::getSoundHandle(uint32_t nameHash) const {
+    uint32_t id = soundNames.findHash(nameHash);
+    return id != StringInterner::INVALID_ID ? static_cast<SoundHandle>(id) : INVALID_SOUND;
+}
+
+bool AudioEngine::isSoundReady(SoundHandle handle) const {
+    return handle >= 0 && handle < MAX_SOUNDS && soundStates[handle].load() == SoundState::READY;
+}
+
+float AudioEngine::getSoundDuration(SoundHandle handle) const {
+    // Written before the state goes READY, and left alone while it stays so
+    return isSoundReady(handle) ? soundDurations[handle] : 0.0f;
+}
+
+float AudioEngine::getBufferDuration(ALuint buffer) {
+#ifdef ECHOES_HAVE_OPENAL
+    // Queried once at load so playback never has to ask the driver
+    ALint size = 0, bits = 0, channels = 0, frequency = 0;
+    alGetBufferi(buffer, AL_SIZE, &size);
+    alGetBufferi(buffer, AL_BITS, &bits);
+    alGetBufferi(buffer, AL_CHANNELS, &channels);
+    alGetBufferi(buffer, AL_FREQUENCY, &frequency);
+    
+    int frameBytes = channels * bits / 8;
+    if (frameBytes <= 0 || frequency <= 0) return 0.0f;
+    return static_cast<float>(size / frameBytes) / static_cast<float>(frequency);
+#else
+    (void)buffer;
+    return 0.0f;
+#endif
+}
+
+float AudioEngine::getDecodedDuration(const DecodedSound& sound) {
+    int frameBytes = getFormatFrameBytes(sound.format);
+    if (frameBytes <= 0 || sound.sampleRate <= 0) return 0.0f;
+    return static_cast<float>(sound.sampleBytes / frameBytes) / static_cast<float>(sound.sampleRate);
 }
 
-ALuint AudioEngine::getAvailableSource() {
-    for (ALuint source : sources) {
-        ALint state;
-        alGetSourcei(source, AL_SOURCE_STATE, &state);
-        if (state != AL_PLAYING) {
-            return source;
+void AudioEngine::post(const Command& command) {
+    // The queue only fills if the audio thread stalls; wait rather than drop
+    // the command, since a lost stop or unload would never be retried
+    if (commands->push(command)) return;
+    commandStalls.fetch_add(1, std::memory_order_relaxed);
+    while (!commands->push(command)) {
+        std::this_thread::yield();
+    }
+}
+
+void AudioEngine::audioThreadLoop() {
+    for (;;) {
+        // Read the flag first so commands queued before cleanup() set it are
+        // still applied by the final pass
+        bool quit = audioThreadQuit.load(std::memory_order_acquire);
+        
+        runTick();
+        if (sink) {
+            // The write blocks until the device wants more, so no sleep
+            mixSoftware(mixOutput.data(), MIX_PERIOD_FRAMES);
+            sink->write(mixOutput.data(), MIX_PERIOD_FRAMES);
         }
+        publishState();
+        
+        if (quit) break;
+        if (!sink) std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_TICK_MS));
     }
-    return 0; // No available source
 }
 
-void AudioEngine::playSound(const std::string& name, float volume, float pitch, bool loop) {
-    if (!initialized) return;
+void AudioEngine::runTick() {
+    processCommands();
+    uploadFinishedSounds();
+    updatePlaybacks();
+    voices.update();
+    counters.ticks++;
+}
+
+void AudioEngine::publishState() {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        publishedStats = voices.getStats();
+        publishedCounters = counters;
+    }
+    virtualVoiceCount.store(countVirtualVoices(), std::memory_order_relaxed);
+}
+
+bool AudioEngine::render(int16_t* out, int frames) {
+    if (!initialized || backend == AudioBackend::OPENAL) return false;
     
-    auto it = soundBuffers.find(name);
-    if (it == soundBuffers.end()) {
-        std::cerr << "Sound not found: " << name << std::endl;
+    runTick();
+    if (backend == AudioBackend::OPENAL_LOOPBACK) {
+        renderSamples(device, out, frames);
+        voices.advanceClock(static_cast<double>(frames) / OFFLINE_SAMPLE_RATE);
+        counters.framesRendered += static_cast<uint64_t>(frames);
+    } else if (mixer) {
+        mixSoftware(out, frames);
+    } else {
+        std::fill(out, out + static_cast<size_t>(frames) * 2, static_cast<int16_t>(0));
+        voices.advanceClock(static_cast<double>(frames) / OFFLINE_SAMPLE_RATE);
+        counters.framesRendered += static_cast<uint64_t>(frames);
+    }
+    publishState();
+    return true;
+}
+
+void AudioEngine::mixSoftware(int16_t* out, int frames) {
+    size_t samples = static_cast<size_t>(frames) * 2;
+    if (mixBus.size() < samples) mixBus.resize(samples);
+    
+    mixer->mix(mixBus.data(), frames);
+    convertBusToS16(mixBus.data(), out, static_cast<int>(samples));
+    
+    // Time moves by what was mixed, not by the wall clock
+    voices.advanceClock(static_cast<double>(frames) / OFFLINE_SAMPLE_RATE);
+    counters.framesRendered += static_cast<uint64_t>(frames);
+}
+
+void AudioEngine::stopVoice(int voice) {
+    voices.stop(voice);
+    if (mixer) mixer->stop(voice);
+}
+
+void AudioEngine::processCommands() {
+    // Bounded so a producer flooding the queue cannot keep the tick going
+    Command command;
+    for (size_t i = 0; i < COMMAND_CAPACITY && commands->pop(command); i++) {
+        execute(command);
+        counters.commands++;
+    }
+    
+    // However many listener updates arrived, OpenAL hears about them once
+    if (listenerDirty) {
+        applyListener();
+        listenerDirty = false;
+        counters.listenerUpdates++;
+    }
+}
+
+void AudioEngine::execute(const Command& command) {
+    switch (command.type) {
+    case CommandType::PLAY:
+        startPlayback(command);
+        break;
+    case CommandType::STOP_PLAYBACK: {
+        int index = findPlayback(command.playback);
+        if (index >= 0) finishPlayback(index);
+        break;
+    }
+    case CommandType::SET_PLAYBACK_POSITION: {
+        int index = findPlayback(command.playback);
+        if (index < 0) break;
+        
+        Playback& playback = playbacks[index];
+        playback.x = command.values[0];
+        playback.y = command.values[1];
+        playback.z = command.values[2];
+        if (playback.voice >= 0 && mixer) {
+            mixer->setVoicePosition(playback.voice, playback.x, playback.y, playback.z);
+        }
+#ifdef ECHOES_HAVE_OPENAL
+        else if (playback.voice >= 0 && usesOpenAL()) {
+            alSource3f(voices.getSource(playback.voice), AL_POSITION, playback.x, playback.y, playback.z);
+        }
+#endif
+        break;
+    }
+    case CommandType::SET_PLAYBACK_OCCLUSION: {
+        int index = findPlayback(command.playback);
+        if (index < 0) break;
+        
+        playbacks[index].occlusion = command.values[0];
+        playbacks[index].gainHF = command.values[1];
+        applyVoiceGain(playbacks[index]);
+        break;
+    }
+    case CommandType::STOP_SOUND:
+        for (int i = 0; i < static_cast<int>(playbacks.size()); i++) {
+            if (playbacks[i].active && playbacks[i].sound == command.sound) finishPlayback(i);
+        }
+        break;
+    case CommandType::STOP_ALL:
+        for (int i = 0; i < static_cast<int>(playbacks.size()); i++) {
+            if (playbacks[i].active) finishPlayback(i);
+        }
+        voices.stopAll();
+        if (mixer) mixer->stopAll();
+        break;
+    case CommandType::LOAD:
+        pendingSounds.emplace_back(command.pending);
+        break;
+    case CommandType::UNLOAD:
+        discardSound(command.sound);
+        break;
+    case CommandType::SET_LISTENER_POSITION:
+        listenerX = command.values[0];
+        listenerY = command.values[1];
+        listenerZ = command.values[2];
+        listenerDirty = true;
+        break;
+    case CommandType::SET_LISTENER_ORIENTATION:
+        std::copy(command.values, command.values + 6, listenerOrientation);
+        listenerDirty = true;
+        break;
+    case CommandType::SET_LISTENER_VELOCITY:
+        std::copy(command.values, command.values + 3, listenerVelocity);
+        listenerDirty = true;
+        break;
+    case CommandType::SET_SFX_VOLUME:
+        sfxGain = command.volume;
+        break;
+    }
+}
+
+void AudioEngine::applyListener() {
+    if (mixer) {
+        mixer->setListener(listenerX, listenerY, listenerZ, listenerOrientation);
         return;
     }
+    if (!usesOpenAL()) return;
     
-    ALuint source = getAvailableSource();
-    if (source == 0) {
-        std::cerr << "No available audio source" << std::endl;
+#ifdef ECHOES_HAVE_OPENAL
+    alListener3f(AL_POSITION, listenerX, listenerY, listenerZ);
+    alListenerfv(AL_ORIENTATION, listenerOrientation);
+    alListenerfv(AL_VELOCITY, listenerVelocity);
+#endif
+}
+
+float AudioEngine::getAudibility(const Playback& playback) const {
+    float gain = playback.volume * playback.occlusion * sfxGain;
+    if (playback.relative) return gain;
+    
+    // Inverse distance, matching OpenAL's default model with reference distance 1
+    float dx = playback.x - listenerX, dy = playback.y - listenerY, dz = playback.z - listenerZ;
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    return gain / std::max(distance, 1.0f);
+}
+
+PlaybackId AudioEngine::queuePlayback(SoundHandle handle, float x, float y, float z, bool relative, float volume,
+                                      float pitch, bool loop, VoicePriority priority, float occlusion,
+                                      float gainHF) {
+    if (!initialized || !isSoundReady(handle)) return INVALID_PLAYBACK;
+    
+    // Ids are handed out here so the caller has one before the audio thread
+    // even sees the request
+    PlaybackId id = nextPlaybackId.fetch_add(1, std::memory_order_relaxed);
+    if (id == INVALID_PLAYBACK) id = nextPlaybackId.fetch_add(1, std::memory_order_relaxed);
+    
+    Command command = {};
+    command.type = CommandType::PLAY;
+    command.playback = id;
+    command.sound = handle;
+    command.values[0] = x;
+    command.values[1] = y;
+    command.values[2] = z;
+    command.values[3] = occlusion;
+    command.values[4] = gainHF;
+    command.relative = relative;
+    command.volume = volume;
+    command.pitch = pitch;
+    command.loop = loop;
+    command.priority = priority;
+    post(command);
+    return id;
+}
+
+void AudioEngine::startPlayback(const Command& command) {
+    // Unloaded since the request was made
+    if (soundBuffers[command.sound] == 0) return;
+    
+    int index;
+    if (!freePlaybacks.empty()) {
+        index = freePlaybacks.back();
+        freePlaybacks.pop_back();
+    } else if (static_cast<int>(playbacks.size()) < MAX_PLAYBACKS) {
+        index = static_cast<int>(playbacks.size());
+        playbacks.push_back(Playback());
+    } else {
         return;
     }
     
-    alSourcei(source, AL_BUFFER, it->second);
-    alSourcef(source, AL_GAIN, volume * sfxVolume);
-    alSourcef(source, AL_PITCH, pitch);
-    alSourcei(source, AL_LOOPING, loop ? AL_TRUE : AL_FALSE);
+    Playback& playback = playbacks[index];
+    playback.id = command.playback;
+    playback.sound = command.sound;
+    playback.x = command.values[0];
+    playback.y = command.values[1];
+    playback.z = command.values[2];
+    playback.relative = command.relative;
+    playback.volume = command.volume;
+    playback.pitch = command.pitch > 0.0f ? command.pitch : 1.0f;
+    playback.looping = command.loop;
+    playback.occlusion = command.values[3];
+    playback.gainHF = command.values[4];
+    playback.priority = command.priority;
+    playback.startTime = voices.now();
+    playback.active = true;
+    playback.voice = -1;
+    
+    // Inaudible sounds start virtual and never touch the mixer
+    if (getAudibility(playback) >= AUDIBILITY_THRESHOLD) {
+        promote(index);
+    }
+}
+
+int AudioEngine::findPlayback(PlaybackId id) const {
+    if (id == INVALID_PLAYBACK) return -1;
+    for (int i = 0; i < static_cast<int>(playbacks.size()); i++) {
+        if (playbacks[i].active && playbacks[i].id == id) return i;
+    }
+    return -1;
+}
+
+bool AudioEngine::promote(int index) {
+    Playback& playback = playbacks[index];
+    
+    float length = soundDurations[playback.sound];
+    float elapsed = static_cast<float>(voices.now() - playback.startTime) * playback.pitch;
+    float offset = playback.looping && length > 0.0f ? std::fmod(elapsed, length) : elapsed;
+    float remaining = (length - offset) / playback.pitch;
+    
+    uint32_t evicted = VoicePool::NO_OWNER;
+    int voice = voices.acquire(playback.priority, getAudibility(playback), remaining, playback.looping,
+                               playback.id, &evicted);
+    if (voice < 0) return false;
+    
+    // Whoever lost the voice carries on virtually
+    if (evicted != VoicePool::NO_OWNER) {
+        int loser = findPlayback(evicted);
+        if (loser >= 0) playbacks[loser].voice = -1;
+    }
+    playback.voice = voice;
+    counters.promotions++;
+    
+    if (mixer) {
+        MixerVoiceParams params;
+        params.x = playback.x;
+        params.y = playback.y;
+        params.z = playback.z;
+        params.relative = playback.relative;
+        params.gain = playback.volume * playback.occlusion * sfxGain;
+        params.gainHF = playback.gainHF;
+        params.pitch = playback.pitch;
+        params.looping = playback.looping;
+        mixer->play(voice, static_cast<int>(soundBuffers[playback.sound]), offset, params);
+        return true;
+    }
+    if (!usesOpenAL()) return true;
+    
+#ifdef ECHOES_HAVE_OPENAL
+    ALuint source = voices.getSource(voice);
+    alSourcei(source, AL_BUFFER, soundBuffers[playback.sound]);
+    alSourcei(source, AL_SOURCE_RELATIVE, playback.relative ? AL_TRUE : AL_FALSE);
+    alSource3f(source, AL_POSITION, playback.x, playback.y, playback.z);
+    applyVoiceGain(playback);
+    alSourcef(source, AL_PITCH, playback.pitch);
+    alSourcei(source, AL_LOOPING, playback.looping ? AL_TRUE : AL_FALSE);
+    if (offset > 0.0f) {
+        // Pick up where the virtual voice would be by now
+        alSourcef(source, AL_SEC_OFFSET, offset);
+    }
     alSourcePlay(source);
+#endif
+    return true;
 }
 
-void AudioEngine::playSound3D(const std::string& name, float x, float y, float z, float volume) {
-    if (!initialized) return;
+void AudioEngine::applyVoiceGain(const Playback& playback) {
+    if (playback.voice < 0) return;
     
-    auto it = soundBuffers.find(name);
-    if (it == soundBuffers.end()) {
-        std::cerr << "Sound not found: " << name << std::endl;
+    float gain = playback.volume * playback.occlusion * sfxGain;
+    if (mixer) {
+        mixer->setVoiceGain(playback.voice, gain, playback.gainHF);
         return;
     }
+    if (!usesOpenAL()) return;
     
-    ALuint source = getAvailableSource();
-    if (source == 0) {
-        std::cerr << "No available audio source" << std::endl;
-        return;
+#ifdef ECHOES_HAVE_OPENAL
+    ALuint source = voices.getSource(playback.voice);
+    alSourcef(source, AL_GAIN, gain);
+    if (voiceFilters.empty()) return;
+    
+    // Sources copy filter settings when attached, so attach after setting
+    if (playback.gainHF < 1.0f) {
+        ALuint filter = voiceFilters[playback.voice];
+        filterf(filter, AL_LOWPASS_GAIN, 1.0f);
+        filterf(filter, AL_LOWPASS_GAINHF, std::max(playback.gainHF, 0.0f));
+        alSourcei(source, AL_DIRECT_FILTER, static_cast<ALint>(filter));
+    } else {
+        alSourcei(source, AL_DIRECT_FILTER, AL_FILTER_NULL);
     }
+#endif
+}
+
+void AudioEngine::demote(int index) {
+    Playback& playback = playbacks[index];
+    if (playback.voice < 0) return;
+    stopVoice(playback.voice);
+    playback.voice = -1;
+    counters.demotions++;
+}
+
+void AudioEngine::finishPlayback(int index) {
+    Playback& playback = playbacks[index];
+    if (playback.voice >= 0) stopVoice(playback.voice);
+    playback.voice = -1;
+    playback.active = false;
+    freePlaybacks.push_back(index);
+}
+
+void AudioEngine::updatePlaybacks() {
+    double time = voices.now();
     
-    alSourcei(source, AL_BUFFER, it->second);
-    alSource3f(source, AL_POSITION, x, y, z);
-    alSourcef(source, AL_GAIN, volume * sfxVolume);
-    alSourcei(source, AL_LOOPING, AL_FALSE);
-    alSourcePlay(source);
+    for (int i = 0; i < static_cast<int>(playbacks.size()); i++) {
+        Playback& playback = playbacks[i];
+        if (!playback.active) continue;
+        
+        float length = soundDurations[playback.sound];
+        if (!playback.looping && (time - playback.startTime) * playback.pitch >= length) {
+            finishPlayback(i);
+            continue;
+        }
+        
+        float audibility = getAudibility(playback);
+        if (playback.voice >= 0) {
+            if (audibility < AUDIBILITY_THRESHOLD * 0.5f) {
+                demote(i);
+            } else {
+                voices.setAudibility(playback.voice, audibility);
+            }
+        } else if (audibility >= AUDIBILITY_THRESHOLD && voices.wouldAccept(playback.priority, audibility)) {
+            promote(i);
+        }
+    }
+}
+
+int AudioEngine::countVirtualVoices() const {
+    int count = 0;
+    for (const Playback& playback : playbacks) {
+        if (playback.active && playback.voice < 0) count++;
+    }
+    return count;
+}
+
+PlaybackId AudioEngine::playSound(SoundHandle handle, float volume, float pitch, bool loop, VoicePriority priority) {
+    // Listener-relative at the origin, so it plays unattenuated
+    return queuePlayback(handle, 0.0f, 0.0f, 0.0f, true, volume, pitch, loop, priority);
+}
+
+PlaybackId AudioEngine::playSound(const std::string& name, float volume, float pitch, bool loop,
+                                  VoicePriority priority) {
+    if (!initialized) return INVALID_PLAYBACK;
+    
+    SoundHandle handle = getSoundHandle(name);
+    if (handle == INVALID_SOUND) {
+        std::cerr << "Sound not found: " << name << std::endl;
+        return INVALID_PLAYBACK;
+    }
+    return playSound(handle, volume, pitch, loop, priority);
+}
+
+PlaybackId AudioEngine::playSound3D(SoundHandle handle, float x, float y, float z, float volume,
+                                    VoicePriority priority, bool loop) {
+    return queuePlayback(handle, x, y, z, false, volume, 1.0f, loop, priority);
+}
+
+PlaybackId AudioEngine::playSound3D(const std::string& name, float x, float y, float z, float volume,
+                                    VoicePriority priority, bool loop) {
+    if (!initialized) return INVALID_PLAYBACK;
+    
+    SoundHandle handle = getSoundHandle(name);
+    if (handle == INVALID_SOUND) {
+        std::cerr << "Sound not found: " << name << std::endl;
+        return INVALID_PLAYBACK;
+    }
+    return playSound3D(handle, x, y, z, volume, priority, loop);
+}
+
+PlaybackId AudioEngine::playSoundOccluded(SoundHandle handle, float x, float y, float z, float volume,
+                                          float occlusion, float gainHF, VoicePriority priority, bool loop,
+                                          float pitch) {
+    return queuePlayback(handle, x, y, z, false, volume, pitch, loop, priority, occlusion, gainHF);
+}
+
+void AudioEngine::stopPlayback(PlaybackId id) {
+    if (!initialized || id == INVALID_PLAYBACK) return;
+    
+    Command command = {};
+    command.type = CommandType::STOP_PLAYBACK;
+    command.playback = id;
+    post(command);
+}
+
+void AudioEngine::setPlaybackPosition(PlaybackId id, float x, float y, float z) {
+    if (!initialized || id == INVALID_PLAYBACK) return;
+    
+    Command command = {};
+    command.type = CommandType::SET_PLAYBACK_POSITION;
+    command.playback = id;
+    command.values[0] = x;
+    command.values[1] = y;
+    command.values[2] = z;
+    post(command);
+}
+
+void AudioEngine::setPlaybackOcclusion(PlaybackId id, float gain, float gainHF) {
+    if (!initialized || id == INVALID_PLAYBACK) return;
+    
+    Command command = {};
+    command.type = CommandType::SET_PLAYBACK_OCCLUSION;
+    command.playback = id;
+    command.values[0] = gain;
+    command.values[1] = gainHF;
+    post(command);
+}
+
+void AudioEngine::stopSound(const std::string& name) {
+    SoundHandle handle = getSoundHandle(name);
+    if (!initialized || handle == INVALID_SOUND) return;
+    
+    Command command = {};
+    command.type = CommandType::STOP_SOUND;
+    command.sound = handle;
+    post(command);
 }
 
 void AudioEngine::stopAllSounds() {
-    for (ALuint source : sources) {
-        alSourceStop(source);
+    if (!initialized) return;
+    
+    Command command = {};
+    command.type = CommandType::STOP_ALL;
+    post(command);
+}
+
+VoiceStats AudioEngine::getVoiceStats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return publishedStats;
+}
+
+AudioCounters AudioEngine::getAudioCounters() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return publishedCounters;
+}
+
+std::shared_ptr<const MusicHead> AudioEngine::findMusicHead(const std::string& filename) const {
+    auto it = musicPrefetches.find(filename);
+    if (it == musicPrefetches.end() || !it->second->counter.isDone() || !it->second->loaded) {
+        return nullptr;
     }
+    return it->second->head;
 }
 
 void AudioEngine::playMusic(const std::string& filename, float volume, bool loop) {
-    if (!initialized) return;
+    if (!initialized || !music[activeMusic]) return;
     
-    stopMusic();
+    // Opening and decoding happen on the stream thread, so switching
+    // tracks never stalls the caller
+    for (int i = 0; i < MUSIC_STREAMS; i++) {
+        if (i != activeMusic && music[i]) music[i]->stop();
+    }
+    music[activeMusic]->play(filename, volume, loop, findMusicHead(filename));
     
-    ALuint buffer;
-    if (!loadWAVFile(filename, buffer)) {
-        std::cerr << "Failed to load music: " << filename << std::endl;
+    musicPlaying = true;
+    musicVolume = volume;
+}
+
+void AudioEngine::crossfadeMusic(const std::string& filename, float volume, float seconds, bool loop) {
+    if (!initialized) return;
+    
+    int next = (activeMusic + 1) % MUSIC_STREAMS;
+    if (!music[next] || !musicPlaying) {
+        playMusic(filename, volume, loop);
         return;
     }
     
-    currentMusicBuffer = buffer;
-    alSourcei(musicSource, AL_BUFFER, currentMusicBuffer);
-    alSourcef(musicSource, AL_GAIN, volume);
-    alSourcei(musicSource, AL_LOOPING, loop ? AL_TRUE : AL_FALSE);
-    alSourcePlay(musicSource);
+    // The incoming track starts silent on the idle stream and ramps up while
+    // the outgoing one ramps down and stops itself
+    music[next]->play(filename, 0.0f, loop, findMusicHead(filename));
+    music[next]->fadeTo(volume, seconds, false);
+    music[activeMusic]->fadeTo(0.0f, seconds, true);
+    activeMusic = next;
     
     musicPlaying = true;
     musicVolume = volume;
 }
 
 void AudioEngine::stopMusic() {
-    if (musicSource != 0) {
-        alSourceStop(musicSource);
-        musicPlaying = false;
-    }
-    
-    if (currentMusicBuffer != 0) {
-        alDeleteBuffers(1, &currentMusicBuffer);
-        currentMusicBuffer = 0;
+    for (auto& stream : music) {
+        if (stream) stream->stop();
     }
+    musicPlaying = false;
 }
 
 void AudioEngine::pauseMusic() {
-    if (musicSource != 0 && musicPlaying) {
-        alSourcePause(musicSource);
+    if (!musicPlaying) return;
+    for (auto& stream : music) {
+        if (stream) stream->pause();
     }
 }
 
 void AudioEngine::resumeMusic() {
-    if (musicSource != 0 && musicPlaying) {
-        alSourcePlay(musicSource);
+    if (!musicPlaying) return;
+    for (auto& stream : music) {
+        if (stream) stream->resume();
     }
 }
 
 void AudioEngine::setMusicVolume(float volume) {
     musicVolume = volume;
-    if (musicSource != 0) {
-        alSourcef(musicSource, AL_GAIN, volume);
+    if (music[activeMusic]) {
+        music[activeMusic]->setVolume(volume);
     }
 }
 
+void AudioEngine::prefetchMusic(const std::string& filename) {
+    if (!initialized || musicPrefetches.find(filename) != musicPrefetches.end()) return;
+    
+    auto prefetch = std::make_unique<MusicPrefetch>();
+    prefetch->head = std::make_shared<MusicHead>();
+    prefetch->loaded = false;
+    
+    MusicPrefetch* job = prefetch.get();
+    if (jobSystem) {
+        jobSystem->submit([job, filename]() {
+            job->loaded = MusicStream::readHead(filename, *job->head);
+        }, &job->counter);
+    } else {
+        job->loaded = MusicStream::readHead(filename, *job->head);
+    }
+    
+    musicPrefetches[filename] = std::move(prefetch);
+}
+
+void AudioEngine::releaseMusicPrefetch(const std::string& filename) {
+    auto it = musicPrefetches.find(filename);
+    if (it == musicPrefetches.end()) return;
+    
+    // A job may still be writing into it; keep it alive until it is done.
+    // Streams already playing from the head hold their own reference.
+    if (!it->second->counter.isDone()) {
+        retiredPrefetches.push_back(std::move(it->second));
+    }
+    musicPrefetches.erase(it);
+}
+
 void AudioEngine::setListenerPosition(float x, float y, float z) {
-    alListener3f(AL_POSITION, x, y, z);
+    if (!initialized) return;
+    
+    Command command = {};
+    command.type = CommandType::SET_LISTENER_POSITION;
+    command.values[0] = x;
+    command.values[1] = y;
+    command.values[2] = z;
+    post(command);
 }
 
 void AudioEngine::setListenerOrientation(float atX, float atY, float atZ, float upX, float upY, float upZ) {
-    ALfloat ori[] = { atX, atY, atZ, upX, upY, upZ };
-    alListenerfv(AL_ORIENTATION, ori);
+    if (!initialized) return;
+    
+    Command command = {};
+    command.type = CommandType::SET_LISTENER_ORIENTATION;
+    command.values[0] = atX;
+    command.values[1] = atY;
+    command.values[2] = atZ;
+    command.values[3] = upX;
+    command.values[4] = upY;
+    command.values[5] = upZ;
+    post(command);
 }
 
 void AudioEngine::setListenerVelocity(float x, float y, float z) {
-    alListener3f(AL_VELOCITY, x, y, z);
+    if (!initialized) return;
+    
+    Command command = {};
+    command.type = CommandType::SET_LISTENER_VELOCITY;
+    command.values[0] = x;
+    command.values[1] = y;
+    command.values[2] = z;
+    post(command);
 }
 
 void AudioEngine::setSFXVolume(float volume) {
     sfxVolume = volume;
+    if (!initialized) return;
+    
+    Command command = {};
+    command.type = CommandType::SET_SFX_VOLUME;
+    command.volume = volume;
+    post(command);
 }
 
 void AudioEngine::update() {
-    // Check if music finished and should loop
-    if (musicPlaying && musicSource != 0) {
-        ALint state;
-        alGetSourcei(musicSource, AL_SOURCE_STATE, &state);
-        if (state != AL_PLAYING) {
-            musicPlaying = false;
-        }
+    retiredPrefetches.erase(std::remove_if(retiredPrefetches.begin(), retiredPrefetches.end(),
+                                           [](const std::unique_ptr<MusicPrefetch>& prefetch) {
+                                               return prefetch->counter.isDone();
+                                           }),
+                            retiredPrefetches.end());
+    
+    // Check if a non-looping track finished (or failed to open)
+    if (musicPlaying && music[activeMusic] && !music[activeMusic]->isPlaying()) {
+        musicPlaying = false;
     }
 }
@@ -1,63 +1,371 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
-#include <AL/al.h>
-#include <AL/alc.h>
+#include "AudioConfig.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "VoicePool.h"
+#include "StringInterner.h"
+#include "MusicStream.h"
+#include "MPSCQueue.h"
+#include "SoftwareMixer.h"
+#include "AudioSink.h"
 
-// Audio engine using OpenAL for 3D spatial audio
+// Index of a loaded sound, interned from its name. Handles are valid as soon
+// as they are returned, even while the sound is still loading, and index the
+// engine's buffer arrays directly.
+using SoundHandle = int;
+const SoundHandle INVALID_SOUND = -1;
+
+// One playing instance of a sound, for moving or stopping it later
+using PlaybackId = uint32_t;
+const PlaybackId INVALID_PLAYBACK = 0;
+
+// Who mixes and where the result goes. OPENAL plays through the default
+// device. SOFTWARE mixes with the in-house SoftwareMixer and plays through
+// PulseAudio or ALSA, so no OpenAL device is needed. OPENAL_LOOPBACK (OpenAL
+// Soft's ALC_SOFT_loopback) and SOFTWARE_LOOPBACK mix into memory, and
+// NULL_OUTPUT mixes nothing, only counting what would have happened. These
+// three offline backends run no audio thread and no clock of their own: the
+// caller drives them with render(), as fast as it likes.
+enum class AudioBackend {
+    OPENAL,
+    OPENAL_LOOPBACK,
+    SOFTWARE,
+    SOFTWARE_LOOPBACK,
+    NULL_OUTPUT
+};
+
+// Audio thread activity, for tests and benchmarks
+struct AudioCounters {
+    uint64_t ticks;
+    uint64_t commands;
+    uint64_t uploads;
+    uint64_t promotions;        // voices given a source, including first starts
+    uint64_t demotions;         // voices that went virtual
+    uint64_t listenerUpdates;
+    uint64_t framesRendered;    // offline and software backends
+};
+
+// Audio engine using OpenAL for 3D spatial audio. OpenAL is driven from a
+// dedicated audio thread: the public API records small commands in a
+// lock-free queue and returns at once, and the audio thread applies them in
+// batches every AUDIO_TICK_MS. Music streams run on their own threads.
+//
+// Threading: the SoundHandle overloads of playSound/playSound3D and the
+// playback, listener and volume setters may be called from any thread once
+// initialize() has returned. Loading, name lookups, music and
+// initialize/cleanup/update belong to the game thread.
 class AudioEngine {
 private:
     ALCdevice* device;
     ALCcontext* context;
+    AudioBackend backend;
+    
+    // From ALC_SOFT_loopback, looked up at runtime
+    using RenderSamplesFn = void (*)(ALCdevice*, ALCvoid*, ALCsizei);
+    RenderSamplesFn renderSamples;
+    
+    // From ALC_EXT_EFX, for muffling occluded sounds. Each voice has its own
+    // low-pass filter; without EFX occlusion only attenuates.
+    using GenFiltersFn = void (*)(ALsizei, ALuint*);
+    using DeleteFiltersFn = void (*)(ALsizei, const ALuint*);
+    using FilteriFn = void (*)(ALuint, ALenum, ALint);
+    using FilterfFn = void (*)(ALuint, ALenum, ALfloat);
+    GenFiltersFn genFilters;
+    DeleteFiltersFn deleteFilters;
+    FilteriFn filteri;
+    FilterfFn filterf;
+    std::vector<ALuint> voiceFilters;
     
-    // Sound buffers
-    std::map<std::string, ALuint> soundBuffers;
+    // Software backends. Mixer voices map one to one onto the voice pool and
+    // mixer sound ids stand in for buffer names. The audio thread mixes
+    // MIX_PERIOD_FRAMES at a time and the sink's blocking write paces it.
+    std::unique_ptr<SoftwareMixer> mixer;
+    std::unique_ptr<AudioSink> sink;
+    std::vector<float> mixBus;
+    std::vector<int16_t> mixOutput;
+    const int MIX_PERIOD_FRAMES = 256;
+    MixerResampler mixerResampler;
+    
+    // Sound buffers and their lengths in seconds, indexed by handle and owned
+    // by the audio thread. A buffer of 0 means not loaded yet. The state is
+    // published so any thread can ask whether a sound is ready.
+    static const int MAX_SOUNDS = 256;
+    enum class SoundState : uint8_t {
+        EMPTY,
+        LOADING,
+        READY
+    };
+    ALuint soundBuffers[MAX_SOUNDS];
+    float soundDurations[MAX_SOUNDS];
+    std::atomic<SoundState> soundStates[MAX_SOUNDS];
+    StringInterner soundNames;             // interned id == handle; game thread
+    
+    // Sample data prepared off the audio thread. For WAV, `samples` usually
+    // points straight into the mapped file; compressed files and formats
+    // OpenAL cannot take as-is are decoded into `converted`.
+    struct DecodedSound {
+        ALenum format;
+        ALsizei sampleRate;
+        MappedFile file;
+        const void* samples;
+        ALsizei sampleBytes;
+        std::vector<char> converted;
+    };
+    
+    // A load in flight, handed to the audio thread which uploads it once its
+    // decode job finishes
+    struct PendingSound {
+        SoundHandle handle;
+        std::string filename;
+        bool critical;
+        bool decoded;
+        bool discarded;
+        DecodedSound sound;
+        JobCounter counter;
+    };
+    std::vector<std::unique_ptr<PendingSound>> pendingSounds;     // audio thread
+    std::vector<SoundHandle> criticalSounds;                       // game thread
+    
+    // Track openings read ahead on the job system, keyed by filename
+    struct MusicPrefetch {
+        std::shared_ptr<MusicHead> head;
+        bool loaded;
+        JobCounter counter;
+    };
+    std::map<std::string, std::unique_ptr<MusicPrefetch>> musicPrefetches;
+    std::vector<std::unique_ptr<MusicPrefetch>> retiredPrefetches;      // released mid-load
+    JobSystem* jobSystem;
+    
+    // AL_EXT_float32 lets float and 24-bit samples go in without losing depth
+    bool floatFormats;
     
     // Sound sources (for playing multiple sounds simultaneously)
-    std::vector<ALuint> sources;
+    VoicePool voices;
     const int MAX_SOURCES = 32;
     
-    // Background music
-    ALuint musicSource;
-    ALuint currentMusicBuffer;
+    // Listener state, kept to estimate how audible a 3D voice is. Commands
+    // only mark it dirty; it reaches OpenAL once per tick.
+    float listenerX, listenerY, listenerZ;
+    float listenerOrientation[6];
+    float listenerVelocity[3];
+    bool listenerDirty;
+    
+    // Every sound that is playing, audible or not. Inaudible ones are
+    // virtual: they hold no source, their position in the sound keeps
+    // advancing, and they take a voice once they become audible.
+    struct Playback {
+        PlaybackId id;
+        SoundHandle sound;
+        float x, y, z;
+        bool relative;
+        float volume;
+        float pitch;
+        bool looping;
+        float occlusion;            // extra gain, e.g. from sound propagation
+        float gainHF;               // low-pass, 1 = unfiltered
+        VoicePriority priority;
+        double startTime;           // on the voice pool's clock
+        bool active;
+        int voice;                  // -1 while virtual
+    };
+    std::vector<Playback> playbacks;
+    std::vector<int> freePlaybacks;
+    const int MAX_PLAYBACKS = 256;
+    
+    // Below this gain (after distance attenuation) a sound goes virtual.
+    // Real voices are only demoted at half of it so they do not flicker.
+    const float AUDIBILITY_THRESHOLD = 0.01f;
+    std::atomic<uint32_t> nextPlaybackId;
+    
+    // Commands from any thread to the audio thread. Plain data only: loads
+    // pass ownership of their PendingSound through the pointer.
+    enum class CommandType : uint8_t {
+        PLAY,
+        STOP_PLAYBACK,
+        SET_PLAYBACK_POSITION,
+        SET_PLAYBACK_OCCLUSION,
+        STOP_SOUND,
+        STOP_ALL,
+        LOAD,
+        UNLOAD,
+        SET_LISTENER_POSITION,
+        SET_LISTENER_ORIENTATION,
+        SET_LISTENER_VELOCITY,
+        SET_SFX_VOLUME
+    };
+    
+    struct Command {
+        CommandType type;
+        bool relative;
+        bool loop;
+        VoicePriority priority;
+        SoundHandle sound;
+        PlaybackId playback;
+        float values[6];            // position (+ occlusion), orientation or velocity
+        float volume;
+        float pitch;
+        PendingSound* pending;
+    };
+    
+    static const size_t COMMAND_CAPACITY = 1024;
+    const int AUDIO_TICK_MS = 5;
+    std::unique_ptr<MPSCQueue<Command, COMMAND_CAPACITY>> commands;
+    std::thread audioThread;
+    std::atomic<bool> audioThreadQuit;
+    std::atomic<int> commandStalls;             // pushes that found the queue full
+    
+    // Snapshots the audio thread publishes for other threads
+    AudioCounters counters;
+    mutable std::mutex statsMutex;
+    VoiceStats publishedStats;
+    AudioCounters publishedCounters;
+    std::atomic<int> virtualVoiceCount;
+    
+    // Background music, streamed from disk on its own thread into an OpenAL
+    // source or a mixer stream. There are two streams so one can fade in
+    // while the other fades out.
+    static const int MUSIC_STREAMS = 2;
+    static const int MUSIC_MIXER_FRAMES = 65536;
+    ALuint musicSources[MUSIC_STREAMS];
+    std::unique_ptr<MusicStream> music[MUSIC_STREAMS];
+    int activeMusic;
     bool musicPlaying;
     float musicVolume;
-    float sfxVolume;
+    float sfxVolume;                // as last set by the game
+    float sfxGain;                  // audio thread's copy
     
     bool initialized;
     
     // Helper functions
+    bool openDevice();
+    bool openLoopbackDevice();
+    bool createContext(const ALCint* attributes);
+    void createVoiceFilters();
+    bool usesOpenAL() const {
+        return backend == AudioBackend::OPENAL || backend == AudioBackend::OPENAL_LOOPBACK;
+    }
+    bool isOffline() const { return backend != AudioBackend::OPENAL && backend != AudioBackend::SOFTWARE; }
     ALuint createSource();
-    bool loadWAVFile(const std::string& filename, ALuint& buffer);
-    ALuint getAvailableSource();
+    static bool decodeSoundFile(const std::string& filename, DecodedSound& sound, bool useFloat);
+    static bool decodeWAVFile(const std::string& filename, DecodedSound& sound, bool useFloat);
+    static bool decodeCompressedFile(const std::string& filename, DecodedSound& sound);
+    ALuint uploadSound(const DecodedSound* sound, const std::string& filename);
+    ALuint uploadToMixer(const DecodedSound* sound, const std::string& filename);
+    SoundHandle reserveSound(const std::string& name);
+    bool isLoading(SoundHandle handle) const;
+    void submitLoad(std::unique_ptr<PendingSound> pending);
+    static float getBufferDuration(ALuint buffer);
+    static float getDecodedDuration(const DecodedSound& sound);
+    void waitWhileLoading(SoundHandle handle);
+    PlaybackId queuePlayback(SoundHandle handle, float x, float y, float z, bool relative, float volume,
+                             float pitch, bool loop, VoicePriority priority, float occlusion = 1.0f,
+                             float gainHF = 1.0f);
+    void post(const Command& command);
+    
+    // Audio thread, or whoever calls render() on an offline backend
+    void audioThreadLoop();
+    void runTick();
+    void publishState();
+    void mixSoftware(int16_t* out, int frames);
+    void stopVoice(int voice);
+    void applyVoiceGain(const Playback& playback);
+    void processCommands();
+    void execute(const Command& command);
+    void applyListener();
+    void uploadFinishedSounds();
+    void discardSound(SoundHandle handle);
+    void startPlayback(const Command& command);
+    int findPlayback(PlaybackId id) const;
+    float getAudibility(const Playback& playback) const;
+    bool promote(int index);
+    void demote(int index);
+    void finishPlayback(int index);
+    void updatePlaybacks();
+    int countVirtualVoices() const;
+    std::shared_ptr<const MusicHead> findMusicHead(const std::string& filename) const;
     
 public:
     AudioEngine();
     ~AudioEngine();
     
-    bool initialize();
+    // Sample rate of the interleaved stereo that render() and the software
+    // mixer produce
+    static constexpr int OFFLINE_SAMPLE_RATE = 48000;
+    
+    bool initialize(AudioBackend requested = AudioBackend::OPENAL);
     void cleanup();
+    AudioBackend getBackend() const { return backend; }
+    
+    // Software backends only; takes effect at the next initialize()
+    void setMixerResampler(MixerResampler resampler) { mixerResampler = resampler; }
+    
+    // Offline backends only: runs one audio tick, then mixes frames of
+    // 16-bit interleaved stereo into out (silence for NULL_OUTPUT) and
+    // advances the audio clock by that much. On these backends the caller of
+    // render() acts as the audio thread, so it should also be the thread
+    // that loads sounds. Returns false on the OPENAL and SOFTWARE backends.
+    bool render(int16_t* out, int frames);
+    
+    // Worker pool used by loadSoundAsync; without one, async loads run inline
+    void setJobSystem(JobSystem* jobs) { jobSystem = jobs; }
     
     // Sound loading
     bool loadSound(const std::string& name, const std::string& filename);
+    SoundHandle loadSoundAsync(const std::string& name, const std::string& filename, bool critical = false);
+    void waitForCriticalSounds();
     void unloadSound(const std::string& name);
+    SoundHandle getSoundHandle(const std::string& name) const;
+    SoundHandle getSoundHandle(uint32_t nameHash) const;     // e.g. hashString("footstep")
+    bool isSoundReady(SoundHandle handle) const;
+    float getSoundDuration(SoundHandle handle) const;       // seconds; 0 until ready
+    
+    // Sound playback. Playing a sound that is still loading does nothing.
+    // When every voice is busy the priority decides what gets cut. The
+    // name-based overloads are a convenience layer over the handle ones.
+    PlaybackId playSound(SoundHandle handle, float volume = 1.0f, float pitch = 1.0f, bool loop = false,
+                         VoicePriority priority = VoicePriority::NORMAL);
+    PlaybackId playSound(const std::string& name, float volume = 1.0f, float pitch = 1.0f, bool loop = false,
+                         VoicePriority priority = VoicePriority::NORMAL);
+    PlaybackId playSound3D(SoundHandle handle, float x, float y, float z, float volume = 1.0f,
+                           VoicePriority priority = VoicePriority::NORMAL, bool loop = false);
+    PlaybackId playSound3D(const std::string& name, float x, float y, float z, float volume = 1.0f,
+                           VoicePriority priority = VoicePriority::NORMAL, bool loop = false);
+    void stopPlayback(PlaybackId id);
+    void setPlaybackPosition(PlaybackId id, float x, float y, float z);
+    
+    // Extra attenuation and high-frequency gain (1 = unfiltered) for a sound
+    // heard through walls or doorways. The low-pass needs ALC_EXT_EFX on the
+    // OpenAL backends; the software mixer always has it.
+    PlaybackId playSoundOccluded(SoundHandle handle, float x, float y, float z, float volume, float occlusion,
+                                 float gainHF, VoicePriority priority = VoicePriority::NORMAL, bool loop = false,
+                                 float pitch = 1.0f);
+    void setPlaybackOcclusion(PlaybackId id, float gain, float gainHF);
     
-    // Sound playback
-    void playSound(const std::string& name, float volume = 1.0f, float pitch = 1.0f, bool loop = false);
-    void playSound3D(const std::string& name, float x, float y, float z, float volume = 1.0f);
     void stopSound(const std::string& name);
     void stopAllSounds();
     
     // Music playback
     void playMusic(const std::string& filename, float volume = 0.5f, bool loop = true);
+    void crossfadeMusic(const std::string& filename, float volume = 0.5f, float seconds = 2.0f, bool loop = true);
     void stopMusic();
     void pauseMusic();
     void resumeMusic();
     void setMusicVolume(float volume);
     
+    // Read the opening of a track in the background so playMusic or
+    // crossfadeMusic can start it without touching the disk first
+    void prefetchMusic(const std::string& filename);
+    void releaseMusicPrefetch(const std::string& filename);
+    
     // Listener (player) position for 3D audio
     void setListenerPosition(float x, float y, float z);
     void setListenerOrientation(float atX, float atY, float atZ, float upX, float upY, float upZ);
@@ -69,7 +377,14 @@ public:
     float getMusicVolume() const { return musicVolume; }
     float getSFXVolume() const { return sfxVolume; }
     
-    // Update (call every frame)
+    // Voice usage, including how often sounds were stolen or dropped, as of
+    // the last audio tick
+    VoiceStats getVoiceStats() const;
+    int getVirtualVoiceCount() const { return virtualVoiceCount.load(std::memory_order_relaxed); }
+    AudioCounters getAudioCounters() const;
+    
+    // Update (call every frame). Tracks music state and frees finished
+    // prefetches; everything else happens on the audio thread.
     void update();
     
     bool isInitialized() const { return initialized; }
@@ -0,0 +1,208 @@
+#include "AudioSink.h"
+#include <iostream>
+
+// Device sinks are optional, like stb_vorbis: each is built when its headers
+// are found, and the build must then link libpulse-simple or libasound
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<pulse/simple.h>)
+#define ECHOES_HAVE_PULSE 1
+#include <pulse/error.h>
+#include <pulse/simple.h>
+#endif
+#if __has_include(<alsa/asoundlib.h>)
+#define ECHOES_HAVE_ALSA 1
+#include <alsa/asoundlib.h>
+#endif
+#endif
+
+namespace {
+
+// Small device buffers keep the mixer close to what is heard
+const unsigned int DEVICE_LATENCY_US = 20000;
+
+void writeU32(FILE* file, uint32_t value) {
+    fwrite(&value, 4, 1, file);
+}
+
+void writeU16(FILE* file, uint16_t value) {
+    fwrite(&value, 2, 1, file);
+}
+
+#ifdef ECHOES_HAVE_PULSE
+
+class PulseSink : public AudioSink {
+private:
+    pa_simple* stream;
+
+public:
+    PulseSink() : stream(nullptr) {}
+    ~PulseSink() override {
+        if (stream) {
+            pa_simple_drain(stream, nullptr);
+            pa_simple_free(stream);
+        }
+    }
+
+    bool open(int sampleRate) {
+        pa_sample_spec spec;
+        spec.format = PA_SAMPLE_S16LE;
+        spec.channels = 2;
+        spec.rate = static_cast<uint32_t>(sampleRate);
+
+        pa_buffer_attr attributes;
+        attributes.maxlength = static_cast<uint32_t>(-1);
+        attributes.tlength = static_cast<uint32_t>(pa_usec_to_bytes(DEVICE_LATENCY_US, &spec));
+        attributes.prebuf = static_cast<uint32_t>(-1);
+        attributes.minreq = static_cast<uint32_t>(-1);
+        attributes.fragsize = static_cast<uint32_t>(-1);
+
+        int error = 0;
+        stream = pa_simple_new(nullptr, "Echoes of the Forgotten Realm", PA_STREAM_PLAYBACK, nullptr, "game",
+                               &spec, nullptr, &attributes, &error);
+        if (!stream) {
+            std::cerr << "Failed to connect to PulseAudio: " << pa_strerror(error) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const int16_t* samples, int frames) override {
+        int error = 0;
+        if (pa_simple_write(stream, samples, static_cast<size_t>(frames) * 4, &error) < 0) {
+            std::cerr << "PulseAudio write failed: " << pa_strerror(error) << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
+
+#ifdef ECHOES_HAVE_ALSA
+
+class AlsaSink : public AudioSink {
+private:
+    snd_pcm_t* pcm;
+
+public:
+    AlsaSink() : pcm(nullptr) {}
+    ~AlsaSink() override {
+        if (pcm) {
+            snd_pcm_drain(pcm);
+            snd_pcm_close(pcm);
+        }
+    }
+
+    bool open(int sampleRate) {
+        int error = snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, 0);
+        if (error < 0) {
+            std::cerr << "Failed to open ALSA device: " << snd_strerror(error) << std::endl;
+            pcm = nullptr;
+            return false;
+        }
+
+        error = snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, 2,
+                                   static_cast<unsigned int>(sampleRate), 1, DEVICE_LATENCY_US);
+        if (error < 0) {
+            std::cerr << "Failed to configure ALSA device: " << snd_strerror(error) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const int16_t* samples, int frames) override {
+        while (frames > 0) {
+            snd_pcm_sframes_t written = snd_pcm_writei(pcm, samples, static_cast<snd_pcm_uframes_t>(frames));
+            if (written < 0) {
+                // Underruns happen when the game hitches; recover and carry on
+                if (snd_pcm_recover(pcm, static_cast<int>(written), 1) < 0) {
+                    std::cerr << "ALSA write failed: " << snd_strerror(static_cast<int>(written)) << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            samples += written * 2;
+            frames -= static_cast<int>(written);
+        }
+        return true;
+    }
+};
+
+#endif
+
+} // namespace
+
+WavFileSink::WavFileSink() : file(nullptr), dataBytes(0) {}
+
+WavFileSink::~WavFileSink() {
+    close();
+}
+
+void WavFileSink::writeHeader(int sampleRate) {
+    // Sizes are patched in by close()
+    fwrite("RIFF", 1, 4, file);
+    writeU32(file, 36 + dataBytes);
+    fwrite("WAVEfmt ", 1, 8, file);
+    writeU32(file, 16);
+    writeU16(file, 1);                                      // PCM
+    writeU16(file, 2);                                      // stereo
+    writeU32(file, static_cast<uint32_t>(sampleRate));
+    writeU32(file, static_cast<uint32_t>(sampleRate) * 4);  // byte rate
+    writeU16(file, 4);                                      // block align
+    writeU16(file, 16);                                     // bits per sample
+    fwrite("data", 1, 4, file);
+    writeU32(file, dataBytes);
+}
+
+bool WavFileSink::open(const std::string& filename, int sampleRate) {
+    close();
+
+    file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create audio file: " << filename << std::endl;
+        return false;
+    }
+    dataBytes = 0;
+    writeHeader(sampleRate);
+    return true;
+}
+
+void WavFileSink::close() {
+    if (!file) return;
+
+    fseek(file, 4, SEEK_SET);
+    writeU32(file, 36 + dataBytes);
+    fseek(file, 40, SEEK_SET);
+    writeU32(file, dataBytes);
+    fclose(file);
+    file = nullptr;
+}
+
+bool WavFileSink::write(const int16_t* samples, int frames) {
+    if (!file) return false;
+
+    size_t count = static_cast<size_t>(frames) * 2;
+    if (fwrite(samples, sizeof(int16_t), count, file) != count) return false;
+    dataBytes += static_cast<uint32_t>(count * sizeof(int16_t));
+    return true;
+}
+
+std::unique_ptr<AudioSink> openSystemAudioSink(int sampleRate) {
+#ifdef ECHOES_HAVE_PULSE
+    {
+        auto sink = std::make_unique<PulseSink>();
+        if (sink->open(sampleRate)) return sink;
+    }
+#endif
+#ifdef ECHOES_HAVE_ALSA
+    {
+        auto sink = std::make_unique<AlsaSink>();
+        if (sink->open(sampleRate)) return sink;
+    }
+#endif
+#if !defined(ECHOES_HAVE_PULSE) && !defined(ECHOES_HAVE_ALSA)
+    (void)sampleRate;
+    std::cerr << "No audio output built in (needs PulseAudio or ALSA headers)" << std::endl;
+#endif
+    return nullptr;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// Destination for the software mixer's output: 16-bit interleaved stereo.
+// write() on a device sink blocks until the device has room, which is what
+// paces the audio thread.
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+    virtual bool write(const int16_t* samples, int frames) = 0;
+};
+
+// Writes everything to a WAV file, as fast as it is given. Meant for offline
+// rendering: feed it what AudioEngine::render() produces.
+class WavFileSink : public AudioSink {
+private:
+    FILE* file;
+    uint32_t dataBytes;
+
+    void writeHeader(int sampleRate);
+
+public:
+    WavFileSink();
+    ~WavFileSink() override;
+
+    WavFileSink(const WavFileSink&) = delete;
+    WavFileSink& operator=(const WavFileSink&) = delete;
+
+    bool open(const std::string& filename, int sampleRate);
+    void close();
+    bool write(const int16_t* samples, int frames) override;
+};
+
+// The system's sound server or device: PulseAudio if the build found
+// <pulse/simple.h>, otherwise ALSA if it found <alsa/asoundlib.h>. Returns
+// nullptr (after logging why) when neither is available.
+std::unique_ptr<AudioSink> openSystemAudioSink(int sampleRate);
@@ -0,0 +1,6 @@
+#pragma once
+
+// Runtime CPU feature checks shared by the SIMD kernels. Always false on
+// non-x86 targets.
+bool cpuHasSSE41();
+bool cpuHasAVX2();        // includes OS support for the YMM registers
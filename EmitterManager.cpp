@@ -0,0 +1,107 @@
+#include "EmitterManager.h"
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <limits>
+
+EmitterManager::EmitterManager() : awakeCount(0) {}
+
+int EmitterManager::addEmitter(const ParticleSystem& particles, int effectId, RoomId room,
+                               const glm::vec3& position, float rate) {
+    const ParticleEffectLibrary& effects = particles.getEffects();
+    if (effectId < 0 || effectId >= effects.getCount()) return -1;
+    const EmitterDescriptor& d = effects.get(effectId);
+    
+    PersistentEmitter emitter;
+    emitter.effectId = effectId;
+    emitter.room = room;
+    emitter.position = position;
+    emitter.rate = rate >= 0.0f ? rate : d.spawnRate;
+    emitter.accumulator = 0.0f;
+    
+    // Seeded from the room and slot so a room always replays the same way
+    emitter.random.seed(room, emitters.size());
+    
+    // Starts dormant "forever", so the first wake fills in a steady state
+    emitter.dormant = true;
+    emitter.dormantTime = std::numeric_limits<float>::max();
+    
+    // Reach of the fastest, longest-lived particle
+    float horizontal = std::max(d.speedMax, d.spread * 1.415f) * d.lifeMax;
+    float up = std::max(d.upMax + d.speedMax * d.upFromSpeed, d.speedMax) * d.lifeMax;
+    float down = std::min(0.5f * 9.8f * d.lifeMax * d.lifeMax, 10.0f);
+    emitter.boundsMin = position - glm::vec3(horizontal, down, horizontal);
+    emitter.boundsMax = position + glm::vec3(horizontal, up, horizontal);
+    
+    emitters.push_back(emitter);
+    return static_cast<int>(emitters.size()) - 1;
+}
+
+void EmitterManager::setBounds(int emitter, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    if (emitter < 0 || emitter >= static_cast<int>(emitters.size())) return;
+    emitters[emitter].boundsMin = boundsMin;
+    emitters[emitter].boundsMax = boundsMax;
+}
+
+void EmitterManager::removeRoomEmitters(RoomId room) {
+    emitters.erase(std::remove_if(emitters.begin(), emitters.end(),
+                                  [room](const PersistentEmitter& e) { return e.room == room; }),
+                   emitters.end());
+}
+
+void EmitterManager::clear() {
+    emitters.clear();
+}
+
+void EmitterManager::setVisibleRooms(const RoomId* rooms, size_t count) {
+    visibleRooms.assign(rooms, rooms + count);
+}
+
+void EmitterManager::setViewProjection(const glm::mat4& viewProjection) {
+    frustum.extract(viewProjection);
+}
+
+void EmitterManager::catchUp(PersistentEmitter& emitter, ParticleSystem& particles) {
+    const EmitterDescriptor& d = particles.getEffects().get(emitter.effectId);
+    
+    // Only particles born within the last lifetime can still be alive
+    float window = std::min(emitter.dormantTime, d.lifeMax);
+    int count = static_cast<int>(emitter.rate * window);
+    if (count > 0) {
+        particles.emitN(d, emitter.random, emitter.position, count, window);
+    }
+    emitter.accumulator = 0.0f;
+}
+
+void EmitterManager::update(float deltaTime, ParticleSystem& particles) {
+    awakeCount = 0;
+    
+    for (auto& emitter : emitters) {
+        bool visible = std::find(visibleRooms.begin(), visibleRooms.end(), emitter.room) != visibleRooms.end() &&
+                       frustum.intersectsBox(emitter.boundsMin, emitter.boundsMax);
+        
+        if (!visible) {
+            if (!emitter.dormant) {
+                emitter.dormant = true;
+                emitter.dormantTime = 0.0f;
+            }
+            if (emitter.dormantTime < std::numeric_limits<float>::max()) {
+                emitter.dormantTime += deltaTime;
+            }
+            continue;
+        }
+        
+        if (emitter.dormant) {
+            catchUp(emitter, particles);
+            emitter.dormant = false;
+        }
+        ++awakeCount;
+        
+        emitter.accumulator += emitter.rate * deltaTime;
+        int count = static_cast<int>(emitter.accumulator);
+        if (count > 0) {
+            emitter.accumulator -= count;
+            particles.emitN(particles.getEffects().get(emitter.effectId), emitter.random,
+                            emitter.position, count);
+        }
+    }
+}
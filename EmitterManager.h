@@ -0,0 +1,56 @@
+#pragma once
+
+#include "FastRandom.h"
+#include "Frustum.h"
+#include "RoomGraph.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+class ParticleSystem;
+
+// Continuous emitter that belongs to a room, e.g. castle smoke or cave drips
+struct PersistentEmitter {
+    int effectId;
+    RoomId room;
+    glm::vec3 position;
+    glm::vec3 boundsMin;        // world box covering the emitter's particles
+    glm::vec3 boundsMax;
+    float rate;                 // particles per second
+    float accumulator;
+    Pcg32 random;
+    bool dormant;
+    float dormantTime;          // seconds since it went dormant
+};
+
+// Runs persistent emitters only while they can be seen. An emitter is dormant
+// when its room is not visible or its bounds are outside the view frustum.
+// Waking up fast-forwards it analytically so it looks like it never stopped.
+class EmitterManager {
+private:
+    std::vector<PersistentEmitter> emitters;
+    std::vector<RoomId> visibleRooms;       // a handful at most
+    Frustum frustum;
+    int awakeCount;
+    
+    void catchUp(PersistentEmitter& emitter, ParticleSystem& particles);
+    
+public:
+    EmitterManager();
+    
+    // Bounds are estimated from the effect's velocity and lifetime ranges.
+    // rate < 0 uses the effect's spawn rate. Returns the emitter index, or -1.
+    int addEmitter(const ParticleSystem& particles, int effectId, RoomId room, const glm::vec3& position,
+                   float rate = -1.0f);
+    void setBounds(int emitter, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    void removeRoomEmitters(RoomId room);
+    void clear();
+    
+    // Rooms whose emitters may run: the current room plus any seen through portals
+    void setVisibleRooms(const RoomId* rooms, size_t count);
+    void setViewProjection(const glm::mat4& viewProjection);
+    
+    void update(float deltaTime, ParticleSystem& particles);
+    
+    int getEmitterCount() const { return static_cast<int>(emitters.size()); }
+    int getAwakeCount() const { return awakeCount; }
+};
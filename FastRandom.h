@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// PCG32 (XSH-RR variant). Sixteen bytes per stream (64-bit state and
+// increment) and a handful of instructions per draw, so every emitter can
+// own one without the cost of a std::mt19937. Different stream ids give
+// independent sequences for one seed.
+struct Pcg32 {
+    uint64_t state;
+    uint64_t increment;
+
+    Pcg32() : state(0x853C49E6748FEA9BULL), increment(0xDA3E39CB94B95BDBULL) {}
+    Pcg32(uint64_t seedValue, uint64_t stream) { seed(seedValue, stream); }
+
+    void seed(uint64_t seedValue, uint64_t stream) {
+        state = 0;
+        increment = (stream << 1) | 1;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = static_cast<uint32_t>(old >> 59);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    // Uniform float in [0, 1) from the top 24 bits
+    float nextFloat() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float range(float minValue, float maxValue) {
+        return minValue + (maxValue - minValue) * nextFloat();
+    }
+};
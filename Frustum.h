@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes, extracted from a view-projection matrix
+class Frustum {
+private:
+    glm::vec4 planes[6];
+    bool valid;
+    
+public:
+    Frustum();
+    
+    void extract(const glm::mat4& viewProjection);
+    
+    // Conservative: may report boxes just outside a corner as visible.
+    // An unset frustum treats everything as visible.
+    bool intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+    bool isValid() const { return valid; }
+};
@@ -1,22 +1,29 @@
 #include "GameEngine.h"
+#include "Camera.h"
+#include "InputSystem.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <iterator>
 #include <random>
 #include <thread>
 #include <chrono>
+#include <functional>
 
 GameEngine::GameEngine(bool enableGraphics) 
-    : gameRunning(false), gameWon(false), turnsPlayed(0), finalBossDefeated(false), 
+    : currentRoom(nullptr), gameRunning(false), gameWon(false), turnsPlayed(0), finalBossDefeated(false), 
       useGraphics(enableGraphics), gameTime(0.0f),
       playerPosition(0.0f, 0.0f, 0.0f), playerRotation(0.0f),
       combatCooldown(0.0f), inCombat(false), currentEnemy(nullptr),
-      currentBiome("village"), footstepTimer(0.0f) {
+      footstepTimer(0.0f), prefetchRoom(INVALID_ROOM) {
+    
+    std::fill(std::begin(gameSounds), std::end(gameSounds), INVALID_SOUND);
     
     // Initialize world manager first
     worldManager = std::make_unique<WorldManager>();
     
     if (useGraphics) {
+        jobSystem = std::make_unique<JobSystem>();
         initializeGraphics();
         initializeAudio();
         initializeParticles();
@@ -67,25 +74,27 @@ void GameEngine::startGame() {
         
         // Initialize the game world
         populateWorld();
+        setupEnvironmentalEmitters();
         
         // Ensure we have a valid starting room
-        auto villageRoom = rooms.find("village");
-        if (villageRoom == rooms.end()) {
-            throw std::runtime_error("Critical Error: Starting room 'village' not found");
+        RoomId startRoom = worldManager->getStartRoom();
+        if (startRoom == INVALID_ROOM) {
+            throw std::runtime_error("Critical Error: World has no starting room");
         }
         
-        currentRoom = villageRoom->second;
-        if (!currentRoom) {
-            throw std::runtime_error("Critical Error: Starting room is null");
-        }
+        currentRoom = worldManager->getRoom(startRoom);
         
         currentRoom->setVisited(true);
         gameRunning = true;
         
+        // Biomes come with the world, so the music can only start now
+        currentBiome = std::string(currentRoom->getBiome());
+        if (!currentBiome.empty()) playAmbientSound(currentBiome);
+        
         std::cout << "\nWelcome, " << player->getName() << "!" << std::endl;
         std::cout << "Type 'help' for available commands.\n" << std::endl;
         
-        currentRoom->displayRoom();
+        currentRoom->displayRoom(worldManager->getGraph());
         
         if (useGraphics && renderer) {
             graphicsLoop();
@@ -175,16 +184,16 @@ void GameEngine::processCommand(const std::vector<std::string>& command) {
         }
     }
     else if (action == "north" || action == "n") {
-        handleMove("north");
+        moveTo(Direction::NORTH);
     }
     else if (action == "south" || action == "s") {
-        handleMove("south");
+        moveTo(Direction::SOUTH);
     }
     else if (action == "east" || action == "e") {
-        handleMove("east");
+        moveTo(Direction::EAST);
     }
     else if (action == "west" || action == "w") {
-        handleMove("west");
+        moveTo(Direction::WEST);
     }
     else if (action == "take" || action == "get" || action == "pick") {
         if (command.size() > 1) {
@@ -234,53 +243,60 @@ void GameEngine::processCommand(const std::vector<std::string>& command) {
     else if (action == "status" || action == "stats") {
         displayGameInfo();
     }
+    else if (action == "hint") {
+        handleHint();
+    }
     else {
         std::cout << "I don't understand that command. Type 'help' for available commands." << std::endl;
     }
 }
 
 void GameEngine::handleMove(const std::string& direction) {
+    Direction parsed;
+    if (!parseDirection(direction, parsed)) {
+        std::cout << "You can't go that way." << std::endl;
+        return;
+    }
+    moveTo(parsed);
+}
+
+void GameEngine::moveTo(Direction direction) {
     if (currentRoom->hasAliveEnemies()) {
         std::cout << "You can't leave while enemies are present! You must fight or find another way." << std::endl;
         return;
     }
     
-    std::string nextRoomId = currentRoom->getExit(direction);
-    if (nextRoomId.empty()) {
+    RoomId nextRoomId = worldManager->getGraph().getExit(currentRoom->getId(), direction);
+    if (nextRoomId == INVALID_ROOM) {
         std::cout << "You can't go that way." << std::endl;
         return;
     }
     
-    auto nextRoom = rooms.find(nextRoomId);
-    if (nextRoom != rooms.end()) {
-        std::cout << "You move " << direction << "..." << std::endl;
-        currentRoom = nextRoom->second;
-        
-        if (!currentRoom->isVisited()) {
-            currentRoom->setVisited(true);
-        }
+    std::cout << "You move " << getDirectionName(direction) << "..." << std::endl;
+    currentRoom = worldManager->getRoom(nextRoomId);
+    
+    if (!currentRoom->isVisited()) {
+        currentRoom->setVisited(true);
+    }
+    
+    // Add random encounters in some rooms (even if visited before)
+    if (currentRoom->getKey() == "forest" || currentRoom->getKey() == "cave") {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> dis(1, 100);
         
-        // Add random encounters in some rooms (even if visited before)
-        if (nextRoomId == "forest" || nextRoomId == "cave") {
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<> dis(1, 100);
-            
-            if (dis(gen) <= 60) { // 60% chance of encounter
-                auto enemy = std::make_shared<Enemy>(Enemy::createRandomEnemy());
-                currentRoom->addEnemy(enemy);
-                std::cout << "A " << enemy->getName() << " appears!" << std::endl;
-            }
+        if (dis(gen) <= 60) { // 60% chance of encounter
+            auto enemy = std::make_shared<Enemy>(Enemy::createRandomEnemy());
+            currentRoom->addEnemy(enemy);
+            std::cout << "A " << enemy->getName() << " appears!" << std::endl;
         }
-        
-        currentRoom->displayRoom();
-    } else {
-        std::cout << "Error: Room not found." << std::endl;
     }
+    
+    currentRoom->displayRoom(worldManager->getGraph());
 }
 
 void GameEngine::handleLook() {
-    currentRoom->lookAround();
+    currentRoom->lookAround(worldManager->getGraph());
 }
 
 void GameEngine::handleTake(const std::string& itemName) {
@@ -319,9 +335,10 @@ void GameEngine::handleUse(const std::string& itemName) {
         std::cout << "You used the " << itemName << "." << std::endl;
     }
     else if (item->getType() == Item::Type::KEY) {
-        if (currentRoom->getId() == "temple" && itemName == "ancient key") {
+        RoomId chamber = worldManager->findRoom("chamber");
+        if (currentRoom->getKey() == "temple" && itemName == "ancient key" && chamber != INVALID_ROOM) {
             currentRoom->setSpecialEvent("You unlock the hidden chamber! A passage opens to the north.");
-            currentRoom->addExit("north", "chamber");
+            worldManager->addExit(currentRoom->getId(), Direction::NORTH, chamber);
             std::cout << "The ancient key fits perfectly! A hidden passage opens." << std::endl;
         } else {
             std::cout << "The " << itemName << " doesn't work here." << std::endl;
@@ -481,6 +498,7 @@ void GameEngine::handleHelp() {
     std::cout << "  inventory/i - Show your items" << std::endl;
     std::cout << "  memory/journal - View recovered memories" << std::endl;
     std::cout << "  status - Show your character status" << std::endl;
+    std::cout << "  hint - Which way to the final battle" << std::endl;
     std::cout << "\nGame:" << std::endl;
     std::cout << "  save - Save your progress" << std::endl;
     std::cout << "  load - Load saved game" << std::endl;
@@ -489,6 +507,31 @@ void GameEngine::handleHelp() {
     std::cout << "=========================" << std::endl;
 }
 
+void GameEngine::handleHint() {
+    // Nearest room where a boss still lives
+    RoomGraphQuery& query = worldManager->getQuery();
+    RoomId target = INVALID_ROOM;
+    uint32_t targetDistance = RoomGraphQuery::UNREACHABLE;
+    for (RoomId id = 0; id < worldManager->getRoomCount(); id++) {
+        if (!worldManager->hasLivingBoss(id)) continue;
+        uint32_t distance = query.distance(currentRoom->getId(), id);
+        if (distance < targetDistance) {
+            target = id;
+            targetDistance = distance;
+        }
+    }
+    
+    Direction direction;
+    if (target == INVALID_ROOM) {
+        std::cout << "No path leads to the darkness that remains. Perhaps it is already defeated." << std::endl;
+    } else if (targetDistance == 0) {
+        std::cout << "The darkness you seek is here." << std::endl;
+    } else if (query.nextStep(currentRoom->getId(), target, direction)) {
+        std::cout << "A cold presence pulls you " << getDirectionName(direction) << ". It lies "
+                  << targetDistance << (targetDistance == 1 ? " room" : " rooms") << " away." << std::endl;
+    }
+}
+
 void GameEngine::handleQuit() {
     std::cout << "Are you sure you want to quit? (y/n): ";
     std::string response;
@@ -577,81 +620,76 @@ void GameEngine::endGame(bool won) {
 }
 
 void GameEngine::populateWorld() {
-    // Use WorldManager to create expanded world
-    if (worldManager) {
-        worldManager->initialize();
-        rooms = worldManager->getRooms();
-        std::cout << "World populated with " << rooms.size() << " rooms!" << std::endl;
+    // Load the world file through WorldManager
+    if (worldManager->initialize()) {
+        std::cout << "World populated with " << worldManager->getRoomCount() << " rooms!" << std::endl;
         return;
     }
     
     // Fallback to original world if WorldManager fails
+    WorldManager& world = *worldManager;
+    world.clear();
+    
     // Create rooms
-    auto village = std::make_shared<Room>("village", "Wrecked Village", 
+    RoomId village = world.addRoom("village", "Wrecked Village", 
         "You stand in the ruins of what was once a thriving village. Collapsed houses and broken carts litter the area. A sense of ancient tragedy hangs in the air.");
     
-    auto forest = std::make_shared<Room>("forest", "Misty Forest", 
+    RoomId forest = world.addRoom("forest", "Misty Forest", 
         "Dense fog swirls between ancient trees. The forest feels alive with whispers of the past. Strange shadows dance between the branches.");
     
-    auto temple = std::make_shared<Room>("temple", "Abandoned Temple", 
+    RoomId temple = world.addRoom("temple", "Abandoned Temple", 
         "Crumbling stone pillars support a partially collapsed roof. Ancient runes glow faintly on the walls, hinting at forgotten power.");
     
-    auto cave = std::make_shared<Room>("cave", "Underground Cave", 
+    RoomId cave = world.addRoom("cave", "Underground Cave", 
         "Dark tunnels stretch into the depths. Water drips steadily from stalactites, echoing in the darkness. The air is cold and damp.");
     
-    auto keep = std::make_shared<Room>("keep", "Ruined Keep", 
+    RoomId keep = world.addRoom("keep", "Ruined Keep", 
         "The once-mighty fortress now lies in ruins. A throne room opens before you, where shadows seem to gather with unnatural purpose.");
     
-    auto chamber = std::make_shared<Room>("chamber", "Hidden Chamber", 
+    RoomId chamber = world.addRoom("chamber", "Hidden Chamber", 
         "A secret chamber revealed by the ancient key. Mystical energy fills the air, and a portal of swirling darkness dominates the center.");
     
     // Set up connections
-    village->addExit("north", "forest");
-    village->addExit("east", "temple");
+    world.addExit(village, Direction::NORTH, forest);
+    world.addExit(village, Direction::EAST, temple);
     
-    forest->addExit("south", "village");
-    forest->addExit("north", "cave");
-    forest->addExit("east", "keep");
+    world.addExit(forest, Direction::SOUTH, village);
+    world.addExit(forest, Direction::NORTH, cave);
+    world.addExit(forest, Direction::EAST, keep);
     
-    temple->addExit("west", "village");
-    temple->addExit("north", "keep");
+    world.addExit(temple, Direction::WEST, village);
+    world.addExit(temple, Direction::NORTH, keep);
     
-    cave->addExit("south", "forest");
-    cave->addExit("east", "keep");
+    world.addExit(cave, Direction::SOUTH, forest);
+    world.addExit(cave, Direction::EAST, keep);
     
-    keep->addExit("west", "forest");
-    keep->addExit("south", "temple");
+    world.addExit(keep, Direction::WEST, forest);
+    world.addExit(keep, Direction::SOUTH, temple);
     
-    chamber->addExit("south", "temple");
+    world.addExit(chamber, Direction::SOUTH, temple);
     
     // Add environmental hazards
-    cave->setHazard(Room::HazardType::COLD);
-    chamber->setHazard(Room::HazardType::CURSED);
+    world.getRoom(cave)->setHazard(Room::HazardType::COLD);
+    world.getRoom(chamber)->setHazard(Room::HazardType::CURSED);
     
     // Add items
-    village->addItem(std::make_shared<Item>("rusty sword", "An old but serviceable blade", Item::Type::WEAPON, 10, 5));
-    village->addItem(std::make_shared<Item>("health potion", "A small vial of red liquid", Item::Type::POTION, 25, 20));
+    world.getRoom(village)->addItem(std::make_shared<Item>("rusty sword", "An old but serviceable blade", Item::Type::WEAPON, 10, 5));
+    world.getRoom(village)->addItem(std::make_shared<Item>("health potion", "A small vial of red liquid", Item::Type::POTION, 25, 20));
     
-    forest->addItem(std::make_shared<Item>("iron dagger", "A sharp, well-balanced dagger", Item::Type::WEAPON, 20, 3));
+    world.getRoom(forest)->addItem(std::make_shared<Item>("iron dagger", "A sharp, well-balanced dagger", Item::Type::WEAPON, 20, 3));
     
-    temple->addItem(std::make_shared<Item>("ancient key", "An ornate key humming with power", Item::Type::KEY, 0, 0));
-    temple->addItem(std::make_shared<Item>("crystal shard", "A glowing fragment of pure energy", Item::Type::QUEST_ITEM, 100, 0));
+    world.getRoom(temple)->addItem(std::make_shared<Item>("ancient key", "An ornate key humming with power", Item::Type::KEY, 0, 0));
+    world.getRoom(temple)->addItem(std::make_shared<Item>("crystal shard", "A glowing fragment of pure energy", Item::Type::QUEST_ITEM, 100, 0));
     
-    cave->addItem(std::make_shared<Item>("steel sword", "A finely crafted blade", Item::Type::WEAPON, 50, 8));
-    cave->addItem(std::make_shared<Item>("health potion", "A small vial of red liquid", Item::Type::POTION, 25, 20));
+    world.getRoom(cave)->addItem(std::make_shared<Item>("steel sword", "A finely crafted blade", Item::Type::WEAPON, 50, 8));
+    world.getRoom(cave)->addItem(std::make_shared<Item>("health potion", "A small vial of red liquid", Item::Type::POTION, 25, 20));
     
-    chamber->addItem(std::make_shared<Item>("legendary blade", "The weapon of a forgotten hero", Item::Type::WEAPON, 200, 15));
+    world.getRoom(chamber)->addItem(std::make_shared<Item>("legendary blade", "The weapon of a forgotten hero", Item::Type::WEAPON, 200, 15));
     
     // Add enemies
-    keep->addEnemy(std::make_shared<Enemy>(Enemy::createBoss()));
-    
-    // Store rooms
-    rooms["village"] = village;
-    rooms["forest"] = forest;
-    rooms["temple"] = temple;
-    rooms["cave"] = cave;
-    rooms["keep"] = keep;
-    rooms["chamber"] = chamber;
+    world.getRoom(keep)->addEnemy(std::make_shared<Enemy>(Enemy::createBoss()));
+    
+    world.setStartRoom(village);
 }
 
 // 3D Graphics Implementation
@@ -686,8 +724,11 @@ void GameEngine::graphicsLoop() {
         
         gameTime += deltaTime;
         
-        // Process input
+        // Process input - events queued since the last tick are consumed here
         renderer->pollEvents();
+        if (renderer->getInput()) {
+            renderer->getInput()->beginTick();
+        }
         processKeyboardInput(deltaTime);
         
         // Update game logic
@@ -733,28 +774,31 @@ void GameEngine::renderScene() {
     if (!renderer) return;
     
     renderer->render();
-    renderer->renderRoom(currentRoom ? currentRoom->getId() : "");
+    renderer->renderRoom(currentRoom ? std::string(currentRoom->getKey()) : "");
     renderer->renderPlayer();
     renderer->renderItems();
     renderer->renderEnemies();
+    
+    // Joins the particle update kicked off in updateParticles
+    if (particleSystem) {
+        particleSystem->render(renderer->getViewMatrix(), renderer->getProjectionMatrix());
+    }
+    
     renderer->renderUI();
 }
 
 void GameEngine::updateCamera() {
     if (!renderer || !renderer->getCamera()) return;
     
-    // Position camera based on current room
-    if (currentRoom) {
-        // Set camera position for room overview
-        renderer->getCamera()->setPosition(glm::vec3(0.0f, 5.0f, 8.0f));
-        renderer->getCamera()->lookAt(glm::vec3(0.0f, 0.0f, 0.0f));
-    }
+    // Follow the player (third-person style). Orientation belongs to mouse
+    // look, which the renderer latches right before it builds the view matrix.
+    renderer->getCamera()->setPosition(playerPosition + glm::vec3(0.0f, 2.0f, 5.0f));
 }
 
 void GameEngine::setupRoomEnvironment() {
     if (!renderer || !currentRoom) return;
     
-    renderer->setCurrentRoom(currentRoom->getId());
+    renderer->setCurrentRoom(std::string(currentRoom->getKey()));
 }
 
 void GameEngine::processInput() {
@@ -766,9 +810,9 @@ void GameEngine::processInput() {
 
 // Real-time 3D Gameplay Implementation
 void GameEngine::processKeyboardInput(float deltaTime) {
-    if (!renderer || !renderer->getWindow()) return;
+    if (!renderer || !renderer->getInput()) return;
     
-    GLFWwindow* window = renderer->getWindow();
+    const InputSystem* input = renderer->getInput();
     Camera* camera = renderer->getCamera();
     if (!camera) return;
     
@@ -778,28 +822,28 @@ void GameEngine::processKeyboardInput(float deltaTime) {
     bool isMoving = false;
     
     // WASD Movement
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    if (input->isKeyDown(GLFW_KEY_W)) {
         glm::vec3 forward = camera->getFront();
         forward.y = 0; // Keep movement on horizontal plane
         forward = glm::normalize(forward);
         playerPosition += forward * moveSpeed;
         isMoving = true;
     }
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    if (input->isKeyDown(GLFW_KEY_S)) {
         glm::vec3 forward = camera->getFront();
         forward.y = 0;
         forward = glm::normalize(forward);
         playerPosition -= forward * moveSpeed;
         isMoving = true;
     }
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    if (input->isKeyDown(GLFW_KEY_A)) {
         glm::vec3 right = glm::cross(camera->getFront(), glm::vec3(0, 1, 0));
         right.y = 0;
         right = glm::normalize(right);
         playerPosition -= right * moveSpeed;
         isMoving = true;
     }
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    if (input->isKeyDown(GLFW_KEY_D)) {
         glm::vec3 right = glm::cross(camera->getFront(), glm::vec3(0, 1, 0));
         right.y = 0;
         right = glm::normalize(right);
@@ -822,19 +866,12 @@ void GameEngine::processKeyboardInput(float deltaTime) {
     }
     
     // E key to interact
-    static bool eKeyPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS && !eKeyPressed) {
-        eKeyPressed = true;
+    if (input->wasKeyPressed(GLFW_KEY_E)) {
         handleInteraction();
     }
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_RELEASE) {
-        eKeyPressed = false;
-    }
     
     // Left Mouse Button to attack
-    static bool mousePressed = false;
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !mousePressed) {
-        mousePressed = true;
+    if (input->wasMouseButtonPressed(GLFW_MOUSE_BUTTON_LEFT)) {
         if (combatCooldown <= 0.0f) {
             auto enemy = findNearestEnemy();
             if (enemy) {
@@ -842,7 +879,7 @@ void GameEngine::processKeyboardInput(float deltaTime) {
                 std::cout << "Attacking enemy!" << std::endl;
                 
                 // Play sword swing sound
-                playCombatSound("swing");
+                playCombatSound(CombatSound::SWING);
                 
                 // Deal damage to enemy
                 if (currentEnemy && currentEnemy->alive()) {
@@ -851,7 +888,7 @@ void GameEngine::processKeyboardInput(float deltaTime) {
                     std::cout << "You deal " << damage << " damage!" << std::endl;
                     
                     // Play hit sound and blood effect
-                    playCombatSound("hit");
+                    playCombatSound(CombatSound::HIT);
                     glm::vec3 enemyPos = playerPosition + glm::vec3(2.0f, 0.0f, 0.0f);
                     spawnBloodEffect(enemyPos);
                     
@@ -870,32 +907,16 @@ void GameEngine::processKeyboardInput(float deltaTime) {
             }
         }
     }
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
-        mousePressed = false;
-    }
     
     // TAB to show inventory
-    static bool tabPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS && !tabPressed) {
-        tabPressed = true;
+    if (input->wasKeyPressed(GLFW_KEY_TAB)) {
         player->showInventory();
     }
-    if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_RELEASE) {
-        tabPressed = false;
-    }
     
     // M for memory/journal
-    static bool mPressed = false;
-    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !mPressed) {
-        mPressed = true;
+    if (input->wasKeyPressed(GLFW_KEY_M)) {
         player->showMemoryJournal();
     }
-    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
-        mPressed = false;
-    }
-    
-    // Update camera to follow player (third-person style)
-    camera->setPosition(playerPosition + glm::vec3(0, 2.0f, 5.0f));
     
     // Update combat cooldown
     if (combatCooldown > 0.0f) {
@@ -923,21 +944,24 @@ void GameEngine::handleInteraction() {
     // Check for room transitions
     // Check if player is near an exit
     if (currentRoom) {
+        const RoomGraph& graph = worldManager->getGraph();
+        RoomId room = currentRoom->getId();
+        
         // North exit
-        if (playerPosition.z < -8.0f && !currentRoom->getExit("north").empty()) {
-            handleMove("north");
+        if (playerPosition.z < -8.0f && graph.getExit(room, Direction::NORTH) != INVALID_ROOM) {
+            moveTo(Direction::NORTH);
         }
         // South exit
-        else if (playerPosition.z > 8.0f && !currentRoom->getExit("south").empty()) {
-            handleMove("south");
+        else if (playerPosition.z > 8.0f && graph.getExit(room, Direction::SOUTH) != INVALID_ROOM) {
+            moveTo(Direction::SOUTH);
         }
         // East exit
-        else if (playerPosition.x > 8.0f && !currentRoom->getExit("east").empty()) {
-            handleMove("east");
+        else if (playerPosition.x > 8.0f && graph.getExit(room, Direction::EAST) != INVALID_ROOM) {
+            moveTo(Direction::EAST);
         }
         // West exit
-        else if (playerPosition.x < -8.0f && !currentRoom->getExit("west").empty()) {
-            handleMove("west");
+        else if (playerPosition.x < -8.0f && graph.getExit(room, Direction::WEST) != INVALID_ROOM) {
+            moveTo(Direction::WEST);
         }
     }
 }
@@ -1023,7 +1047,7 @@ void GameEngine::updateCombat(float deltaTime) {
     // Check if enemy is still alive
     if (!currentEnemy->alive()) {
         // Enemy defeated - play death sound and spawn blood effect
-        playCombatSound("death");
+        playCombatSound(CombatSound::DEATH);
         glm::vec3 enemyPos = playerPosition + glm::vec3(2.0f, 0.0f, 0.0f); // Approximate enemy position
         spawnBloodEffect(enemyPos);
         
@@ -1131,24 +1155,45 @@ void GameEngine::displayHUD() {
 void GameEngine::initializeAudio() {
     try {
         audioEngine = std::make_unique<AudioEngine>();
-        if (!audioEngine->initialize()) {
-            std::cerr << "Failed to initialize audio engine. Continuing without audio." << std::endl;
-            audioEngine.reset();
-            return;
+        // OpenAL may be missing from the build or find no device; the
+        // software mixer then plays through PulseAudio or ALSA directly
+        if (!audioEngine->initialize() && !audioEngine->initialize(AudioBackend::SOFTWARE)) {
+            // No sound card (CI, headless servers): keep the audio path
+            // running against the null backend so it still gets exercised
+            std::cerr << "Failed to open an audio device. Continuing without audio output." << std::endl;
+            if (!audioEngine->initialize(AudioBackend::NULL_OUTPUT)) {
+                audioEngine.reset();
+                return;
+            }
         }
         
         std::cout << "Audio system initialized successfully!" << std::endl;
         
-        // Load sound effects (will use silent buffers if files not found)
-        audioEngine->loadSound("footstep", "sounds/footstep.wav");
-        audioEngine->loadSound("sword_swing", "sounds/sword_swing.wav");
-        audioEngine->loadSound("sword_hit", "sounds/sword_hit.wav");
-        audioEngine->loadSound("enemy_death", "sounds/enemy_death.wav");
-        audioEngine->loadSound("item_pickup", "sounds/item_pickup.wav");
-        audioEngine->loadSound("door_open", "sounds/door_open.wav");
+        // Load sound effects on the worker threads (will use silent buffers if
+        // files not found). Only the critical ones hold up startup; the rest are
+        // silent until update() uploads them.
+        struct SoundFile {
+            GameSound sound;
+            const char* name;
+            const char* filename;
+            bool critical;
+        };
+        static const SoundFile soundFiles[] = {
+            {GameSound::FOOTSTEP, "footstep", "sounds/footstep.wav", true},
+            {GameSound::SWORD_SWING, "sword_swing", "sounds/sword_swing.wav", true},
+            {GameSound::SWORD_HIT, "sword_hit", "sounds/sword_hit.wav", true},
+            {GameSound::ENEMY_DEATH, "enemy_death", "sounds/enemy_death.wav", false},
+            {GameSound::ITEM_PICKUP, "item_pickup", "sounds/item_pickup.wav", false},
+            {GameSound::DOOR_OPEN, "door_open", "sounds/door_open.wav", false},
+        };
+        
+        audioEngine->setJobSystem(jobSystem.get());
+        for (const SoundFile& file : soundFiles) {
+            gameSounds[static_cast<int>(file.sound)] =
+                audioEngine->loadSoundAsync(file.name, file.filename, file.critical);
+        }
         
-        // Start background music
-        playAmbientSound("village");
+        audioEngine->waitForCriticalSounds();
         
     } catch (const std::exception& e) {
         std::cerr << "Audio initialization error: " << e.what() << std::endl;
@@ -1164,61 +1209,171 @@ void GameEngine::updateAudio(float deltaTime) {
     // Update listener position to player position
     audioEngine->setListenerPosition(playerPosition.x, playerPosition.y, playerPosition.z);
     
-    // Update biome music if room changed
+    // Update biome music if room changed. Rooms from the fallback world carry
+    // no biome, so they keep whatever is playing.
     if (currentRoom) {
-        std::string newBiome = "village"; // Default, would read from room in full implementation
-        if (newBiome != currentBiome) {
+        std::string_view newBiome = currentRoom->getBiome();
+        if (!newBiome.empty() && newBiome != currentBiome) {
             currentBiome = newBiome;
             updateBiomeMusic();
         }
+        
+        if (currentRoom->getId() != prefetchRoom) {
+            prefetchRoom = currentRoom->getId();
+            prefetchNearbyBiomeAudio();
+        }
+        
+        // Paths only change when the listener's room does
+        if (soundPropagation.setListenerRoom(worldManager->getQuery(), currentRoom->getId())) {
+            routeRoomSounds();
+            soundscape.setListenerRoom(*worldManager, soundPropagation, *audioEngine);
+        }
     }
+    
+    soundscape.update(deltaTime, soundPropagation, *audioEngine);
+}
+
+void GameEngine::playGameSound(GameSound sound, float volume, VoicePriority priority) {
+    if (!audioEngine) return;
+    audioEngine->playSound(gameSounds[static_cast<int>(sound)], volume, 1.0f, false, priority);
 }
 
 void GameEngine::playFootstepSound() {
     if (!audioEngine) return;
     
     // Play footstep sound at player position
-    audioEngine->playSound3D("footstep", playerPosition.x, playerPosition.y, playerPosition.z, 0.3f);
+    audioEngine->playSound3D(gameSounds[static_cast<int>(GameSound::FOOTSTEP)],
+                             playerPosition.x, playerPosition.y, playerPosition.z, 0.3f, VoicePriority::LOW);
 }
 
-void GameEngine::playCombatSound(const std::string& soundType) {
-    if (!audioEngine) return;
-    
-    if (soundType == "swing") {
-        audioEngine->playSound("sword_swing", 0.7f, 1.0f);
-    } else if (soundType == "hit") {
-        audioEngine->playSound("sword_hit", 0.8f, 1.0f);
-    } else if (soundType == "death") {
-        audioEngine->playSound("enemy_death", 1.0f, 1.0f);
+void GameEngine::playCombatSound(CombatSound sound) {
+    switch (sound) {
+        case CombatSound::SWING:
+            playGameSound(GameSound::SWORD_SWING, 0.7f);
+            break;
+        case CombatSound::HIT:
+            playGameSound(GameSound::SWORD_HIT, 0.8f, VoicePriority::HIGH);
+            break;
+        case CombatSound::DEATH:
+            playGameSound(GameSound::ENEMY_DEATH, 1.0f, VoicePriority::HIGH);
+            break;
     }
 }
 
 void GameEngine::playItemPickupSound() {
-    if (!audioEngine) return;
-    audioEngine->playSound("item_pickup", 0.6f, 1.0f);
+    playGameSound(GameSound::ITEM_PICKUP, 0.6f);
+}
+
+std::string GameEngine::getBiomeMusicFile(const std::string& biome) {
+    if (!worldManager) return "sounds/music_" + biome + ".wav";
+    return "sounds/" + worldManager->getBiome(biome).musicTrack;
 }
 
 void GameEngine::playAmbientSound(const std::string& biome) {
     if (!audioEngine) return;
     
     // Play biome-specific ambient music
-    std::string musicFile = "sounds/music_" + biome + ".wav";
-    audioEngine->playMusic(musicFile, 0.3f, true);
+    audioEngine->playMusic(getBiomeMusicFile(biome), 0.3f, true);
 }
 
 void GameEngine::updateBiomeMusic() {
     if (!audioEngine) return;
     
-    // Fade out current music and start new biome music
-    audioEngine->stopMusic();
-    playAmbientSound(currentBiome);
+    // Fade out current music while the new biome's track fades in. It was
+    // prefetched while we were next door, so it starts this frame.
+    audioEngine->crossfadeMusic(getBiomeMusicFile(currentBiome), 0.3f, 2.0f);
+}
+
+void GameEngine::prefetchNearbyBiomeAudio() {
+    if (!audioEngine || !currentRoom || !worldManager) return;
+    
+    // Every biome within PREFETCH_DEPTH exits
+    std::vector<RoomGraphQuery::Reach> nearby;
+    worldManager->getQuery().reachableFrom(currentRoom->getId(), PREFETCH_DEPTH, nearby);
+    std::set<std::string> biomes;
+    for (const RoomGraphQuery::Reach& reach : nearby) {
+        std::string_view biome = worldManager->getRoomBiome(reach.room);
+        if (!biome.empty()) biomes.emplace(biome);
+    }
+    
+    std::set<std::string> wantedMusic;
+    std::set<std::string> wantedAmbience;
+    for (const std::string& biome : biomes) {
+        BiomeData data = worldManager->getBiome(biome);
+        wantedMusic.insert("sounds/" + data.musicTrack);
+        for (const AmbientSound& ambient : data.ambientSounds) {
+            wantedAmbience.insert(ambient.file);
+        }
+    }
+    
+    // Evict what has gone out of range, then request what has come into it
+    for (const std::string& file : prefetchedMusic) {
+        if (!wantedMusic.count(file)) audioEngine->releaseMusicPrefetch(file);
+    }
+    for (const std::string& name : prefetchedAmbience) {
+        if (!wantedAmbience.count(name)) audioEngine->unloadSound(name);
+    }
+    for (const std::string& file : wantedMusic) {
+        if (!prefetchedMusic.count(file)) audioEngine->prefetchMusic(file);
+    }
+    for (const std::string& name : wantedAmbience) {
+        if (!prefetchedAmbience.count(name)) audioEngine->loadSoundAsync(name, "sounds/" + name);
+    }
+    
+    prefetchedMusic.swap(wantedMusic);
+    prefetchedAmbience.swap(wantedAmbience);
+}
+
+PlaybackId GameEngine::playRoomSound(SoundHandle sound, RoomId roomId, const glm::vec3& position,
+                                     float volume, VoicePriority priority, bool loop) {
+    if (!audioEngine) return INVALID_PLAYBACK;
+    
+    // One-shots out of earshot are dropped. Loops start anyway, silent and
+    // virtual, so they are in step if the player comes closer.
+    SoundRoute route = soundPropagation.route(roomId, position);
+    if (!route.audible && !loop) return INVALID_PLAYBACK;
+    
+    PlaybackId playback = audioEngine->playSoundOccluded(sound, route.position.x, route.position.y,
+                                                         route.position.z, volume, route.gain, route.gainHF,
+                                                         priority, loop);
+    if (loop && playback != INVALID_PLAYBACK) {
+        roomSounds.push_back({playback, roomId, position});
+    }
+    return playback;
+}
+
+void GameEngine::stopRoomSound(PlaybackId playback) {
+    if (!audioEngine) return;
+    
+    audioEngine->stopPlayback(playback);
+    roomSounds.erase(std::remove_if(roomSounds.begin(), roomSounds.end(),
+                                    [playback](const RoomSound& sound) { return sound.playback == playback; }),
+                     roomSounds.end());
+}
+
+void GameEngine::routeRoomSounds() {
+    if (!audioEngine) return;
+    
+    for (const RoomSound& sound : roomSounds) {
+        SoundRoute route = soundPropagation.route(sound.roomId, sound.position);
+        audioEngine->setPlaybackPosition(sound.playback, route.position.x, route.position.y, route.position.z);
+        audioEngine->setPlaybackOcclusion(sound.playback, route.gain, route.gainHF);
+    }
 }
 
 // Particle System Implementation
 void GameEngine::initializeParticles() {
     try {
-        particleSystem = std::make_unique<ParticleSystem>(2000);
+        particleSystem = std::make_unique<ParticleSystem>(100000);
         particleSystem->initialize();
+        // Effects are data, not code; without them every emitter would
+        // quietly do nothing, so say so and run without particles
+        if (!particleSystem->loadEffects("particle_effects.cfg")) {
+            std::cerr << "No particle effects loaded. Continuing without particles." << std::endl;
+            particleSystem.reset();
+            return;
+        }
+        emitterManager = std::make_unique<EmitterManager>();
         std::cout << "Particle system initialized successfully!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Particle system initialization error: " << e.what() << std::endl;
@@ -1229,16 +1384,19 @@ void GameEngine::initializeParticles() {
 void GameEngine::updateParticles(float deltaTime) {
     if (!particleSystem) return;
     
-    particleSystem->update(deltaTime);
-    
-    // Spawn environmental particles based on room
-    static float envParticleTimer = 0.0f;
-    envParticleTimer += deltaTime;
-    
-    if (envParticleTimer > 2.0f) {
-        spawnEnvironmentalEffects();
-        envParticleTimer = 0.0f;
+    // Ambient emitters only run for the room on screen and inside last
+    // frame's frustum. Only the current room is drawn, so it is the whole
+    // visible set.
+    if (emitterManager && renderer) {
+        RoomId visible = currentRoom ? currentRoom->getId() : INVALID_ROOM;
+        emitterManager->setVisibleRooms(&visible, 1);
+        emitterManager->setViewProjection(renderer->getProjectionMatrix() * renderer->getViewMatrix());
+        emitterManager->update(deltaTime, *particleSystem);
     }
+    
+    // Simulation runs on the workers while the rest of the frame proceeds;
+    // renderScene() joins it before drawing
+    particleSystem->beginUpdate(deltaTime, jobSystem.get());
 }
 
 void GameEngine::spawnBloodEffect(const glm::vec3& position) {
@@ -1251,35 +1409,43 @@ void GameEngine::spawnItemPickupEffect(const glm::vec3& position) {
     particleSystem->emitSparkle(position, 10);
 }
 
-void GameEngine::spawnEnvironmentalEffects() {
-    if (!particleSystem || !currentRoom) return;
+void GameEngine::setupEnvironmentalEmitters() {
+    if (!particleSystem || !emitterManager) return;
     
-    std::string roomId = currentRoom->getId();
+    emitterManager->clear();
     
-    // Spawn dust particles in ruins
-    if (roomId.find("ruin") != std::string::npos || roomId.find("village") != std::string::npos) {
-        for (int i = 0; i < 3; i++) {
-            float x = ((rand() % 200) - 100) / 10.0f;
-            float z = ((rand() % 200) - 100) / 10.0f;
-            particleSystem->emitDust(glm::vec3(x, 0.0f, z), 3);
-        }
-    }
+    int dust = particleSystem->findEffect("dust");
+    int water = particleSystem->findEffect("water_splash");
+    int smoke = particleSystem->findEffect("smoke");
     
-    // Spawn water particles near rivers/caves
-    if (roomId.find("cave") != std::string::npos || roomId.find("underwater") != std::string::npos) {
-        for (int i = 0; i < 2; i++) {
-            float x = ((rand() % 200) - 100) / 10.0f;
-            float z = ((rand() % 200) - 100) / 10.0f;
-            particleSystem->emitWaterSplash(glm::vec3(x, 2.0f, z), 5);
+    for (RoomId id = 0; id < worldManager->getRoomCount(); id++) {
+        std::string_view key = worldManager->getRoomKey(id);
+        
+        // Fixed placement per room so revisits look the same
+        Pcg32 placement(std::hash<std::string_view>()(key), 0);
+        auto scatter = [&placement](float height) {
+            return glm::vec3(placement.range(-10.0f, 10.0f), height, placement.range(-10.0f, 10.0f));
+        };
+        
+        // Dust in ruins
+        if (key.find("ruin") != std::string_view::npos || key.find("village") != std::string_view::npos) {
+            for (int i = 0; i < 3; i++) {
+                emitterManager->addEmitter(*particleSystem, dust, id, scatter(0.0f));
+            }
         }
-    }
-    
-    // Spawn smoke in castle/dark areas
-    if (roomId.find("castle") != std::string::npos || roomId.find("throne") != std::string::npos) {
-        for (int i = 0; i < 2; i++) {
-            float x = ((rand() % 200) - 100) / 10.0f;
-            float z = ((rand() % 200) - 100) / 10.0f;
-            particleSystem->emitSmoke(glm::vec3(x, 0.0f, z), 5);
+        
+        // Dripping water near rivers/caves
+        if (key.find("cave") != std::string_view::npos || key.find("underwater") != std::string_view::npos) {
+            for (int i = 0; i < 2; i++) {
+                emitterManager->addEmitter(*particleSystem, water, id, scatter(2.0f));
+            }
+        }
+        
+        // Smoke in castle/dark areas
+        if (key.find("castle") != std::string_view::npos || key.find("throne") != std::string_view::npos) {
+            for (int i = 0; i < 2; i++) {
+                emitterManager->addEmitter(*particleSystem, smoke, id, scatter(0.0f));
+            }
         }
     }
 }
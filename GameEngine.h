@@ -6,16 +6,36 @@
 #include "OpenGLRenderer.h"
 #include "AudioEngine.h"
 #include "ParticleSystem.h"
+#include "EmitterManager.h"
 #include "WorldManager.h"
+#include "SoundPropagation.h"
+#include "Soundscape.h"
 #include <map>
+#include <set>
 #include <string>
 #include <memory>
 
+// Sound effects the engine plays, resolved to audio handles once at load
+enum class GameSound {
+    FOOTSTEP,
+    SWORD_SWING,
+    SWORD_HIT,
+    ENEMY_DEATH,
+    ITEM_PICKUP,
+    DOOR_OPEN,
+    COUNT
+};
+
+enum class CombatSound {
+    SWING,
+    HIT,
+    DEATH
+};
+
 class GameEngine {
 private:
     std::unique_ptr<Player> player;
-    std::map<std::string, std::shared_ptr<Room>> rooms;
-    std::shared_ptr<Room> currentRoom;
+    Room* currentRoom;                  // owned by worldManager
     bool gameRunning;
     bool gameWon;
     
@@ -28,13 +48,35 @@ private:
     bool useGraphics;
     float gameTime;
     
+    // Worker threads (declared before the systems that submit to it)
+    std::unique_ptr<JobSystem> jobSystem;
+    
     // Audio System
     std::unique_ptr<AudioEngine> audioEngine;
+    SoundHandle gameSounds[static_cast<int>(GameSound::COUNT)];
     std::string currentBiome;
     float footstepTimer;
     
+    // Biome audio read ahead for rooms within PREFETCH_DEPTH exits
+    static const int PREFETCH_DEPTH = 2;
+    RoomId prefetchRoom;
+    std::set<std::string> prefetchedMusic;
+    std::set<std::string> prefetchedAmbience;
+    
+    // Sounds placed in rooms reach the listener through doorways. Looping
+    // ones are re-routed whenever the listener changes room.
+    struct RoomSound {
+        PlaybackId playback;
+        RoomId roomId;
+        glm::vec3 position;
+    };
+    SoundPropagation soundPropagation;
+    std::vector<RoomSound> roomSounds;
+    Soundscape soundscape;
+    
     // Particle System
     std::unique_ptr<ParticleSystem> particleSystem;
+    std::unique_ptr<EmitterManager> emitterManager;
     
     // World Manager
     std::unique_ptr<WorldManager> worldManager;
@@ -61,6 +103,7 @@ private:
     
     // Command handlers
     void handleMove(const std::string& direction);
+    void moveTo(Direction direction);
     void handleLook();
     void handleTake(const std::string& itemName);
     void handleUse(const std::string& itemName);
@@ -70,6 +113,7 @@ private:
     void handleSave();
     void handleLoad();
     void handleHelp();
+    void handleHint();
     void handleQuit();
     
     // Game logic
@@ -106,17 +150,24 @@ public:
     void initializeAudio();
     void updateAudio(float deltaTime);
     void playFootstepSound();
-    void playCombatSound(const std::string& soundType);
+    void playGameSound(GameSound sound, float volume, VoicePriority priority = VoicePriority::NORMAL);
+    void playCombatSound(CombatSound sound);
     void playItemPickupSound();
     void playAmbientSound(const std::string& biome);
     void updateBiomeMusic();
+    std::string getBiomeMusicFile(const std::string& biome);
+    void prefetchNearbyBiomeAudio();
+    PlaybackId playRoomSound(SoundHandle sound, RoomId roomId, const glm::vec3& position, float volume,
+                             VoicePriority priority = VoicePriority::NORMAL, bool loop = false);
+    void stopRoomSound(PlaybackId playback);
+    void routeRoomSounds();
     
     // Particle effects
     void initializeParticles();
     void updateParticles(float deltaTime);
     void spawnBloodEffect(const glm::vec3& position);
     void spawnItemPickupEffect(const glm::vec3& position);
-    void spawnEnvironmentalEffects();
+    void setupEnvironmentalEmitters();
     
     // Player state in 3D
     glm::vec3 playerPosition;
@@ -0,0 +1,293 @@
+#include "GpuParticleSimulator.h"
+#include "Shader.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+static_assert(sizeof(GpuParticle) == 12 * sizeof(float), "GpuParticle must match the feedback varyings");
+
+namespace {
+
+// Ages and moves every slot. Dead slots (life <= 0) pass through unchanged;
+// jitter comes from a hash of the slot index and the frame so no CPU RNG is needed.
+const char* UPDATE_VERTEX_SHADER = R"(
+#version 330 core
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inVelocity;
+layout (location = 2) in vec4 inColor;
+layout (location = 3) in float inLife;
+layout (location = 4) in float inSize;
+
+out vec3 outPosition;
+out vec3 outVelocity;
+out vec4 outColor;
+out float outLife;
+out float outSize;
+
+uniform float deltaTime;
+uniform uint frameSeed;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float jitter(uint bits) {
+    return float(bits >> 8) / 16777216.0 - 0.5;
+}
+
+void main() {
+    outPosition = inPosition;
+    outVelocity = inVelocity;
+    outColor = inColor;
+    outLife = inLife;
+    outSize = inSize;
+
+    if (inLife <= 0.0) return;
+
+    float life = inLife - deltaTime;
+    outPosition = inPosition + inVelocity * deltaTime;
+    outVelocity.y -= 9.8 * deltaTime;
+
+    uint h = hash(uint(gl_VertexID) ^ frameSeed);
+    outVelocity.x += jitter(h) * deltaTime * 0.5;
+    outVelocity.z += jitter(hash(h)) * deltaTime * 0.5;
+
+    outColor.a = life;
+    outLife = life;
+}
+)";
+
+const char* FEEDBACK_VARYINGS[] = {
+    "outPosition", "outVelocity", "outColor", "outLife", "outSize"
+};
+
+const char* RENDER_VERTEX_SHADER = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in float aLife;
+layout (location = 4) in float aSize;
+
+out vec4 vColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float pointScale;
+
+void main() {
+    vColor = aColor;
+    if (aLife <= 0.0) {
+        // Dead slot: push it outside the clip volume
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        gl_PointSize = 0.0;
+        return;
+    }
+    gl_Position = projection * view * vec4(aPos, 1.0);
+    gl_PointSize = aSize * pointScale / gl_Position.w;
+}
+)";
+
+const char* RENDER_FRAGMENT_SHADER = R"(
+#version 330 core
+in vec4 vColor;
+out vec4 FragColor;
+
+void main() {
+    vec2 offset = gl_PointCoord - vec2(0.5);
+    if (dot(offset, offset) > 0.25) discard;
+    FragColor = vColor;
+}
+)";
+
+} // namespace
+
+GpuParticleSimulator::GpuParticleSimulator(int maxCount)
+    : capacity(maxCount), current(0), updateProgram(0), deltaTimeLocation(-1), frameSeedLocation(-1),
+      ringCursor(0), slotsUsed(0), frameCounter(0) {
+    stateVBO[0] = stateVBO[1] = 0;
+    stateVAO[0] = stateVAO[1] = 0;
+}
+
+GpuParticleSimulator::~GpuParticleSimulator() {
+    if (stateVAO[0] != 0) glDeleteVertexArrays(2, stateVAO);
+    if (stateVBO[0] != 0) glDeleteBuffers(2, stateVBO);
+    if (updateProgram != 0) glDeleteProgram(updateProgram);
+}
+
+bool GpuParticleSimulator::initialize() {
+    if (!createUpdateProgram()) return false;
+    if (!createRenderShader()) return false;
+    createBuffers();
+    return true;
+}
+
+bool GpuParticleSimulator::createUpdateProgram() {
+    GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(shader, 1, &UPDATE_VERTEX_SHADER, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "Particle update shader compilation failed: " << infoLog << std::endl;
+        glDeleteShader(shader);
+        return false;
+    }
+
+    // Vertex-only program; the varyings must be declared before linking
+    updateProgram = glCreateProgram();
+    glAttachShader(updateProgram, shader);
+    glTransformFeedbackVaryings(updateProgram, 5, FEEDBACK_VARYINGS, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(updateProgram);
+    glDeleteShader(shader);
+
+    glGetProgramiv(updateProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(updateProgram, 512, NULL, infoLog);
+        std::cerr << "Particle update shader linking failed: " << infoLog << std::endl;
+        glDeleteProgram(updateProgram);
+        updateProgram = 0;
+        return false;
+    }
+
+    deltaTimeLocation = glGetUniformLocation(updateProgram, "deltaTime");
+    frameSeedLocation = glGetUniformLocation(updateProgram, "frameSeed");
+    return true;
+}
+
+bool GpuParticleSimulator::createRenderShader() {
+    renderShader = std::make_unique<Shader>();
+    if (!renderShader->loadFromStrings(RENDER_VERTEX_SHADER, RENDER_FRAGMENT_SHADER)) {
+        std::cerr << "Failed to load GPU particle render shader" << std::endl;
+        renderShader.reset();
+        return false;
+    }
+    return true;
+}
+
+void GpuParticleSimulator::createBuffers() {
+    glGenVertexArrays(2, stateVAO);
+    glGenBuffers(2, stateVBO);
+
+    for (int i = 0; i < 2; ++i) {
+        glBindVertexArray(stateVAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, stateVBO[i]);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GpuParticle), nullptr, GL_DYNAMIC_COPY);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, velocity));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, color));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, life));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, size));
+        glEnableVertexAttribArray(4);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuParticleSimulator::spawn(const glm::vec3& position, const glm::vec3& velocity,
+                                 const glm::vec4& color, float life, float size) {
+    // More spawns than slots in one frame would overwrite each other
+    if ((int)spawnQueue.size() >= capacity) return;
+    spawnQueue.push_back({position, velocity, color, life, size});
+}
+
+void GpuParticleSimulator::uploadSpawns() {
+    if (spawnQueue.empty()) return;
+
+    // Write the records into the ring at the cursor, replacing the oldest slots.
+    // At most two contiguous writes are needed when the ring wraps.
+    glBindBuffer(GL_ARRAY_BUFFER, stateVBO[current]);
+
+    int remaining = (int)spawnQueue.size();
+    int written = 0;
+    while (remaining > 0) {
+        int run = std::min(remaining, capacity - ringCursor);
+        glBufferSubData(GL_ARRAY_BUFFER, ringCursor * sizeof(GpuParticle),
+                        run * sizeof(GpuParticle), spawnQueue.data() + written);
+        written += run;
+        remaining -= run;
+        ringCursor = (ringCursor + run) % capacity;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    slotsUsed = std::min(capacity, slotsUsed + written);
+    spawnQueue.clear();
+}
+
+void GpuParticleSimulator::simulate(float deltaTime) {
+    if (updateProgram == 0) return;
+
+    uploadSpawns();
+    if (slotsUsed == 0) return;
+
+    int next = 1 - current;
+
+    glUseProgram(updateProgram);
+    glUniform1f(deltaTimeLocation, deltaTime);
+    glUniform1ui(frameSeedLocation, ++frameCounter * 0x9E3779B9u);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(stateVAO[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, stateVBO[next]);
+
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, slotsUsed);
+    glEndTransformFeedback();
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    current = next;
+}
+
+void GpuParticleSimulator::render(const glm::mat4& view, const glm::mat4& projection) {
+    if (!renderShader || slotsUsed == 0) return;
+
+    // World-space size to pixels for the current viewport
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pointScale = viewport[3] * projection[1][1] * 0.5f;
+
+    renderShader->use();
+    renderShader->setMat4("view", view);
+    renderShader->setMat4("projection", projection);
+    renderShader->setFloat("pointScale", pointScale);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    glBindVertexArray(stateVAO[current]);
+    glDrawArrays(GL_POINTS, 0, slotsUsed);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+}
+
+void GpuParticleSimulator::clear() {
+    // Slots [0, slotsUsed) are the only ones ever simulated or drawn, and the
+    // ring refills them from slot 0, so the buffers need no reset
+    spawnQueue.clear();
+    ringCursor = 0;
+    slotsUsed = 0;
+}
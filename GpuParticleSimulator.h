@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+class Shader;
+
+// Full particle state as stored in the transform feedback buffers.
+// Field order matches the interleaved varyings of the update shader.
+struct GpuParticle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec4 color;
+    float life;
+    float size;
+};
+
+// Simulates particles entirely on the GPU. Two buffers are ping-ponged through
+// a vertex shader with transform feedback; the CPU only uploads spawn records
+// into a fixed-capacity ring of slots and never reads particles back.
+class GpuParticleSimulator {
+private:
+    int capacity;
+
+    // Ping-pong state buffers; current holds the latest simulated state
+    unsigned int stateVBO[2];
+    unsigned int stateVAO[2];
+    int current;
+
+    unsigned int updateProgram;
+    int deltaTimeLocation;
+    int frameSeedLocation;
+    std::unique_ptr<Shader> renderShader;
+
+    // Spawn records waiting for the next simulate(), written at ringCursor
+    std::vector<GpuParticle> spawnQueue;
+    int ringCursor;
+    int slotsUsed;
+    unsigned int frameCounter;
+
+    bool createUpdateProgram();
+    bool createRenderShader();
+    void createBuffers();
+    void uploadSpawns();
+
+public:
+    explicit GpuParticleSimulator(int maxCount);
+    ~GpuParticleSimulator();
+
+    GpuParticleSimulator(const GpuParticleSimulator&) = delete;
+    GpuParticleSimulator& operator=(const GpuParticleSimulator&) = delete;
+
+    // Needs a current GL 3.3 context. Returns false if the shaders fail to build.
+    bool initialize();
+
+    void spawn(const glm::vec3& position, const glm::vec3& velocity,
+               const glm::vec4& color, float life, float size);
+    void simulate(float deltaTime);
+    void render(const glm::mat4& view, const glm::mat4& projection);
+    void clear();
+
+    // Upper bound: slots written since the last clear. Dead slots are only
+    // discarded by the shaders, so the exact live count is never read back.
+    int getSlotsInUse() const { return slotsUsed; }
+    int getCapacity() const { return capacity; }
+};
@@ -0,0 +1,153 @@
+#include "InputSystem.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+InputEventQueue::InputEventQueue(size_t capacityPow2)
+    : buffer(capacityPow2), mask(capacityPow2 - 1), head(0), tail(0), dropped(0) {
+}
+
+bool InputEventQueue::push(const InputEvent& event) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    if (t - h >= buffer.size()) {
+        // Full - the consumer has stalled; drop rather than block the callback
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    buffer[t & mask] = event;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool InputEventQueue::pop(InputEvent& event) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    if (h == t) return false;
+
+    event = buffer[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+InputSystem::InputSystem()
+    : queue(256), firstCursor(true), lastCursorX(0.0), lastCursorY(0.0),
+      lookDeltaX(0.0f), lookDeltaY(0.0f), scrollDelta(0.0f),
+      oldestLookTime(-1.0), latchedLookTime(-1.0) {
+    std::fill(std::begin(keyDown), std::end(keyDown), false);
+    std::fill(std::begin(buttonDown), std::end(buttonDown), false);
+    std::fill(std::begin(pendingKeyPress), std::end(pendingKeyPress), false);
+    std::fill(std::begin(pendingButtonPress), std::end(pendingButtonPress), false);
+    std::fill(std::begin(tickKeyPress), std::end(tickKeyPress), false);
+    std::fill(std::begin(tickButtonPress), std::end(tickButtonPress), false);
+}
+
+void InputSystem::pushKey(int key, int action, double timestamp) {
+    queue.push({InputEvent::Type::KEY, key, action, 0.0, 0.0, timestamp});
+}
+
+void InputSystem::pushMouseButton(int button, int action, double timestamp) {
+    queue.push({InputEvent::Type::MOUSE_BUTTON, button, action, 0.0, 0.0, timestamp});
+}
+
+void InputSystem::pushCursor(double x, double y, double timestamp) {
+    queue.push({InputEvent::Type::CURSOR_MOVE, 0, 0, x, y, timestamp});
+}
+
+void InputSystem::pushScroll(double xoffset, double yoffset, double timestamp) {
+    queue.push({InputEvent::Type::SCROLL, 0, 0, xoffset, yoffset, timestamp});
+}
+
+void InputSystem::applyEvent(const InputEvent& event) {
+    switch (event.type) {
+        case InputEvent::Type::KEY:
+            if (event.code >= 0 && event.code < MAX_KEYS) {
+                if (event.action == GLFW_PRESS) {
+                    keyDown[event.code] = true;
+                    pendingKeyPress[event.code] = true;
+                } else if (event.action == GLFW_RELEASE) {
+                    keyDown[event.code] = false;
+                }
+            }
+            break;
+
+        case InputEvent::Type::MOUSE_BUTTON:
+            if (event.code >= 0 && event.code < MAX_BUTTONS) {
+                if (event.action == GLFW_PRESS) {
+                    buttonDown[event.code] = true;
+                    pendingButtonPress[event.code] = true;
+                } else if (event.action == GLFW_RELEASE) {
+                    buttonDown[event.code] = false;
+                }
+            }
+            break;
+
+        case InputEvent::Type::CURSOR_MOVE:
+            if (firstCursor) {
+                lastCursorX = event.x;
+                lastCursorY = event.y;
+                firstCursor = false;
+            }
+            lookDeltaX += static_cast<float>(event.x - lastCursorX);
+            lookDeltaY += static_cast<float>(lastCursorY - event.y); // Reversed since y-coordinates go from bottom to top
+            lastCursorX = event.x;
+            lastCursorY = event.y;
+            if (oldestLookTime < 0.0) oldestLookTime = event.timestamp;
+            break;
+
+        case InputEvent::Type::SCROLL:
+            scrollDelta += static_cast<float>(event.y);
+            if (oldestLookTime < 0.0) oldestLookTime = event.timestamp;
+            break;
+    }
+}
+
+void InputSystem::drain() {
+    InputEvent event;
+    while (queue.pop(event)) {
+        applyEvent(event);
+    }
+}
+
+void InputSystem::beginTick() {
+    drain();
+
+    // Publish the edges gathered since the previous tick. A press and release
+    // that both land between two ticks still counts as one press.
+    std::copy(std::begin(pendingKeyPress), std::end(pendingKeyPress), std::begin(tickKeyPress));
+    std::copy(std::begin(pendingButtonPress), std::end(pendingButtonPress), std::begin(tickButtonPress));
+    std::fill(std::begin(pendingKeyPress), std::end(pendingKeyPress), false);
+    std::fill(std::begin(pendingButtonPress), std::end(pendingButtonPress), false);
+}
+
+bool InputSystem::isKeyDown(int key) const {
+    return key >= 0 && key < MAX_KEYS && keyDown[key];
+}
+
+bool InputSystem::wasKeyPressed(int key) const {
+    return key >= 0 && key < MAX_KEYS && tickKeyPress[key];
+}
+
+bool InputSystem::isMouseButtonDown(int button) const {
+    return button >= 0 && button < MAX_BUTTONS && buttonDown[button];
+}
+
+bool InputSystem::wasMouseButtonPressed(int button) const {
+    return button >= 0 && button < MAX_BUTTONS && tickButtonPress[button];
+}
+
+bool InputSystem::latchLook(float& dx, float& dy, float& scroll) {
+    drain();
+
+    dx = lookDeltaX;
+    dy = lookDeltaY;
+    scroll = scrollDelta;
+    latchedLookTime = oldestLookTime;
+
+    bool hadInput = oldestLookTime >= 0.0;
+    lookDeltaX = 0.0f;
+    lookDeltaY = 0.0f;
+    scrollDelta = 0.0f;
+    oldestLookTime = -1.0;
+    return hadInput;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A single raw input event, stamped with the time GLFW delivered it
+struct InputEvent {
+    enum class Type : uint8_t {
+        KEY,
+        MOUSE_BUTTON,
+        CURSOR_MOVE,
+        SCROLL
+    };
+
+    Type type;
+    int code;       // GLFW key or mouse button
+    int action;     // GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+    double x, y;    // Cursor position or scroll offset
+    double timestamp;
+};
+
+// Lock-free single-producer/single-consumer ring buffer.
+// GLFW callbacks are the producer, the simulation tick is the consumer.
+class InputEventQueue {
+private:
+    std::vector<InputEvent> buffer;
+    size_t mask;
+    std::atomic<size_t> head; // Next slot to read
+    std::atomic<size_t> tail; // Next slot to write
+    std::atomic<uint32_t> dropped;
+
+public:
+    explicit InputEventQueue(size_t capacityPow2 = 256);
+
+    bool push(const InputEvent& event);
+    bool pop(InputEvent& event);
+
+    uint32_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+// Owns the event queue and the state the game reads each tick.
+// Keys and buttons are consumed at tick boundaries; mouse look is
+// accumulated separately so the camera can latch it just before rendering.
+class InputSystem {
+private:
+    static const int MAX_KEYS = 1024;
+    static const int MAX_BUTTONS = 8;
+
+    InputEventQueue queue;
+
+    // Current held state, updated as events are drained
+    bool keyDown[MAX_KEYS];
+    bool buttonDown[MAX_BUTTONS];
+
+    // Edges seen since the last tick, and the edges visible during this tick
+    bool pendingKeyPress[MAX_KEYS];
+    bool pendingButtonPress[MAX_BUTTONS];
+    bool tickKeyPress[MAX_KEYS];
+    bool tickButtonPress[MAX_BUTTONS];
+
+    // Mouse look accumulated since the last latch
+    bool firstCursor;
+    double lastCursorX, lastCursorY;
+    float lookDeltaX, lookDeltaY;
+    float scrollDelta;
+    double oldestLookTime; // Timestamp of the oldest un-latched look event
+    double latchedLookTime;
+
+    void drain();
+    void applyEvent(const InputEvent& event);
+
+public:
+    InputSystem();
+
+    // Producer side (GLFW callbacks)
+    void pushKey(int key, int action, double timestamp);
+    void pushMouseButton(int button, int action, double timestamp);
+    void pushCursor(double x, double y, double timestamp);
+    void pushScroll(double xoffset, double yoffset, double timestamp);
+
+    // Consumer side
+    void beginTick();
+    bool isKeyDown(int key) const;
+    bool wasKeyPressed(int key) const;
+    bool isMouseButtonDown(int button) const;
+    bool wasMouseButtonPressed(int button) const;
+
+    // Late latch: drain whatever arrived and hand back the accumulated look.
+    // Returns false if there was no look input since the last latch.
+    bool latchLook(float& dx, float& dy, float& scroll);
+
+    // Time of the oldest event folded into the most recent latch, for
+    // input-to-photon measurements (negative if none)
+    double getLatchedEventTime() const { return latchedLookTime; }
+    uint32_t getDroppedEventCount() const { return queue.getDroppedCount(); }
+};
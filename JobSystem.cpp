@@ -0,0 +1,103 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void JobSystem::submit(std::function<void()> task, JobCounter* counter) {
+    if (counter) {
+        counter->remaining.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({std::move(task), counter});
+    }
+    jobAvailable.notify_one();
+}
+
+int JobSystem::parallelFor(int count, int chunkSize,
+                           const std::function<void(int, int, int)>& fn, JobCounter& counter) {
+    if (count <= 0) return 0;
+    chunkSize = std::max(chunkSize, 1);
+
+    int chunkCount = (count + chunkSize - 1) / chunkSize;
+    counter.remaining.fetch_add(chunkCount, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int chunk = 0; chunk < chunkCount; ++chunk) {
+            int begin = chunk * chunkSize;
+            int end = std::min(begin + chunkSize, count);
+            jobs.push_back({[fn, begin, end, chunk]() { fn(begin, end, chunk); }, &counter});
+        }
+    }
+    jobAvailable.notify_all();
+
+    return chunkCount;
+}
+
+bool JobSystem::runOneJob(std::unique_lock<std::mutex>& lock, const JobCounter* only) {
+    auto next = jobs.begin();
+    if (only) {
+        next = std::find_if(jobs.begin(), jobs.end(), [only](const Job& job) { return job.counter == only; });
+    }
+    if (next == jobs.end()) return false;
+
+    Job job = std::move(*next);
+    jobs.erase(next);
+
+    lock.unlock();
+    job.task();
+    lock.lock();
+
+    if (job.counter) {
+        job.counter->remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    jobFinished.notify_all();
+    return true;
+}
+
+void JobSystem::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (stopping && jobs.empty()) return;
+        runOneJob(lock);
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto ownJobQueued = [&counter, this]() {
+        return std::any_of(jobs.begin(), jobs.end(), [&counter](const Job& job) { return job.counter == &counter; });
+    };
+    while (!counter.isDone()) {
+        // Help with this counter's jobs instead of idling; anything else
+        // queued may be far longer than what the caller is waiting for
+        if (!runOneJob(lock, &counter)) {
+            jobFinished.wait(lock, [&counter, &ownJobQueued]() { return counter.isDone() || ownJobQueued(); });
+        }
+    }
+}
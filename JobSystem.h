@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks completion of a group of jobs. Wait on it with JobSystem::wait().
+struct JobCounter {
+    std::atomic<int> remaining;
+
+    JobCounter() : remaining(0) {}
+    bool isDone() const { return remaining.load(std::memory_order_acquire) == 0; }
+};
+
+// Fixed pool of worker threads pulling from a shared FIFO queue
+class JobSystem {
+private:
+    struct Job {
+        std::function<void()> task;
+        JobCounter* counter;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    bool stopping;
+
+    void workerLoop();
+    // The oldest queued job, or the oldest of only's when given
+    bool runOneJob(std::unique_lock<std::mutex>& lock, const JobCounter* only = nullptr);
+
+public:
+    // threadCount = 0 uses one worker per hardware thread, minus the main thread
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(std::function<void()> task, JobCounter* counter = nullptr);
+
+    // Split [0, count) into chunks of chunkSize and run fn(begin, end, chunkIndex)
+    // for each chunk on the workers. Returns the number of chunks submitted.
+    int parallelFor(int count, int chunkSize,
+                    const std::function<void(int, int, int)>& fn, JobCounter& counter);
+
+    // Block until the counter reaches zero, running its queued jobs meanwhile.
+    // Other jobs, such as a whole-file sound decode, are left to the workers
+    // so that a frame waiting on its own work never picks one up.
+    void wait(JobCounter& counter);
+
+    unsigned getWorkerCount() const { return static_cast<unsigned>(workers.size()); }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Bounded lock-free queue for many producers and one consumer, after Dmitry
+// Vyukov's bounded MPMC design. Each cell carries a sequence number that says
+// whether it is free for the producer claiming that position or holds a value
+// for the consumer, so producers only contend on one atomic increment and
+// never wait on each other. Capacity must be a power of two; T should be a
+// small trivially copyable command.
+template <typename T, size_t Capacity>
+class MPSCQueue {
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Queue items are copied, not moved");
+
+    static const size_t MASK = Capacity - 1;
+    static const size_t CACHE_LINE = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // Producers and the consumer write different counters; keep them on
+    // separate cache lines so they do not bounce between cores
+    alignas(CACHE_LINE) Cell cells[Capacity];
+    alignas(CACHE_LINE) std::atomic<size_t> enqueuePos;
+    alignas(CACHE_LINE) size_t dequeuePos;
+
+public:
+    MPSCQueue() : enqueuePos(0), dequeuePos(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    // Any thread. Returns false if the queue is full.
+    bool push(const T& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & MASK];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                // Free for this position; claim it
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                // Still holds a value from one lap ago
+                return false;
+            } else {
+                // Another producer got here first
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Returns false if nothing is ready.
+    bool pop(T& value) {
+        Cell* cell = &cells[dequeuePos & MASK];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePos + 1) < 0) return false;
+
+        value = cell->value;
+        cell->sequence.store(dequeuePos + Capacity, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+};
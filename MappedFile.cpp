@@ -0,0 +1,140 @@
+#include "MappedFile.h"
+#include <cstdint>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), fileHandle(nullptr), mappingHandle(nullptr) {}
+
+bool MappedFile::open(const std::string& filename, MappedAccess access) {
+    close();
+
+    DWORD hint = access == MappedAccess::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | hint, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open file for mapping: " << filename << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        // Empty files cannot be mapped
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        std::cerr << "Failed to map file: " << filename << std::endl;
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        std::cerr << "Failed to map file: " << filename << std::endl;
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    bytes = static_cast<const unsigned char*>(view);
+    length = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+
+    bytes = nullptr;
+    length = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), descriptor(-1) {}
+
+bool MappedFile::open(const std::string& filename, MappedAccess access) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open file for mapping: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        // Empty files cannot be mapped
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map file: " << filename << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    madvise(view, static_cast<size_t>(info.st_size),
+            access == MappedAccess::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    descriptor = fd;
+    bytes = static_cast<const unsigned char*>(view);
+    length = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+    if (descriptor >= 0) ::close(descriptor);
+
+    bytes = nullptr;
+    length = 0;
+    descriptor = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::prefault(const unsigned char* first, size_t bytes) const {
+    if (!bytes || first < this->bytes || first + bytes > this->bytes + length) return;
+
+#ifndef _WIN32
+    // Start readahead for the whole range before walking it
+    uintptr_t pageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    uintptr_t start = reinterpret_cast<uintptr_t>(first) & ~pageMask;
+    madvise(reinterpret_cast<void*>(start), reinterpret_cast<uintptr_t>(first) + bytes - start, MADV_WILLNEED);
+#endif
+
+    // Read one byte per page; the hint above is only advice
+    const size_t PAGE_STRIDE = 4096;
+    unsigned char sum = 0;
+    for (size_t offset = 0; offset < bytes; offset += PAGE_STRIDE) {
+        sum ^= static_cast<const volatile unsigned char*>(first)[offset];
+    }
+    sum ^= static_cast<const volatile unsigned char*>(first)[bytes - 1];
+    (void)sum;
+}
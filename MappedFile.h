@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// How a mapping will be read, passed to the OS as a readahead hint
+enum class MappedAccess {
+    SEQUENTIAL,     // front to back once, like sample data
+    RANDOM          // scattered lookups, like world records
+};
+
+// Read-only memory mapping of a whole file. Pages are brought in by the OS on
+// first touch and stay backed by the file, so mapping a large asset does not
+// allocate a heap copy of it.
+class MappedFile {
+private:
+    const unsigned char* bytes;
+    size_t length;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int descriptor;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename, MappedAccess access);
+    void close();
+
+    // Fault in the pages under [first, first + bytes) now, so whoever reads
+    // them later (the audio thread, say) does not wait on the disk
+    void prefault(const unsigned char* first, size_t bytes) const;
+
+    bool isOpen() const { return bytes != nullptr; }
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
@@ -0,0 +1,454 @@
+#include "MixerKernels.h"
+#include "CpuFeatures.h"
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIXER_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define MIXER_TARGET_SSE41
+#define MIXER_TARGET_AVX2
+#else
+#define MIXER_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define MIXER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// The segment is split into a whole-frame base and a small float offset, so
+// positions stay precise however far into a long sound the voice is. Every
+// level computes frame i's position as offset + i * step, in that order.
+struct SegmentStart {
+    const float* base;
+    float offset;
+};
+
+inline SegmentStart splitPosition(const MixSegment& s) {
+    double whole = std::floor(s.position);
+    SegmentStart start;
+    start.base = s.samples + static_cast<int64_t>(whole) * s.channels;
+    start.offset = static_cast<float>(s.position - whole);
+    return start;
+}
+
+void mixScalar(const MixSegment& s, float* bus, int begin, int frames) {
+    SegmentStart start = splitPosition(s);
+
+    for (int i = begin; i < frames; ++i) {
+        float fi = static_cast<float>(i);
+        float position = start.offset + fi * s.step;
+        float whole = std::floor(position);
+        float t = position - whole;
+        const float* frame = start.base + static_cast<int>(whole) * s.channels;
+        float gainLeft = s.gainLeft + fi * s.gainLeftStep;
+        float gainRight = s.gainRight + fi * s.gainRightStep;
+
+        if (s.channels == 1) {
+            float sample = frame[0] + (frame[1] - frame[0]) * t;
+            bus[2 * i] += sample * gainLeft;
+            bus[2 * i + 1] += sample * gainRight;
+        } else {
+            float left = frame[0] + (frame[2] - frame[0]) * t;
+            float right = frame[1] + (frame[3] - frame[1]) * t;
+            bus[2 * i] += left * gainLeft;
+            bus[2 * i + 1] += right * gainRight;
+        }
+    }
+}
+
+void convertScalar(const float* bus, int16_t* out, int begin, int count) {
+    for (int i = begin; i < count; ++i) {
+        float value = bus[i];
+        if (value > 1.0f) value = 1.0f;
+        if (value < -1.0f) value = -1.0f;
+        out[i] = static_cast<int16_t>(std::nearbyint(value * 32767.0f));
+    }
+}
+
+// Filter banks for getPolyphaseFilter(). Band b passes up to
+// POLYPHASE_CUTOFF * POLYPHASE_BAND_SCALES[b] of the source's Nyquist rate.
+const int POLYPHASE_BANDS = 4;
+const float POLYPHASE_BAND_SCALES[POLYPHASE_BANDS] = {1.0f, 0.8f, 0.65f, 0.5f};
+const double POLYPHASE_CUTOFF = 0.9;
+
+// Blackman-windowed sinc, one row of taps per phase plus a last row for a
+// phase of exactly 1, each row normalised to unity gain at DC
+struct PolyphaseBank {
+    float taps[POLYPHASE_BANDS][POLYPHASE_PHASES + 1][POLYPHASE_TAPS];
+
+    PolyphaseBank() {
+        const double pi = 3.14159265358979323846;
+        const double halfWidth = POLYPHASE_TAPS / 2;
+
+        for (int band = 0; band < POLYPHASE_BANDS; ++band) {
+            double cutoff = POLYPHASE_CUTOFF * POLYPHASE_BAND_SCALES[band];
+            for (int phase = 0; phase <= POLYPHASE_PHASES; ++phase) {
+                double t = static_cast<double>(phase) / POLYPHASE_PHASES;
+                double row[POLYPHASE_TAPS];
+                double sum = 0.0;
+                for (int k = 0; k < POLYPHASE_TAPS; ++k) {
+                    double x = static_cast<double>(k - RESAMPLER_FRAMES_BEFORE) - t;
+                    double sinc = x == 0.0 ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+                    double w = x / halfWidth;
+                    double window = 0.42 + 0.5 * std::cos(pi * w) + 0.08 * std::cos(2.0 * pi * w);
+                    row[k] = sinc * window;
+                    sum += row[k];
+                }
+                for (int k = 0; k < POLYPHASE_TAPS; ++k) {
+                    taps[band][phase][k] = static_cast<float>(row[k] / sum);
+                }
+            }
+        }
+    }
+};
+
+const PolyphaseBank& getPolyphaseBank() {
+    static const PolyphaseBank bank;
+    return bank;
+}
+
+inline const float* getPhaseTaps(const float* filter, float fraction) {
+    return filter + static_cast<int>(fraction * POLYPHASE_PHASES + 0.5f) * POLYPHASE_TAPS;
+}
+
+// Summed in the order the SIMD versions' horizontal adds use
+inline float dotTaps(const float* taps, const float* frame, int stride) {
+    float p[POLYPHASE_TAPS];
+    for (int k = 0; k < POLYPHASE_TAPS; ++k) p[k] = taps[k] * frame[k * stride];
+    return ((p[0] + p[4]) + (p[2] + p[6])) + ((p[1] + p[5]) + (p[3] + p[7]));
+}
+
+void mixPolyphaseScalar(const MixSegment& s, float* bus, int begin, int frames) {
+    SegmentStart start = splitPosition(s);
+
+    for (int i = begin; i < frames; ++i) {
+        float fi = static_cast<float>(i);
+        float position = start.offset + fi * s.step;
+        float whole = std::floor(position);
+        const float* taps = getPhaseTaps(s.filter, position - whole);
+        const float* frame = start.base + (static_cast<int>(whole) - RESAMPLER_FRAMES_BEFORE) * s.channels;
+        float gainLeft = s.gainLeft + fi * s.gainLeftStep;
+        float gainRight = s.gainRight + fi * s.gainRightStep;
+
+        if (s.channels == 1) {
+            float sample = dotTaps(taps, frame, 1);
+            bus[2 * i] += sample * gainLeft;
+            bus[2 * i + 1] += sample * gainRight;
+        } else {
+            bus[2 * i] += dotTaps(taps, frame, 2) * gainLeft;
+            bus[2 * i + 1] += dotTaps(taps, frame + 1, 2) * gainRight;
+        }
+    }
+}
+
+#ifdef MIXER_KERNELS_X86
+
+MIXER_TARGET_SSE41
+void mixSSE41(const MixSegment& s, float* bus, int frames) {
+    SegmentStart start = splitPosition(s);
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 offset = _mm_set1_ps(start.offset);
+    const __m128 step = _mm_set1_ps(s.step);
+    const __m128 gainLeft = _mm_set1_ps(s.gainLeft);
+    const __m128 gainRight = _mm_set1_ps(s.gainRight);
+    const __m128 gainLeftStep = _mm_set1_ps(s.gainLeftStep);
+    const __m128 gainRightStep = _mm_set1_ps(s.gainRightStep);
+
+    alignas(16) int index[4];
+    alignas(16) float a0[4], a1[4], b0[4], b1[4];
+
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 fi = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+        __m128 position = _mm_add_ps(offset, _mm_mul_ps(fi, step));
+        __m128 whole = _mm_floor_ps(position);
+        __m128 t = _mm_sub_ps(position, whole);
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(whole));
+
+        // No gather before AVX2; fetch the neighbours one frame at a time
+        if (s.channels == 1) {
+            for (int k = 0; k < 4; ++k) {
+                const float* frame = start.base + index[k];
+                a0[k] = frame[0];
+                a1[k] = frame[1];
+            }
+        } else {
+            for (int k = 0; k < 4; ++k) {
+                const float* frame = start.base + index[k] * 2;
+                a0[k] = frame[0];
+                a1[k] = frame[2];
+                b0[k] = frame[1];
+                b1[k] = frame[3];
+            }
+        }
+
+        __m128 left = _mm_load_ps(a0);
+        left = _mm_add_ps(left, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(a1), left), t));
+        __m128 right = left;
+        if (s.channels == 2) {
+            right = _mm_load_ps(b0);
+            right = _mm_add_ps(right, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(b1), right), t));
+        }
+
+        left = _mm_mul_ps(left, _mm_add_ps(gainLeft, _mm_mul_ps(fi, gainLeftStep)));
+        right = _mm_mul_ps(right, _mm_add_ps(gainRight, _mm_mul_ps(fi, gainRightStep)));
+
+        // Interleave back to L R L R
+        float* out = bus + 2 * i;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(left, right)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(left, right)));
+    }
+
+    mixScalar(s, bus, i, frames);
+}
+
+MIXER_TARGET_AVX2
+void mixAVX2(const MixSegment& s, float* bus, int frames) {
+    SegmentStart start = splitPosition(s);
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 offset = _mm256_set1_ps(start.offset);
+    const __m256 step = _mm256_set1_ps(s.step);
+    const __m256 gainLeft = _mm256_set1_ps(s.gainLeft);
+    const __m256 gainRight = _mm256_set1_ps(s.gainRight);
+    const __m256 gainLeftStep = _mm256_set1_ps(s.gainLeftStep);
+    const __m256 gainRightStep = _mm256_set1_ps(s.gainRightStep);
+
+    int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256 fi = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lanes);
+        __m256 position = _mm256_add_ps(offset, _mm256_mul_ps(fi, step));
+        __m256 whole = _mm256_floor_ps(position);
+        __m256 t = _mm256_sub_ps(position, whole);
+        __m256i index = _mm256_cvttps_epi32(whole);
+
+        __m256 left, right;
+        if (s.channels == 1) {
+            __m256 a0 = _mm256_i32gather_ps(start.base, index, 4);
+            __m256 a1 = _mm256_i32gather_ps(start.base + 1, index, 4);
+            left = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_sub_ps(a1, a0), t));
+            right = left;
+        } else {
+            __m256i sampleIndex = _mm256_slli_epi32(index, 1);
+            __m256 a0 = _mm256_i32gather_ps(start.base, sampleIndex, 4);
+            __m256 a1 = _mm256_i32gather_ps(start.base + 2, sampleIndex, 4);
+            __m256 b0 = _mm256_i32gather_ps(start.base + 1, sampleIndex, 4);
+            __m256 b1 = _mm256_i32gather_ps(start.base + 3, sampleIndex, 4);
+            left = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_sub_ps(a1, a0), t));
+            right = _mm256_add_ps(b0, _mm256_mul_ps(_mm256_sub_ps(b1, b0), t));
+        }
+
+        left = _mm256_mul_ps(left, _mm256_add_ps(gainLeft, _mm256_mul_ps(fi, gainLeftStep)));
+        right = _mm256_mul_ps(right, _mm256_add_ps(gainRight, _mm256_mul_ps(fi, gainRightStep)));
+
+        // unpack works per 128-bit half, so put the halves back in order
+        __m256 low = _mm256_unpacklo_ps(left, right);
+        __m256 high = _mm256_unpackhi_ps(left, right);
+        __m256 first = _mm256_permute2f128_ps(low, high, 0x20);
+        __m256 second = _mm256_permute2f128_ps(low, high, 0x31);
+
+        float* out = bus + 2 * i;
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), first));
+        _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(out + 8), second));
+    }
+
+    mixScalar(s, bus, i, frames);
+}
+
+// Horizontal sum of (p0+p4, p1+p5, p2+p6, p3+p7), in dotTaps' order
+MIXER_TARGET_SSE41
+inline float sumPairs(__m128 a) {
+    __m128 b = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(b, _mm_shuffle_ps(b, b, 1)));
+}
+
+// The polyphase kernels take one output frame at a time and vectorise the
+// dot product across the taps
+MIXER_TARGET_SSE41
+void mixPolyphaseSSE41(const MixSegment& s, float* bus, int frames) {
+    SegmentStart start = splitPosition(s);
+
+    for (int i = 0; i < frames; ++i) {
+        float fi = static_cast<float>(i);
+        float position = start.offset + fi * s.step;
+        float whole = std::floor(position);
+        const float* taps = getPhaseTaps(s.filter, position - whole);
+        const float* frame = start.base + (static_cast<int>(whole) - RESAMPLER_FRAMES_BEFORE) * s.channels;
+        float gainLeft = s.gainLeft + fi * s.gainLeftStep;
+        float gainRight = s.gainRight + fi * s.gainRightStep;
+
+        __m128 tapsLow = _mm_loadu_ps(taps);
+        __m128 tapsHigh = _mm_loadu_ps(taps + 4);
+        if (s.channels == 1) {
+            __m128 low = _mm_mul_ps(tapsLow, _mm_loadu_ps(frame));
+            __m128 high = _mm_mul_ps(tapsHigh, _mm_loadu_ps(frame + 4));
+            float sample = sumPairs(_mm_add_ps(low, high));
+            bus[2 * i] += sample * gainLeft;
+            bus[2 * i + 1] += sample * gainRight;
+        } else {
+            // Split L R L R into L L L L and R R R R
+            __m128 f0 = _mm_loadu_ps(frame), f1 = _mm_loadu_ps(frame + 4);
+            __m128 f2 = _mm_loadu_ps(frame + 8), f3 = _mm_loadu_ps(frame + 12);
+            __m128 leftLow = _mm_mul_ps(tapsLow, _mm_shuffle_ps(f0, f1, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128 leftHigh = _mm_mul_ps(tapsHigh, _mm_shuffle_ps(f2, f3, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128 rightLow = _mm_mul_ps(tapsLow, _mm_shuffle_ps(f0, f1, _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128 rightHigh = _mm_mul_ps(tapsHigh, _mm_shuffle_ps(f2, f3, _MM_SHUFFLE(3, 1, 3, 1)));
+            bus[2 * i] += sumPairs(_mm_add_ps(leftLow, leftHigh)) * gainLeft;
+            bus[2 * i + 1] += sumPairs(_mm_add_ps(rightLow, rightHigh)) * gainRight;
+        }
+    }
+}
+
+MIXER_TARGET_AVX2
+inline float sumTaps(__m256 products) {
+    __m128 a = _mm_add_ps(_mm256_castps256_ps128(products), _mm256_extractf128_ps(products, 1));
+    __m128 b = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(b, _mm_shuffle_ps(b, b, 1)));
+}
+
+MIXER_TARGET_AVX2
+void mixPolyphaseAVX2(const MixSegment& s, float* bus, int frames) {
+    SegmentStart start = splitPosition(s);
+
+    for (int i = 0; i < frames; ++i) {
+        float fi = static_cast<float>(i);
+        float position = start.offset + fi * s.step;
+        float whole = std::floor(position);
+        __m256 taps = _mm256_loadu_ps(getPhaseTaps(s.filter, position - whole));
+        const float* frame = start.base + (static_cast<int>(whole) - RESAMPLER_FRAMES_BEFORE) * s.channels;
+        float gainLeft = s.gainLeft + fi * s.gainLeftStep;
+        float gainRight = s.gainRight + fi * s.gainRightStep;
+
+        if (s.channels == 1) {
+            float sample = sumTaps(_mm256_mul_ps(taps, _mm256_loadu_ps(frame)));
+            bus[2 * i] += sample * gainLeft;
+            bus[2 * i + 1] += sample * gainRight;
+        } else {
+            // shuffle works per 128-bit half, leaving L0 L1 L4 L5 | L2 L3 L6 L7;
+            // swapping the middle 64-bit pairs puts the taps back in order
+            __m256 a = _mm256_loadu_ps(frame);
+            __m256 b = _mm256_loadu_ps(frame + 8);
+            __m256 left = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 right = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            left = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(left), _MM_SHUFFLE(3, 1, 2, 0)));
+            right = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(right), _MM_SHUFFLE(3, 1, 2, 0)));
+            bus[2 * i] += sumTaps(_mm256_mul_ps(taps, left)) * gainLeft;
+            bus[2 * i + 1] += sumTaps(_mm256_mul_ps(taps, right)) * gainRight;
+        }
+    }
+}
+
+MIXER_TARGET_SSE41
+void convertSSE41(const float* bus, int16_t* out, int count) {
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(bus + i), low), high), scale);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(bus + i + 4), low), high), scale);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+
+    convertScalar(bus, out, i, count);
+}
+
+#endif // MIXER_KERNELS_X86
+
+MixerKernelLevel detectBestLevel() {
+    if (isMixerKernelLevelSupported(MixerKernelLevel::AVX2)) return MixerKernelLevel::AVX2;
+    if (isMixerKernelLevelSupported(MixerKernelLevel::SSE41)) return MixerKernelLevel::SSE41;
+    return MixerKernelLevel::SCALAR;
+}
+
+// -1 means "use the detected level"
+std::atomic<int> forcedLevel(-1);
+
+MixerKernelLevel currentLevel() {
+    static const MixerKernelLevel best = detectBestLevel();
+    int forced = forcedLevel.load(std::memory_order_relaxed);
+    return forced >= 0 ? static_cast<MixerKernelLevel>(forced) : best;
+}
+
+} // namespace
+
+void mixSegment(const MixSegment& segment, float* bus, int frames) {
+    if (frames <= 0) return;
+
+    if (segment.filter) {
+        switch (currentLevel()) {
+#ifdef MIXER_KERNELS_X86
+            case MixerKernelLevel::AVX2:
+                mixPolyphaseAVX2(segment, bus, frames);
+                return;
+            case MixerKernelLevel::SSE41:
+                mixPolyphaseSSE41(segment, bus, frames);
+                return;
+#endif
+            default:
+                mixPolyphaseScalar(segment, bus, 0, frames);
+                return;
+        }
+    }
+
+    switch (currentLevel()) {
+#ifdef MIXER_KERNELS_X86
+        case MixerKernelLevel::AVX2:
+            mixAVX2(segment, bus, frames);
+            return;
+        case MixerKernelLevel::SSE41:
+            mixSSE41(segment, bus, frames);
+            return;
+#endif
+        default:
+            mixScalar(segment, bus, 0, frames);
+            return;
+    }
+}
+
+const float* getPolyphaseFilter(float step) {
+    // The widest band that stays below the source's effective Nyquist rate
+    int band = 0;
+    while (band < POLYPHASE_BANDS - 1 && POLYPHASE_BAND_SCALES[band] * step > 1.0f) band++;
+    return &getPolyphaseBank().taps[band][0][0];
+}
+
+void convertBusToS16(const float* bus, int16_t* out, int count) {
+#ifdef MIXER_KERNELS_X86
+    // Packing has nothing to gain from AVX2, so both SIMD levels share this
+    if (currentLevel() != MixerKernelLevel::SCALAR) {
+        convertSSE41(bus, out, count);
+        return;
+    }
+#endif
+    convertScalar(bus, out, 0, count);
+}
+
+MixerKernelLevel getMixerKernelLevel() {
+    return currentLevel();
+}
+
+bool setMixerKernelLevel(MixerKernelLevel level) {
+    if (!isMixerKernelLevelSupported(level)) return false;
+    forcedLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    return true;
+}
+
+bool isMixerKernelLevelSupported(MixerKernelLevel level) {
+    switch (level) {
+        case MixerKernelLevel::AVX2: return cpuHasAVX2();
+        case MixerKernelLevel::SSE41: return cpuHasSSE41();
+        default: return true;
+    }
+}
+
+const char* getMixerKernelName(MixerKernelLevel level) {
+    switch (level) {
+        case MixerKernelLevel::AVX2: return "AVX2";
+        case MixerKernelLevel::SSE41: return "SSE4.1";
+        default: return "Scalar";
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+// Inner loops of the software mixer, free of OpenAL so they can be built and
+// benchmarked standalone. Buses are interleaved stereo float.
+
+// Polyphase resampling: a windowed-sinc filter of POLYPHASE_TAPS taps,
+// tabulated at POLYPHASE_PHASES sub-frame offsets
+const int POLYPHASE_TAPS = 8;
+const int POLYPHASE_PHASES = 256;
+
+// Frames either resampler may read before floor(position) and after it.
+// Sounds are padded by this much on each side.
+const int RESAMPLER_FRAMES_BEFORE = POLYPHASE_TAPS / 2 - 1;
+const int RESAMPLER_FRAMES_AFTER = POLYPHASE_TAPS / 2;
+
+enum class MixerResampler {
+    LINEAR,
+    POLYPHASE
+};
+
+// One stretch of a voice to mix. The caller guarantees every frame read lies
+// inside `samples`: RESAMPLER_FRAMES_BEFORE before the first position and
+// RESAMPLER_FRAMES_AFTER after the last.
+struct MixSegment {
+    const float* samples;   // first frame of the sound, interleaved
+    int channels;           // 1 (panned) or 2 (straight through)
+    double position;        // in source frames
+    float step;             // source frames per output frame (pitch * rate ratio)
+    float gainLeft;
+    float gainRight;
+    float gainLeftStep;     // per output frame, for click-free gain changes
+    float gainRightStep;
+    const float* filter;    // from getPolyphaseFilter(), or nullptr to interpolate linearly
+};
+
+enum class MixerKernelLevel {
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+// Resample `frames` output frames of the segment and add them into bus.
+// Every level produces bit-identical output.
+void mixSegment(const MixSegment& segment, float* bus, int frames);
+
+// Filter bank for resampling at `step` source frames per output frame. Above
+// a step of 1 the cutoff drops with the source's effective Nyquist rate, in
+// a few fixed bands, so pitched-up sounds do not alias.
+const float* getPolyphaseFilter(float step);
+
+// Clamp to [-1, 1] and convert count samples to 16-bit, rounding to nearest
+void convertBusToS16(const float* bus, int16_t* out, int count);
+
+// Runtime dispatch, as for the particle kernels
+MixerKernelLevel getMixerKernelLevel();
+bool setMixerKernelLevel(MixerKernelLevel level);
+bool isMixerKernelLevelSupported(MixerKernelLevel level);
+const char* getMixerKernelName(MixerKernelLevel level);
@@ -0,0 +1,172 @@
+#include "MusicOutput.h"
+#include "SoftwareMixer.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Mono music is centred the way the mixer centres mono voices: -3 dB a side
+const float CENTRE_GAIN = 0.70710678f;
+
+#ifdef ECHOES_HAVE_OPENAL
+
+class OpenALMusicOutput : public MusicOutput {
+private:
+    ALuint source;
+    ALuint buffers[MUSIC_QUEUE_CHUNKS];
+    std::vector<ALuint> idle;       // buffers not queued on the source
+    ALenum format;
+    ALsizei sampleRate;
+
+    // Take back the buffers the source has finished with
+    void reclaim() {
+        ALint processed = 0;
+        alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+        while (processed-- > 0) {
+            ALuint buffer;
+            alSourceUnqueueBuffers(source, 1, &buffer);
+            idle.push_back(buffer);
+        }
+    }
+
+public:
+    explicit OpenALMusicOutput(ALuint musicSource)
+        : source(musicSource), format(AL_FORMAT_STEREO16), sampleRate(44100) {
+        alGenBuffers(MUSIC_QUEUE_CHUNKS, buffers);
+        idle.assign(buffers, buffers + MUSIC_QUEUE_CHUNKS);
+
+        // Looping is done by rewinding the decoder, not by the source
+        alSourcei(source, AL_LOOPING, AL_FALSE);
+    }
+
+    ~OpenALMusicOutput() override {
+        stop();
+        alDeleteBuffers(MUSIC_QUEUE_CHUNKS, buffers);
+    }
+
+    void reset(ALenum newFormat, ALsizei newRate) override {
+        stop();
+        format = newFormat;
+        sampleRate = newRate;
+    }
+
+    void stop() override {
+        alSourceStop(source);
+        // Detaching the buffer releases every queued buffer at once
+        alSourcei(source, AL_BUFFER, 0);
+        idle.assign(buffers, buffers + MUSIC_QUEUE_CHUNKS);
+    }
+
+    uint32_t getFreeBytes() override {
+        reclaim();
+        return idle.empty() ? 0 : MUSIC_CHUNK_BYTES;
+    }
+
+    void queue(const char* data, uint32_t bytes) override {
+        ALuint buffer = idle.back();
+        idle.pop_back();
+        alBufferData(buffer, format, data, static_cast<ALsizei>(bytes), sampleRate);
+        alSourceQueueBuffers(source, 1, &buffer);
+    }
+
+    void drain() override {}
+
+    void play() override { alSourcePlay(source); }
+    void pause() override { alSourcePause(source); }
+    void setGain(float gain) override { alSourcef(source, AL_GAIN, gain); }
+
+    bool update() override {
+        reclaim();
+        ALint queued = 0;
+        ALint state = AL_STOPPED;
+        alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+        alGetSourcei(source, AL_SOURCE_STATE, &state);
+        if (state == AL_PLAYING) return true;
+        if (queued == 0) return false;
+
+        // Starved: every buffer drained before we refilled. Restart.
+        alSourcePlay(source);
+        return true;
+    }
+};
+
+#endif
+
+class MixerMusicOutput : public MusicOutput {
+private:
+    MixerStream* stream;
+    int channels;
+    bool eightBit;
+    uint32_t frameBytes;
+    int sampleRate;
+    std::vector<float> frames;      // one chunk as stereo float
+
+public:
+    explicit MixerMusicOutput(MixerStream* mixerStream)
+        : stream(mixerStream), channels(2), eightBit(false), frameBytes(4), sampleRate(44100) {}
+
+    ~MixerMusicOutput() override { stop(); }
+
+    void reset(ALenum format, ALsizei rate) override {
+        channels = format == AL_FORMAT_MONO8 || format == AL_FORMAT_MONO16 ? 1 : 2;
+        eightBit = format == AL_FORMAT_MONO8 || format == AL_FORMAT_STEREO8;
+        frameBytes = static_cast<uint32_t>(channels * (eightBit ? 1 : 2));
+        sampleRate = rate;
+        stream->flush(sampleRate);
+    }
+
+    void stop() override { stream->flush(sampleRate); }
+
+    uint32_t getFreeBytes() override {
+        size_t free = std::min<size_t>(stream->getFreeFrames(), MUSIC_CHUNK_BYTES / frameBytes);
+        return static_cast<uint32_t>(free) * frameBytes;
+    }
+
+    void queue(const char* data, uint32_t bytes) override {
+        size_t count = bytes / frameBytes;
+        size_t samples = count * channels;
+        frames.resize(count * 2);
+
+        float* out = frames.data();
+        float scale = channels == 1 ? CENTRE_GAIN : 1.0f;
+        for (size_t i = 0; i < samples; i++) {
+            float value;
+            if (eightBit) {
+                value = (static_cast<float>(static_cast<uint8_t>(data[i])) - 128.0f) / 128.0f;
+            } else {
+                int16_t sample;
+                std::memcpy(&sample, data + 2 * i, sizeof(sample));
+                value = static_cast<float>(sample) / 32768.0f;
+            }
+            if (channels == 1) {
+                out[2 * i] = out[2 * i + 1] = value * scale;
+            } else {
+                out[i] = value;
+            }
+        }
+        stream->write(frames.data(), count);
+    }
+
+    void drain() override { stream->finish(); }
+
+    void play() override { stream->setPaused(false); }
+    void pause() override { stream->setPaused(true); }
+    void setGain(float gain) override { stream->setGain(gain); }
+
+    // The mixer never stops a stream that runs dry; it picks up again as
+    // soon as frames arrive
+    bool update() override { return stream->isFlushing() || stream->getQueuedFrames() > 0; }
+};
+
+} // namespace
+
+#ifdef ECHOES_HAVE_OPENAL
+std::unique_ptr<MusicOutput> createOpenALMusicOutput(ALuint source) {
+    return std::make_unique<OpenALMusicOutput>(source);
+}
+#endif
+
+std::unique_ptr<MusicOutput> createMixerMusicOutput(MixerStream* stream) {
+    return std::make_unique<MixerMusicOutput>(stream);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AudioConfig.h"
+#include <cstdint>
+#include <memory>
+
+class MixerStream;
+
+// Decoded music goes out in chunks of up to MUSIC_CHUNK_BYTES; the OpenAL
+// output keeps MUSIC_QUEUE_CHUNKS of them queued
+const uint32_t MUSIC_CHUNK_BYTES = 64 * 1024;
+const int MUSIC_QUEUE_CHUNKS = 4;
+
+// Where a MusicStream sends the PCM it decodes. Only the stream's own thread
+// calls it.
+class MusicOutput {
+public:
+    virtual ~MusicOutput() = default;
+
+    // Stop, drop everything queued, and expect PCM in this format
+    virtual void reset(ALenum format, ALsizei sampleRate) = 0;
+    virtual void stop() = 0;
+
+    // Bytes queue() takes right now, at most MUSIC_CHUNK_BYTES; 0 when full
+    virtual uint32_t getFreeBytes() = 0;
+    // Whole frames only, no more than getFreeBytes()
+    virtual void queue(const char* data, uint32_t bytes) = 0;
+    // Nothing more is coming for this track
+    virtual void drain() = 0;
+
+    virtual void play() = 0;
+    virtual void pause() = 0;
+    virtual void setGain(float gain) = 0;
+
+    // Restart playback if it ran dry with more queued. Returns false once
+    // everything queued has been heard.
+    virtual bool update() = 0;
+};
+
+#ifdef ECHOES_HAVE_OPENAL
+// A ring of buffers queued on an OpenAL source. The source is owned by the
+// caller and must outlive the output.
+std::unique_ptr<MusicOutput> createOpenALMusicOutput(ALuint source);
+#endif
+
+// A stream of the software mixer, which must outlive the output
+std::unique_ptr<MusicOutput> createMixerMusicOutput(MixerStream* stream);
@@ -0,0 +1,285 @@
+#include "MusicStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// How often the stream thread tops up its output. Either output holds over
+// a second of 44.1 kHz stereo, so this leaves plenty of headroom.
+const int POLL_MS = 20;
+
+} // namespace
+
+MusicStream::MusicStream(std::unique_ptr<MusicOutput> musicOutput)
+    : output(std::move(musicOutput)), quit(false), state(State::STOPPED), decoderInSync(true), format(AL_FORMAT_STEREO16),
+      sampleRate(0), blockAlign(1), position(0), looping(false), endOfStream(true),
+      gain(1.0f), fadeFrom(0.0f), fadeTarget(0.0f), fadeSeconds(0.0f), fadeElapsed(0.0f), fading(false),
+      stopAfterFade(false) {
+    thread = std::thread(&MusicStream::threadLoop, this);
+}
+
+MusicStream::~MusicStream() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    if (thread.joinable()) thread.join();
+
+    halt();
+}
+
+void MusicStream::post(const Command& command) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(command);
+    }
+    wake.notify_one();
+}
+
+bool MusicStream::readHead(const std::string& filename, MusicHead& head) {
+    std::unique_ptr<AudioDecoder> decoder = openAudioDecoder(filename);
+    if (!decoder) return false;
+
+    head.format = decoder->getFormat();
+    head.sampleRate = decoder->getSampleRate();
+    head.blockAlign = decoder->getFrameBytes();
+    head.bytes.resize(HEAD_BYTES - HEAD_BYTES % head.blockAlign);
+
+    size_t filled = 0;
+    while (filled < head.bytes.size()) {
+        size_t got = decoder->read(head.bytes.data() + filled, head.bytes.size() - filled);
+        if (got == 0) break;
+        filled += got;
+    }
+    head.bytes.resize(filled);
+    return true;
+}
+
+void MusicStream::play(const std::string& filename, float volume, bool loop,
+                       std::shared_ptr<const MusicHead> prefetched) {
+    state = State::PLAYING;
+    post({CommandType::PLAY, filename, volume, loop, 0.0f, std::move(prefetched)});
+}
+
+void MusicStream::stop() {
+    state = State::STOPPED;
+    post({CommandType::STOP, "", 0.0f, false, 0.0f, nullptr});
+}
+
+void MusicStream::pause() {
+    post({CommandType::PAUSE, "", 0.0f, false, 0.0f, nullptr});
+}
+
+void MusicStream::resume() {
+    post({CommandType::RESUME, "", 0.0f, false, 0.0f, nullptr});
+}
+
+void MusicStream::setVolume(float volume) {
+    post({CommandType::SET_VOLUME, "", volume, false, 0.0f, nullptr});
+}
+
+void MusicStream::fadeTo(float volume, float seconds, bool stopWhenDone) {
+    post({CommandType::FADE, "", volume, stopWhenDone, seconds, nullptr});
+}
+
+void MusicStream::threadLoop() {
+    auto lastTick = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quit) {
+        wake.wait_for(lock, std::chrono::milliseconds(POLL_MS),
+                      [this]() { return quit || !commands.empty(); });
+        if (quit) break;
+
+        std::deque<Command> pending;
+        pending.swap(commands);
+        lock.unlock();
+
+        for (const auto& command : pending) {
+            execute(command);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        float dt = std::chrono::duration<float>(now - lastTick).count();
+        lastTick = now;
+
+        if (state.load() == State::PLAYING) {
+            advanceFade(dt);
+        }
+        if (state.load() == State::PLAYING) {
+            service();
+        }
+
+        lock.lock();
+    }
+}
+
+void MusicStream::execute(const Command& command) {
+    switch (command.type) {
+        case CommandType::PLAY:
+            start(command);
+            break;
+        case CommandType::STOP:
+            halt();
+            state = State::STOPPED;
+            break;
+        case CommandType::PAUSE:
+            if (state.load() == State::PLAYING) {
+                output->pause();
+                state = State::PAUSED;
+            }
+            break;
+        case CommandType::RESUME:
+            if (state.load() == State::PAUSED) {
+                output->play();
+                state = State::PLAYING;
+            }
+            break;
+        case CommandType::SET_VOLUME:
+            fading = false;
+            gain = command.volume;
+            output->setGain(gain);
+            break;
+        case CommandType::FADE:
+            fadeFrom = gain;
+            fadeTarget = command.volume;
+            fadeSeconds = command.seconds;
+            fadeElapsed = 0.0f;
+            fading = true;
+            stopAfterFade = command.loop;
+            break;
+    }
+}
+
+bool MusicStream::openDecoder() {
+    decoder = openAudioDecoder(filename);
+    if (!decoder) return false;
+
+    format = decoder->getFormat();
+    sampleRate = decoder->getSampleRate();
+    blockAlign = decoder->getFrameBytes();
+    decoderInSync = position == 0;
+    return true;
+}
+
+void MusicStream::start(const Command& command) {
+    halt();
+
+    filename = command.filename;
+    head = command.head;
+    position = 0;
+
+    // With a prefetched head the first buffers come from memory and the
+    // decoder is only opened once they run out
+    if (head) {
+        format = head->format;
+        sampleRate = head->sampleRate;
+        blockAlign = head->blockAlign;
+    } else if (!openDecoder()) {
+        state = State::STOPPED;
+        return;
+    }
+
+    looping = command.loop;
+    endOfStream = false;
+    fading = false;
+    gain = command.volume;
+
+    // An empty track is noticed by service(), once the output has nothing
+    // queued: a mixer output takes no data until it has dropped the old track
+    output->reset(format, sampleRate);
+    output->setGain(gain);
+    refill();
+    output->play();
+}
+
+void MusicStream::halt() {
+    output->stop();
+    decoder.reset();
+    head.reset();
+    endOfStream = true;
+    fading = false;
+}
+
+void MusicStream::advanceFade(float dt) {
+    if (!fading) return;
+
+    fadeElapsed += dt;
+    float t = fadeSeconds > 0.0f ? std::min(fadeElapsed / fadeSeconds, 1.0f) : 1.0f;
+    gain = fadeFrom + (fadeTarget - fadeFrom) * t;
+    output->setGain(gain);
+
+    if (t >= 1.0f) {
+        fading = false;
+        if (stopAfterFade) {
+            halt();
+            state = State::STOPPED;
+        }
+    }
+}
+
+void MusicStream::refill() {
+    while (!endOfStream) {
+        uint32_t room = output->getFreeBytes();
+        if (room < blockAlign || fill(room) == 0) break;
+    }
+    if (endOfStream) output->drain();
+}
+
+void MusicStream::service() {
+    refill();
+    if (!output->update()) {
+        halt();
+        state = State::STOPPED;
+    }
+}
+
+uint32_t MusicStream::fill(uint32_t maxBytes) {
+    // Whole sample frames only
+    const uint32_t limit = std::min<uint32_t>(maxBytes, BUFFER_BYTES);
+    const uint32_t capacity = limit - limit % blockAlign;
+    uint32_t filled = 0;
+
+    while (filled < capacity) {
+        // Serve the prefetched opening from memory, the rest from the decoder
+        uint64_t headSize = head ? head->bytes.size() : 0;
+        if (position < headSize) {
+            uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(capacity - filled, headSize - position));
+            std::memcpy(chunk + filled, head->bytes.data() + position, count);
+            filled += count;
+            position += count;
+            decoderInSync = false;
+            continue;
+        }
+
+        if (!decoder && !openDecoder()) {
+            endOfStream = true;
+            break;
+        }
+        if (!decoderInSync) {
+            decoder->seek(position / blockAlign);
+            decoderInSync = true;
+        }
+
+        size_t got = decoder->read(chunk + filled, capacity - filled);
+        if (got == 0) {
+            // Looping is done by rewinding the reader, not by the output
+            if (!looping || position == 0) {
+                endOfStream = true;
+                break;
+            }
+            position = 0;
+            decoderInSync = false;
+            continue;
+        }
+        filled += static_cast<uint32_t>(got);
+        position += got;
+    }
+
+    filled -= filled % blockAlign;
+    if (filled > 0) output->queue(chunk, filled);
+    return filled;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "AudioDecoder.h"
+#include "MusicOutput.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The decoded opening of a music track, read ahead of time so playback can
+// start from memory while the file itself is still being opened
+struct MusicHead {
+    ALenum format;
+    ALsizei sampleRate;
+    uint32_t blockAlign;
+    std::vector<char> bytes;        // first decoded bytes of the track
+};
+
+// Plays one music track at a time from disk into a MusicOutput: queued
+// OpenAL buffers or a software mixer stream. A background thread opens and
+// decodes the file (WAV or Ogg Vorbis) and tops the output up as it drains,
+// so the caller never blocks on I/O or decoding.
+class MusicStream {
+private:
+    static const int BUFFER_BYTES = MUSIC_CHUNK_BYTES;
+
+    enum class CommandType {
+        PLAY,
+        STOP,
+        PAUSE,
+        RESUME,
+        SET_VOLUME,
+        FADE
+    };
+
+    struct Command {
+        CommandType type;
+        std::string filename;
+        float volume;
+        bool loop;
+        float seconds;
+        std::shared_ptr<const MusicHead> head;
+    };
+
+    enum class State {
+        STOPPED,
+        PLAYING,
+        PAUSED
+    };
+
+    std::unique_ptr<MusicOutput> output;
+
+    // Commands posted by the game thread, drained by the stream thread
+    std::deque<Command> commands;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit;
+    std::thread thread;
+
+    // Stream thread state
+    std::atomic<State> state;
+    std::string filename;
+    std::unique_ptr<AudioDecoder> decoder;   // opened lazily when a head is given
+    std::shared_ptr<const MusicHead> head;
+    bool decoderInSync;             // decoder position matches `position`
+    ALenum format;
+    ALsizei sampleRate;
+    uint32_t blockAlign;
+    uint64_t position;              // decoded bytes from the start of the track
+    bool looping;
+    bool endOfStream;
+    char chunk[BUFFER_BYTES];
+
+    // Gain ramp, advanced by the stream thread
+    float gain;
+    float fadeFrom;
+    float fadeTarget;
+    float fadeSeconds;
+    float fadeElapsed;
+    bool fading;
+    bool stopAfterFade;
+
+    void threadLoop();
+    void execute(const Command& command);
+    bool openDecoder();
+    void start(const Command& command);
+    void halt();
+    void refill();
+    void service();
+    void advanceFade(float dt);
+    uint32_t fill(uint32_t maxBytes);
+    void post(const Command& command);
+
+public:
+    explicit MusicStream(std::unique_ptr<MusicOutput> musicOutput);
+    ~MusicStream();
+
+    MusicStream(const MusicStream&) = delete;
+    MusicStream& operator=(const MusicStream&) = delete;
+
+    // Bytes of sample data worth prefetching: enough to fill an OpenAL
+    // output's whole queue
+    static const int HEAD_BYTES = MUSIC_QUEUE_CHUNKS * BUFFER_BYTES;
+
+    // Decode the first HEAD_BYTES of a track. Safe to call from any thread.
+    static bool readHead(const std::string& filename, MusicHead& head);
+
+    // All requests return immediately; the stream thread carries them out.
+    // A head from readHead() for the same file lets playback start at once.
+    void play(const std::string& filename, float volume, bool loop,
+              std::shared_ptr<const MusicHead> prefetched = nullptr);
+    void stop();
+    void pause();
+    void resume();
+    void setVolume(float volume);
+
+    // Ramp the gain to volume over seconds, optionally stopping at the end
+    void fadeTo(float volume, float seconds, bool stopWhenDone);
+
+    bool isPlaying() const { return state.load() == State::PLAYING; }
+};
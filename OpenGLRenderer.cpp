@@ -2,19 +2,18 @@
 #include "Camera.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "InputSystem.h"
 #include <iostream>
 
 // Initialize static members
-bool OpenGLRenderer::keys[1024] = {false};
-bool OpenGLRenderer::firstMouse = true;
-float OpenGLRenderer::lastX = 512.0f;
-float OpenGLRenderer::lastY = 384.0f;
 float OpenGLRenderer::deltaTime = 0.0f;
 float OpenGLRenderer::lastFrame = 0.0f;
 
 OpenGLRenderer::OpenGLRenderer(int width, int height)
     : window(nullptr), windowWidth(width), windowHeight(height),
-      lightPos(0.0f, 5.0f, 0.0f), lightColor(1.0f, 1.0f, 0.9f), lightIntensity(1.0f) {
+      viewMatrix(1.0f), projectionMatrix(1.0f),
+      lightPos(0.0f, 5.0f, 0.0f), lightColor(1.0f, 1.0f, 0.9f), lightIntensity(1.0f),
+      input(std::make_unique<InputSystem>()) {
 }
 
 OpenGLRenderer::~OpenGLRenderer() {
@@ -72,6 +71,7 @@ bool OpenGLRenderer::initializeOpenGL() {
     glfwSetKeyCallback(window, keyCallback);
     glfwSetCursorPosCallback(window, mouseCallback);
     glfwSetScrollCallback(window, scrollCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
     
     // Capture mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -206,7 +206,14 @@ void OpenGLRenderer::render() {
     glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    // Setup matrices
+    // Setup matrices - camera orientation is latched as late as possible
+    latchCameraInput();
+    glm::mat4 view = camera->getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(camera->getZoom()),
+                                            (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
+    viewMatrix = view;
+    projectionMatrix = projection;
+    
     float time = (float)glfwGetTime();
 
 glm::mat4 model = glm::mat4(1.0f);
@@ -235,21 +242,24 @@ model = glm::rotate(
 }
 
 void OpenGLRenderer::update(float dt) {
+    // Camera movement is driven by the game from the input system;
+    // the renderer only owns orientation, which is latched in render()
     deltaTime = dt;
+}
+
+void OpenGLRenderer::latchCameraInput() {
+    if (!camera || !input) return;
+    
+    // Pick up anything the OS delivered while the frame was simulating
+    glfwPollEvents();
     
-    // Handle keyboard input for camera
-    if (keys[GLFW_KEY_W])
-        camera->processKeyboard(FORWARD, dt);
-    if (keys[GLFW_KEY_S])
-        camera->processKeyboard(BACKWARD, dt);
-    if (keys[GLFW_KEY_A])
-        camera->processKeyboard(LEFT, dt);
-    if (keys[GLFW_KEY_D])
-        camera->processKeyboard(RIGHT, dt);
-    if (keys[GLFW_KEY_SPACE])
-        camera->processKeyboard(UP, dt);
-    if (keys[GLFW_KEY_LEFT_SHIFT])
-        camera->processKeyboard(DOWN, dt);
+    float dx, dy, scroll;
+    if (input->latchLook(dx, dy, scroll)) {
+        camera->processMouseMovement(dx, dy);
+        if (scroll != 0.0f) {
+            camera->processMouseScroll(scroll);
+        }
+    }
 }
 
 void OpenGLRenderer::cleanup() {
@@ -283,38 +293,30 @@ void OpenGLRenderer::keyCallback(GLFWwindow* window, int key, int scancode, int
         glfwSetWindowShouldClose(window, GL_TRUE);
     }
     
-    if (key >= 0 && key < 1024) {
-        if (action == GLFW_PRESS)
-            keys[key] = true;
-        else if (action == GLFW_RELEASE)
-            keys[key] = false;
+    OpenGLRenderer* renderer = static_cast<OpenGLRenderer*>(glfwGetWindowUserPointer(window));
+    if (renderer && renderer->input) {
+        renderer->input->pushKey(key, action, glfwGetTime());
     }
 }
 
 void OpenGLRenderer::mouseCallback(GLFWwindow* window, double xpos, double ypos) {
-    if (firstMouse) {
-        lastX = xpos;
-        lastY = ypos;
-        firstMouse = false;
-    }
-    
-    float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos; // Reversed since y-coordinates go from bottom to top
-    
-    lastX = xpos;
-    lastY = ypos;
-    
-    // Get camera from user pointer
     OpenGLRenderer* renderer = static_cast<OpenGLRenderer*>(glfwGetWindowUserPointer(window));
-    if (renderer && renderer->camera) {
-        renderer->camera->processMouseMovement(xoffset, yoffset);
+    if (renderer && renderer->input) {
+        renderer->input->pushCursor(xpos, ypos, glfwGetTime());
     }
 }
 
 void OpenGLRenderer::scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     OpenGLRenderer* renderer = static_cast<OpenGLRenderer*>(glfwGetWindowUserPointer(window));
-    if (renderer && renderer->camera) {
-        renderer->camera->processMouseScroll(yoffset);
+    if (renderer && renderer->input) {
+        renderer->input->pushScroll(xoffset, yoffset, glfwGetTime());
+    }
+}
+
+void OpenGLRenderer::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    OpenGLRenderer* renderer = static_cast<OpenGLRenderer*>(glfwGetWindowUserPointer(window));
+    if (renderer && renderer->input) {
+        renderer->input->pushMouseButton(button, action, glfwGetTime());
     }
 }
 
@@ -12,6 +12,7 @@
 class Camera;
 class Mesh;
 class Shader;
+class InputSystem;
 
 class OpenGLRenderer {
 private:
@@ -21,6 +22,8 @@ private:
     
     // Camera
     std::unique_ptr<Camera> camera;
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
     
     // Shaders
     std::unique_ptr<Shader> basicShader;
@@ -35,9 +38,7 @@ private:
     std::vector<std::shared_ptr<Mesh>> sceneMeshes;
     
     // Input handling
-    static bool keys[1024];
-    static bool firstMouse;
-    static float lastX, lastY;
+    std::unique_ptr<InputSystem> input;
     static float deltaTime;
     static float lastFrame;
     
@@ -62,6 +63,10 @@ public:
     static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mode);
     static void mouseCallback(GLFWwindow* window, double xpos, double ypos);
     static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+    
+    // Apply the latest mouse look to the camera right before the view matrix is built
+    void latchCameraInput();
     
     // Scene management
     void addMesh(std::shared_ptr<Mesh> mesh);
@@ -77,4 +82,7 @@ public:
     
     GLFWwindow* getWindow() const { return window; }
     Camera* getCamera() const { return camera.get(); }
+    InputSystem* getInput() const { return input.get(); }
+    const glm::mat4& getViewMatrix() const { return viewMatrix; }
+    const glm::mat4& getProjectionMatrix() const { return projectionMatrix; }
 };
@@ -0,0 +1,83 @@
+#include "ParticleBudget.h"
+#include <algorithm>
+#include <cmath>
+
+ParticleBudget::ParticleBudget()
+    : viewerPosition(0.0f), pixelScale(0.0f), fullDetailDistance(15.0f), cullDistance(60.0f),
+      minPixelSize(1.5f) {
+    priorities[static_cast<int>(EffectCategory::AMBIENT)] = 0;
+    priorities[static_cast<int>(EffectCategory::FEEDBACK)] = 1;
+    priorities[static_cast<int>(EffectCategory::COMBAT)] = 2;
+    resetCounts();
+}
+
+void ParticleBudget::setViewer(const glm::mat4& view, const glm::mat4& projection, int viewportHeight) {
+    // Camera position is -R^T * t for a rigid view matrix
+    for (int i = 0; i < 3; ++i) {
+        viewerPosition[i] = -(view[i][0] * view[3][0] + view[i][1] * view[3][1] + view[i][2] * view[3][2]);
+    }
+    pixelScale = viewportHeight * projection[1][1] * 0.5f;
+}
+
+int ParticleBudget::scaleEmission(EffectCategory category, int requested, const glm::vec3& position,
+                                  float particleSize) {
+    if (requested <= 0) return 0;
+    
+    glm::vec3 offset = position - viewerPosition;
+    float distance = std::sqrt(glm::dot(offset, offset));
+    
+    // Linear falloff between the full detail and cull distances
+    float scale = 1.0f;
+    if (distance >= cullDistance) {
+        scale = 0.0f;
+    } else if (distance > fullDetailDistance) {
+        scale = (cullDistance - distance) / (cullDistance - fullDetailDistance);
+    }
+    
+    // Particles that project to less than a couple of pixels barely read on
+    // screen; spawn proportionally fewer of them
+    if (pixelScale > 0.0f && distance > 0.0f) {
+        float pixels = particleSize * pixelScale / distance;
+        if (pixels < minPixelSize) {
+            scale *= pixels / minPixelSize;
+        }
+    }
+    
+    int index = static_cast<int>(category);
+    float wanted = requested * scale + carry[index];
+    int count = static_cast<int>(wanted);
+    carry[index] = std::min(wanted - count, 1.0f);
+    return std::min(count, requested);
+}
+
+int ParticleBudget::getEvictionOrder(EffectCategory category, EffectCategory* out) const {
+    int priority = getPriority(category);
+    int count = 0;
+    
+    for (int c = 0; c < CATEGORY_COUNT; ++c) {
+        if (priorities[c] < priority) {
+            out[count++] = static_cast<EffectCategory>(c);
+        }
+    }
+    
+    std::sort(out, out + count, [this](EffectCategory a, EffectCategory b) {
+        return getPriority(a) < getPriority(b);
+    });
+    return count;
+}
+
+void ParticleBudget::setPriority(EffectCategory category, int priority) {
+    priorities[static_cast<int>(category)] = priority;
+}
+
+void ParticleBudget::setDistanceRange(float fullDetail, float cull) {
+    fullDetailDistance = fullDetail;
+    cullDistance = std::max(cull, fullDetail + 0.001f);
+}
+
+void ParticleBudget::resetCounts() {
+    for (int c = 0; c < CATEGORY_COUNT; ++c) {
+        liveCounts[c] = 0;
+        carry[c] = 0.0f;
+    }
+}
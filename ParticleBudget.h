@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ParticleEffects.h"
+#include <glm/glm.hpp>
+
+// Decides how much of a requested emission is worth spawning and which
+// categories give way when the particle pool is full. Higher priority
+// categories may evict particles of strictly lower priority.
+class ParticleBudget {
+private:
+    static const int CATEGORY_COUNT = static_cast<int>(EffectCategory::COUNT);
+    
+    int priorities[CATEGORY_COUNT];
+    int liveCounts[CATEGORY_COUNT];
+    
+    // Fractional particles carried between scaled emissions so small bursts
+    // at a distance still spawn something over time
+    float carry[CATEGORY_COUNT];
+    
+    // Viewer, refreshed once per frame from the render matrices
+    glm::vec3 viewerPosition;
+    float pixelScale;           // projected pixels per world unit at distance 1
+    
+    // Distance and screen coverage throttling
+    float fullDetailDistance;
+    float cullDistance;
+    float minPixelSize;
+    
+public:
+    ParticleBudget();
+    
+    void setViewer(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+    
+    // Number of particles to actually spawn for a burst of requested size
+    int scaleEmission(EffectCategory category, int requested, const glm::vec3& position, float particleSize);
+    
+    // Categories that may be evicted to make room for the given one, lowest
+    // priority first. Returns how many were written to out.
+    int getEvictionOrder(EffectCategory category, EffectCategory* out) const;
+    
+    // Priority
+    void setPriority(EffectCategory category, int priority);
+    int getPriority(EffectCategory category) const { return priorities[static_cast<int>(category)]; }
+    
+    // Distance thresholds: full emission up to fullDetail, none beyond cull
+    void setDistanceRange(float fullDetail, float cull);
+    void setMinPixelSize(float pixels) { minPixelSize = pixels; }
+    
+    // Live counts, maintained by ParticleSystem
+    void onSpawned(EffectCategory category, int count) { liveCounts[static_cast<int>(category)] += count; }
+    void onRemoved(EffectCategory category, int count) { liveCounts[static_cast<int>(category)] -= count; }
+    void resetCounts();
+    int getLiveCount(EffectCategory category) const { return liveCounts[static_cast<int>(category)]; }
+};
@@ -0,0 +1,149 @@
+#include "ParticleEffects.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+EmitterDescriptor::EmitterDescriptor()
+    : category(EffectCategory::AMBIENT), shape(EmitterShape::RADIAL), speedMin(1.0f), speedMax(1.0f),
+      upMin(0.0f), upMax(0.0f), upFromSpeed(0.0f), spread(0.0f), coneAxis(0.0f, 1.0f, 0.0f), coneAngle(0.5f),
+      colorStart(1.0f), colorEnd(1.0f), lifeMin(1.0f), lifeMax(1.0f), sizeMin(0.1f), sizeMax(0.1f),
+      burstCount(10), spawnRate(0.0f) {}
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// "a" or "a b"; a single value gives a constant range
+bool parseRange(const std::string& value, float& minValue, float& maxValue) {
+    std::istringstream stream(value);
+    if (!(stream >> minValue)) return false;
+    if (!(stream >> maxValue)) maxValue = minValue;
+    return true;
+}
+
+bool parseColor(const std::string& value, glm::vec4& color) {
+    std::istringstream stream(value);
+    if (!(stream >> color.r >> color.g >> color.b)) return false;
+    if (!(stream >> color.a)) color.a = 1.0f;
+    return true;
+}
+
+} // namespace
+
+bool ParticleEffectLibrary::parseProperty(EmitterDescriptor& d, const std::string& key,
+                                          const std::string& value) {
+    std::istringstream stream(value);
+
+    if (key == "category") {
+        if (value == "ambient") d.category = EffectCategory::AMBIENT;
+        else if (value == "feedback") d.category = EffectCategory::FEEDBACK;
+        else if (value == "combat") d.category = EffectCategory::COMBAT;
+        else return false;
+        return true;
+    }
+    if (key == "shape") {
+        if (value == "radial") d.shape = EmitterShape::RADIAL;
+        else if (value == "spread") d.shape = EmitterShape::SPREAD;
+        else if (value == "cone") d.shape = EmitterShape::CONE;
+        else return false;
+        return true;
+    }
+    if (key == "speed") return parseRange(value, d.speedMin, d.speedMax);
+    if (key == "up") return parseRange(value, d.upMin, d.upMax);
+    if (key == "up_from_speed") return static_cast<bool>(stream >> d.upFromSpeed);
+    if (key == "spread") return static_cast<bool>(stream >> d.spread);
+    if (key == "cone_axis") {
+        if (!(stream >> d.coneAxis.x >> d.coneAxis.y >> d.coneAxis.z)) return false;
+        float length = std::sqrt(glm::dot(d.coneAxis, d.coneAxis));
+        if (length <= 0.0f) return false;
+        d.coneAxis /= length;
+        return true;
+    }
+    if (key == "cone_angle") {
+        float degrees;
+        if (!(stream >> degrees)) return false;
+        d.coneAngle = degrees * 3.14159265f / 180.0f;
+        return true;
+    }
+    if (key == "color") {
+        if (!parseColor(value, d.colorStart)) return false;
+        d.colorEnd = d.colorStart;
+        return true;
+    }
+    if (key == "color_start") return parseColor(value, d.colorStart);
+    if (key == "color_end") return parseColor(value, d.colorEnd);
+    if (key == "lifetime") return parseRange(value, d.lifeMin, d.lifeMax);
+    if (key == "size") return parseRange(value, d.sizeMin, d.sizeMax);
+    if (key == "burst") return static_cast<bool>(stream >> d.burstCount);
+    if (key == "rate") return static_cast<bool>(stream >> d.spawnRate);
+
+    return false;
+}
+
+void ParticleEffectLibrary::add(const EmitterDescriptor& descriptor) {
+    auto it = indexByName.find(descriptor.name);
+    if (it != indexByName.end()) {
+        // Later definitions replace earlier ones
+        descriptors[it->second] = descriptor;
+        return;
+    }
+    indexByName[descriptor.name] = static_cast<int>(descriptors.size());
+    descriptors.push_back(descriptor);
+}
+
+bool ParticleEffectLibrary::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open particle effects file: " << filename << std::endl;
+        return false;
+    }
+
+    EmitterDescriptor current;
+    bool hasCurrent = false;
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        if (line.front() == '[' && line.back() == ']') {
+            if (hasCurrent) add(current);
+            current = EmitterDescriptor();
+            current.name = trim(line.substr(1, line.size() - 2));
+            hasCurrent = true;
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (!hasCurrent || equals == std::string::npos) {
+            std::cerr << filename << ":" << lineNumber << ": expected [effect] or key = value" << std::endl;
+            continue;
+        }
+
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        if (!parseProperty(current, key, value)) {
+            std::cerr << filename << ":" << lineNumber << ": invalid '" << key << "' in effect "
+                      << current.name << std::endl;
+        }
+    }
+
+    if (hasCurrent) add(current);
+    return true;
+}
+
+int ParticleEffectLibrary::find(const std::string& name) const {
+    auto it = indexByName.find(name);
+    return it != indexByName.end() ? it->second : -1;
+}
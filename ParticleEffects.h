@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// How an emitter picks the initial velocity of each particle
+enum class EmitterShape {
+    RADIAL,     // random horizontal direction, speed range, plus an upward component
+    SPREAD,     // independent horizontal jitter on x/z and an upward speed range
+    CONE        // random direction inside a cone around an axis
+};
+
+// Budget category of an effect; see ParticleBudget for the priorities
+enum class EffectCategory {
+    AMBIENT,    // environmental dust, drips, smoke
+    FEEDBACK,   // pickups, interaction sparkles
+    COMBAT,     // blood, hits
+    COUNT
+};
+
+// Data-driven description of a particle effect, loaded from particle_effects.cfg
+struct EmitterDescriptor {
+    std::string name;
+    EffectCategory category;
+    EmitterShape shape;
+
+    // Velocity
+    float speedMin, speedMax;   // RADIAL: horizontal speed, CONE: speed along the direction
+    float upMin, upMax;         // RADIAL/SPREAD: vertical speed
+    float upFromSpeed;          // RADIAL: extra vertical speed per unit of horizontal speed
+    float spread;               // SPREAD: horizontal velocity in [-spread, spread]
+    glm::vec3 coneAxis;
+    float coneAngle;            // CONE: half angle in radians
+
+    // Appearance: each particle takes a random point on the start-end colour ramp
+    glm::vec4 colorStart;
+    glm::vec4 colorEnd;
+    float lifeMin, lifeMax;
+    float sizeMin, sizeMax;
+
+    // Emission
+    int burstCount;             // particles per burst when no count is given
+    float spawnRate;            // particles per second for continuous emitters
+
+    EmitterDescriptor();
+};
+
+// Named set of emitter descriptors
+class ParticleEffectLibrary {
+private:
+    std::vector<EmitterDescriptor> descriptors;
+    std::unordered_map<std::string, int> indexByName;
+
+    bool parseProperty(EmitterDescriptor& descriptor, const std::string& key,
+                       const std::string& value);
+    void add(const EmitterDescriptor& descriptor);
+
+public:
+    // Format: "[name]" starts an effect, followed by "key = value" lines.
+    // '#' starts a comment. See particle_effects.cfg for the keys.
+    bool loadFromFile(const std::string& filename);
+
+    // Returns -1 if no effect has that name
+    int find(const std::string& name) const;
+    const EmitterDescriptor& get(int id) const { return descriptors[id]; }
+    int getCount() const { return static_cast<int>(descriptors.size()); }
+};
@@ -0,0 +1,240 @@
+#include "ParticleKernels.h"
+#include "CpuFeatures.h"
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PARTICLE_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define PARTICLE_TARGET_SSE41
+#define PARTICLE_TARGET_AVX2
+#else
+#define PARTICLE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define PARTICLE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+const float GRAVITY = 9.8f;
+const float JITTER_SCALE = 0.5f;
+
+inline uint32_t xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Uniform float in [-0.5, 0.5) from the top 23 bits of a random word
+inline float jitterFromBits(uint32_t bits) {
+    union { uint32_t u; float f; } conv;
+    conv.u = (bits >> 9) | 0x3F800000u;
+    return conv.f - 1.5f;
+}
+
+void integrateScalar(const ParticleStreams& s, int begin, int end, float dt, ParticleRng& rng) {
+    const float gravity = GRAVITY * dt;
+    const float jitter = dt * JITTER_SCALE;
+
+    for (int i = begin; i < end; ++i) {
+        uint32_t& lane = rng.lanes[(i - begin) & 7];
+
+        s.life[i] -= dt;
+        s.posX[i] += s.velX[i] * dt;
+        s.posY[i] += s.velY[i] * dt;
+        s.posZ[i] += s.velZ[i] * dt;
+        s.velY[i] -= gravity;
+        s.colA[i] = s.life[i];
+
+        float jx = jitterFromBits(xorshift(lane));
+        float jz = jitterFromBits(xorshift(lane));
+        s.velX[i] += jx * jitter;
+        s.velZ[i] += jz * jitter;
+    }
+}
+
+#ifdef PARTICLE_KERNELS_X86
+
+PARTICLE_TARGET_SSE41
+inline __m128i xorshiftSSE(__m128i& state) {
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+    return state;
+}
+
+PARTICLE_TARGET_SSE41
+inline __m128 jitterSSE(__m128i bits) {
+    __m128i mantissa = _mm_or_si128(_mm_srli_epi32(bits, 9), _mm_set1_epi32(0x3F800000));
+    return _mm_sub_ps(_mm_castsi128_ps(mantissa), _mm_set1_ps(1.5f));
+}
+
+// Processes 8 particles per step as two 4-wide halves
+PARTICLE_TARGET_SSE41
+void integrateSSE41(const ParticleStreams& s, int begin, int end, float dt, ParticleRng& rng) {
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vgravity = _mm_set1_ps(GRAVITY * dt);
+    const __m128 vjitter = _mm_set1_ps(dt * JITTER_SCALE);
+
+    __m128i laneLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rng.lanes[0]));
+    __m128i laneHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rng.lanes[4]));
+
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        for (int half = 0; half < 2; ++half) {
+            int j = i + half * 4;
+            __m128i& lane = half == 0 ? laneLo : laneHi;
+
+            __m128 life = _mm_sub_ps(_mm_loadu_ps(s.life + j), vdt);
+            __m128 vx = _mm_loadu_ps(s.velX + j);
+            __m128 vy = _mm_loadu_ps(s.velY + j);
+            __m128 vz = _mm_loadu_ps(s.velZ + j);
+
+            _mm_storeu_ps(s.posX + j, _mm_add_ps(_mm_loadu_ps(s.posX + j), _mm_mul_ps(vx, vdt)));
+            _mm_storeu_ps(s.posY + j, _mm_add_ps(_mm_loadu_ps(s.posY + j), _mm_mul_ps(vy, vdt)));
+            _mm_storeu_ps(s.posZ + j, _mm_add_ps(_mm_loadu_ps(s.posZ + j), _mm_mul_ps(vz, vdt)));
+
+            __m128 jx = jitterSSE(xorshiftSSE(lane));
+            __m128 jz = jitterSSE(xorshiftSSE(lane));
+
+            _mm_storeu_ps(s.velX + j, _mm_add_ps(vx, _mm_mul_ps(jx, vjitter)));
+            _mm_storeu_ps(s.velY + j, _mm_sub_ps(vy, vgravity));
+            _mm_storeu_ps(s.velZ + j, _mm_add_ps(vz, _mm_mul_ps(jz, vjitter)));
+            _mm_storeu_ps(s.life + j, life);
+            _mm_storeu_ps(s.colA + j, life);
+        }
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&rng.lanes[0]), laneLo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&rng.lanes[4]), laneHi);
+
+    // Tail keeps the same lane mapping as the vector body
+    integrateScalar(s, i, end, dt, rng);
+}
+
+PARTICLE_TARGET_AVX2
+inline __m256i xorshiftAVX2(__m256i& state) {
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+    state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+    return state;
+}
+
+PARTICLE_TARGET_AVX2
+inline __m256 jitterAVX2(__m256i bits) {
+    __m256i mantissa = _mm256_or_si256(_mm256_srli_epi32(bits, 9), _mm256_set1_epi32(0x3F800000));
+    return _mm256_sub_ps(_mm256_castsi256_ps(mantissa), _mm256_set1_ps(1.5f));
+}
+
+PARTICLE_TARGET_AVX2
+void integrateAVX2(const ParticleStreams& s, int begin, int end, float dt, ParticleRng& rng) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 vgravity = _mm256_set1_ps(GRAVITY * dt);
+    const __m256 vjitter = _mm256_set1_ps(dt * JITTER_SCALE);
+
+    __m256i lane = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rng.lanes));
+
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 life = _mm256_sub_ps(_mm256_loadu_ps(s.life + i), vdt);
+        __m256 vx = _mm256_loadu_ps(s.velX + i);
+        __m256 vy = _mm256_loadu_ps(s.velY + i);
+        __m256 vz = _mm256_loadu_ps(s.velZ + i);
+
+        // Explicit mul + add (no FMA) so results match the scalar path bit for bit
+        _mm256_storeu_ps(s.posX + i, _mm256_add_ps(_mm256_loadu_ps(s.posX + i), _mm256_mul_ps(vx, vdt)));
+        _mm256_storeu_ps(s.posY + i, _mm256_add_ps(_mm256_loadu_ps(s.posY + i), _mm256_mul_ps(vy, vdt)));
+        _mm256_storeu_ps(s.posZ + i, _mm256_add_ps(_mm256_loadu_ps(s.posZ + i), _mm256_mul_ps(vz, vdt)));
+
+        __m256 jx = jitterAVX2(xorshiftAVX2(lane));
+        __m256 jz = jitterAVX2(xorshiftAVX2(lane));
+
+        _mm256_storeu_ps(s.velX + i, _mm256_add_ps(vx, _mm256_mul_ps(jx, vjitter)));
+        _mm256_storeu_ps(s.velY + i, _mm256_sub_ps(vy, vgravity));
+        _mm256_storeu_ps(s.velZ + i, _mm256_add_ps(vz, _mm256_mul_ps(jz, vjitter)));
+        _mm256_storeu_ps(s.life + i, life);
+        _mm256_storeu_ps(s.colA + i, life);
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rng.lanes), lane);
+
+    integrateScalar(s, i, end, dt, rng);
+}
+
+#endif // PARTICLE_KERNELS_X86
+
+ParticleKernelLevel detectBestLevel() {
+    if (isParticleKernelLevelSupported(ParticleKernelLevel::AVX2)) return ParticleKernelLevel::AVX2;
+    if (isParticleKernelLevelSupported(ParticleKernelLevel::SSE41)) return ParticleKernelLevel::SSE41;
+    return ParticleKernelLevel::SCALAR;
+}
+
+// -1 means "use the detected level"; kernels may be called from worker threads
+std::atomic<int> forcedLevel(-1);
+
+ParticleKernelLevel currentLevel() {
+    static const ParticleKernelLevel best = detectBestLevel();
+    int forced = forcedLevel.load(std::memory_order_relaxed);
+    return forced >= 0 ? static_cast<ParticleKernelLevel>(forced) : best;
+}
+
+} // namespace
+
+void ParticleRng::seed(uint32_t seedValue) {
+    // Spread one seed over the lanes with a splitmix-style mixer; xorshift
+    // must never start from zero
+    uint32_t x = seedValue;
+    for (int i = 0; i < 8; ++i) {
+        x += 0x9E3779B9u;
+        uint32_t z = x;
+        z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+        z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+        z ^= z >> 16;
+        lanes[i] = z != 0 ? z : 0x6D2B79F5u;
+    }
+}
+
+void integrateParticles(const ParticleStreams& streams, int begin, int end, float deltaTime, ParticleRng& rng) {
+    if (end <= begin) return;
+
+    switch (currentLevel()) {
+#ifdef PARTICLE_KERNELS_X86
+        case ParticleKernelLevel::AVX2:
+            integrateAVX2(streams, begin, end, deltaTime, rng);
+            return;
+        case ParticleKernelLevel::SSE41:
+            integrateSSE41(streams, begin, end, deltaTime, rng);
+            return;
+#endif
+        default:
+            integrateScalar(streams, begin, end, deltaTime, rng);
+            return;
+    }
+}
+
+ParticleKernelLevel getParticleKernelLevel() {
+    return currentLevel();
+}
+
+bool setParticleKernelLevel(ParticleKernelLevel level) {
+    if (!isParticleKernelLevelSupported(level)) return false;
+    forcedLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    return true;
+}
+
+bool isParticleKernelLevelSupported(ParticleKernelLevel level) {
+    switch (level) {
+        case ParticleKernelLevel::AVX2: return cpuHasAVX2();
+        case ParticleKernelLevel::SSE41: return cpuHasSSE41();
+        default: return true;
+    }
+}
+
+const char* getParticleKernelName(ParticleKernelLevel level) {
+    switch (level) {
+        case ParticleKernelLevel::AVX2: return "AVX2";
+        case ParticleKernelLevel::SSE41: return "SSE4.1";
+        default: return "Scalar";
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+// Raw pointers into the structure-of-arrays particle storage.
+// Kept free of GL/glm so the kernels can be built and benchmarked standalone.
+struct ParticleStreams {
+    float* posX;
+    float* posY;
+    float* posZ;
+    float* velX;
+    float* velY;
+    float* velZ;
+    float* colA;
+    float* life;
+};
+
+// Eight independent xorshift32 lanes used for the per-particle jitter.
+// Particle i of a batch always draws from lane (i % 8), so every kernel
+// level produces the same sequence.
+struct ParticleRng {
+    uint32_t lanes[8];
+
+    void seed(uint32_t seedValue);
+};
+
+enum class ParticleKernelLevel {
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+// Advance particles [begin, end): age, move, apply gravity, fade alpha and add
+// jitter. Particles that expire are left in place for the caller to compact.
+void integrateParticles(const ParticleStreams& streams, int begin, int end, float deltaTime, ParticleRng& rng);
+
+// Runtime dispatch. The best level supported by the CPU is picked on first use;
+// forcing a level is meant for benchmarks and comparisons.
+ParticleKernelLevel getParticleKernelLevel();
+bool setParticleKernelLevel(ParticleKernelLevel level);
+bool isParticleKernelLevelSupported(ParticleKernelLevel level);
+const char* getParticleKernelName(ParticleKernelLevel level);
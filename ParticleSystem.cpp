@@ -3,226 +3,701 @@
 #include <GL/glew.h>
 #include <algorithm>
 #include <cmath>
+#include <iostream>
 #include <random>
 
-ParticleSystem::ParticleSystem(int maxCount) 
-    : maxParticles(maxCount), VAO(0), VBO(0), initialized(false) {
-    particles.reserve(maxParticles);
+ParticleSystem::ParticleSystem(int maxCount, ParticleBackend requestedBackend) 
+    : backend(requestedBackend), activeCount(0), maxParticles(maxCount), rngSeed(0), currentJobs(nullptr),
+      updateInFlight(false), chunkCount(0), simulatedCount(0), VAO(0), VBO(0), quadVBO(0), initialized(false) {
+    std::fill(std::begin(typeEffects), std::end(typeEffects), -1);
+    
+    // The GPU backend keeps no per-particle data on the CPU
+    if (backend == ParticleBackend::CPU) {
+        allocateCpuStorage();
+    }
 }
 
 ParticleSystem::~ParticleSystem() {
+    finishUpdate();
     if (VAO != 0) glDeleteVertexArrays(1, &VAO);
     if (VBO != 0) glDeleteBuffers(1, &VBO);
+    if (quadVBO != 0) glDeleteBuffers(1, &quadVBO);
+}
+
+void ParticleSystem::allocateCpuStorage() {
+    posX.resize(maxParticles); posY.resize(maxParticles); posZ.resize(maxParticles);
+    velX.resize(maxParticles); velY.resize(maxParticles); velZ.resize(maxParticles);
+    colR.resize(maxParticles); colG.resize(maxParticles); colB.resize(maxParticles); colA.resize(maxParticles);
+    lives.resize(maxParticles);
+    sizes.resize(maxParticles);
+    categories.resize(maxParticles);
+    renderStream.resize(maxParticles);
+    
+    std::random_device rd;
+    rngSeed = rd();
+    
+    int maxChunks = (maxParticles + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkLive.resize(maxChunks);
+    chunkDeaths.resize(maxChunks * static_cast<int>(EffectCategory::COUNT));
+    chunkRngs.resize(maxChunks);
+    for (int c = 0; c < maxChunks; ++c) {
+        chunkRngs[c].seed(rngSeed + c * 0x9E3779B9u);
+    }
 }
 
 void ParticleSystem::initialize() {
+    if (backend == ParticleBackend::GPU) {
+        gpuSimulator = std::make_unique<GpuParticleSimulator>(maxParticles);
+        if (gpuSimulator->initialize()) {
+            initialized = true;
+            return;
+        }
+        std::cerr << "GPU particle simulation unavailable, falling back to CPU" << std::endl;
+        gpuSimulator.reset();
+        backend = ParticleBackend::CPU;
+        allocateCpuStorage();
+    }
+    
     initializeBuffers();
+    createBillboardShader();
     initialized = true;
 }
 
+namespace {
+
+const char* BILLBOARD_VERTEX_SHADER = R"(
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in vec3 aCenter;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in float aSize;
+
+out vec4 vColor;
+out vec2 vCorner;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    // Camera right and up are the first two rows of the view rotation
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 worldPos = aCenter + (right * aCorner.x + up * aCorner.y) * aSize;
+    
+    vColor = aColor;
+    vCorner = aCorner * 2.0;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
+)";
+
+const char* BILLBOARD_FRAGMENT_SHADER = R"(
+#version 330 core
+in vec4 vColor;
+in vec2 vCorner;
+out vec4 FragColor;
+
+void main() {
+    // Soft round sprite
+    float falloff = 1.0 - smoothstep(0.6, 1.0, length(vCorner));
+    if (falloff <= 0.0) discard;
+    FragColor = vec4(vColor.rgb, vColor.a * falloff);
+}
+)";
+
+// Unit quad as a triangle strip, scaled by the particle size in the shader
+const float QUAD_CORNERS[] = {
+    -0.5f, -0.5f,
+     0.5f, -0.5f,
+    -0.5f,  0.5f,
+     0.5f,  0.5f
+};
+
+} // namespace
+
+bool ParticleSystem::createBillboardShader() {
+    billboardShader = std::make_unique<Shader>();
+    if (!billboardShader->loadFromStrings(BILLBOARD_VERTEX_SHADER, BILLBOARD_FRAGMENT_SHADER)) {
+        std::cerr << "Failed to load particle billboard shader" << std::endl;
+        billboardShader.reset();
+        return false;
+    }
+    return true;
+}
+
 void ParticleSystem::initializeBuffers() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &quadVBO);
     
     glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
     
-    // Allocate space for particle data
-    glBufferData(GL_ARRAY_BUFFER, maxParticles * sizeof(Particle), nullptr, GL_DYNAMIC_DRAW);
+    // Per-vertex quad corner
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_CORNERS), QUAD_CORNERS, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    
+    // Per-instance particle data; allocate space for the packed render stream only
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, maxParticles * sizeof(ParticleVertex), nullptr, GL_STREAM_DRAW);
     
     // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, position));
-    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
     
     // Color attribute
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, color));
-    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
     
     // Size attribute
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, size));
-    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, size));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
     
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleSystem::writeVertex(int index) {
+    ParticleVertex& v = renderStream[index];
+    v.position = glm::vec3(posX[index], posY[index], posZ[index]);
+    v.color = glm::vec4(colR[index], colG[index], colB[index], colA[index]);
+    v.size = sizes[index];
+}
+
+void ParticleSystem::moveParticle(int from, int to) {
+    posX[to] = posX[from]; posY[to] = posY[from]; posZ[to] = posZ[from];
+    velX[to] = velX[from]; velY[to] = velY[from]; velZ[to] = velZ[from];
+    colR[to] = colR[from]; colG[to] = colG[from]; colB[to] = colB[from]; colA[to] = colA[from];
+    lives[to] = lives[from];
+    sizes[to] = sizes[from];
+    categories[to] = categories[from];
+}
+
+void ParticleSystem::removeParticle(int index) {
+    int last = --activeCount;
+    if (index != last) {
+        moveParticle(last, index);
+        renderStream[index] = renderStream[last];
+    }
+}
+
+int ParticleSystem::evictForCategory(EffectCategory category, int needed) {
+    EffectCategory victims[static_cast<int>(EffectCategory::COUNT)];
+    int victimCount = budget.getEvictionOrder(category, victims);
+    int freed = 0;
+    
+    for (int v = 0; v < victimCount && freed < needed; ++v) {
+        if (budget.getLiveCount(victims[v]) == 0) continue;
+        
+        // Walk down from the end so the particle swapped into a hole has
+        // already been looked at
+        uint8_t victim = static_cast<uint8_t>(victims[v]);
+        int removed = 0;
+        for (int i = activeCount - 1; i >= 0 && freed < needed; --i) {
+            if (categories[i] == victim) {
+                removeParticle(i);
+                ++removed;
+                ++freed;
+            }
+        }
+        budget.onRemoved(victims[v], removed);
+    }
+    
+    return freed;
+}
+
+ParticleStreams ParticleSystem::getStreams() {
+    ParticleStreams streams;
+    streams.posX = posX.data();
+    streams.posY = posY.data();
+    streams.posZ = posZ.data();
+    streams.velX = velX.data();
+    streams.velY = velY.data();
+    streams.velZ = velZ.data();
+    streams.colA = colA.data();
+    streams.life = lives.data();
+    return streams;
 }
 
 void ParticleSystem::update(float deltaTime) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
+    beginUpdate(deltaTime, nullptr);
+    finishUpdate();
+}
+
+void ParticleSystem::simulateChunk(int chunk, int begin, int end, float deltaTime) {
+    // Vectorised integration (SSE4.1/AVX2 picked at runtime)
+    integrateParticles(getStreams(), begin, end, deltaTime, chunkRngs[chunk]);
+    
+    int* deaths = &chunkDeaths[chunk * static_cast<int>(EffectCategory::COUNT)];
+    std::fill(deaths, deaths + static_cast<int>(EffectCategory::COUNT), 0);
+    
+    // Swap-and-pop within the chunk. Every slot was already integrated above,
+    // so the particle swapped in from the end must not be advanced again.
+    int live = end;
+    int i = begin;
+    while (i < live) {
+        if (lives[i] <= 0.0f) {
+            ++deaths[categories[i]];
+            --live;
+            if (i != live) {
+                moveParticle(live, i);
+            }
+            continue;
+        }
+        
+        writeVertex(i);
+        ++i;
+    }
+    
+    chunkLive[chunk] = live - begin;
+}
+
+void ParticleSystem::beginUpdate(float deltaTime, JobSystem* jobs) {
+    if (gpuSimulator) {
+        // Queued on the GL command stream; nothing to join later
+        gpuSimulator->simulate(deltaTime);
+        return;
+    }
+    
+    finishUpdate();
     
-    // Update existing particles
-    for (auto it = particles.begin(); it != particles.end();) {
-        it->life -= deltaTime;
+    simulatedCount = activeCount;
+    chunkCount = (simulatedCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    if (chunkCount == 0) return;
+    
+    updateInFlight = true;
+    
+    if (!jobs || chunkCount == 1) {
+        for (int c = 0; c < chunkCount; ++c) {
+            int begin = c * CHUNK_SIZE;
+            simulateChunk(c, begin, std::min(begin + CHUNK_SIZE, simulatedCount), deltaTime);
+        }
+        return;
+    }
+    
+    jobs->parallelFor(simulatedCount, CHUNK_SIZE,
+        [this, deltaTime](int begin, int end, int chunk) {
+            simulateChunk(chunk, begin, end, deltaTime);
+        }, updateCounter);
+    currentJobs = jobs;
+}
+
+void ParticleSystem::gatherChunks() {
+    const int categoryCount = static_cast<int>(EffectCategory::COUNT);
+    int total = 0;
+    for (int c = 0; c < chunkCount; ++c) {
+        total += chunkLive[c];
+        for (int k = 0; k < categoryCount; ++k) {
+            budget.onRemoved(static_cast<EffectCategory>(k), chunkDeaths[c * categoryCount + k]);
+        }
+    }
+    
+    // Fill the holes below the new count with the highest survivors above it.
+    // Only particles that actually need to move are touched.
+    int src = chunkCount - 1;
+    int srcPos = src * CHUNK_SIZE + chunkLive[src] - 1;
+    
+    for (int c = 0; c < chunkCount; ++c) {
+        int holeBegin = c * CHUNK_SIZE + chunkLive[c];
+        int holeEnd = std::min(std::min((c + 1) * CHUNK_SIZE, simulatedCount), total);
         
-        if (it->life <= 0.0f) {
-            it = particles.erase(it);
-        } else {
-            // Update position
-            it->position += it->velocity * deltaTime;
-            
-            // Apply gravity
-            it->velocity.y -= 9.8f * deltaTime;
-            
-            // Fade out
-            it->color.a = it->life;
-            
-            // Add some random motion
-            it->velocity.x += dis(gen) * deltaTime * 0.5f;
-            it->velocity.z += dis(gen) * deltaTime * 0.5f;
-            
-            ++it;
+        for (int hole = holeBegin; hole < holeEnd; ++hole) {
+            while (srcPos < src * CHUNK_SIZE) {
+                --src;
+                srcPos = src * CHUNK_SIZE + chunkLive[src] - 1;
+            }
+            moveParticle(srcPos, hole);
+            renderStream[hole] = renderStream[srcPos];
+            --srcPos;
         }
     }
+    
+    activeCount = total;
+}
+
+void ParticleSystem::finishUpdate() {
+    if (!updateInFlight) return;
+    
+    if (currentJobs) {
+        currentJobs->wait(updateCounter);
+        currentJobs = nullptr;
+    }
+    
+    gatherChunks();
+    updateInFlight = false;
+    
+    applyPendingSpawns();
+}
+
+void ParticleSystem::applyPendingSpawns() {
+    if (pendingSpawns.empty()) return;
+    
+    // Highest priority first so it gets first claim on free and evicted slots
+    const int categoryCount = static_cast<int>(EffectCategory::COUNT);
+    EffectCategory order[categoryCount];
+    for (int c = 0; c < categoryCount; ++c) order[c] = static_cast<EffectCategory>(c);
+    std::sort(order, order + categoryCount, [this](EffectCategory a, EffectCategory b) {
+        return budget.getPriority(a) > budget.getPriority(b);
+    });
+    
+    for (EffectCategory category : order) {
+        int wanted = 0;
+        for (const auto& spawn : pendingSpawns) {
+            if (spawn.category == category) ++wanted;
+        }
+        if (wanted == 0) continue;
+        
+        int overflow = activeCount + wanted - maxParticles;
+        if (overflow > 0) evictForCategory(category, overflow);
+        
+        for (const auto& spawn : pendingSpawns) {
+            if (spawn.category == category) {
+                spawnParticle(spawn.position, spawn.velocity, spawn.color, spawn.life, spawn.size, category);
+            }
+        }
+    }
+    pendingSpawns.clear();
 }
 
 void ParticleSystem::render(const glm::mat4& view, const glm::mat4& projection) {
-    if (!initialized || particles.empty()) return;
+    // Emission next frame is throttled against this frame's camera
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    budget.setViewer(view, projection, viewport[3]);
     
+    if (gpuSimulator) {
+        gpuSimulator->render(view, projection);
+        return;
+    }
+    
+    finishUpdate();
+    if (!initialized || !billboardShader || activeCount == 0) return;
+    
+    sortBackToFront(view);
     updateBuffers();
     
+    billboardShader->use();
+    billboardShader->setMat4("view", view);
+    billboardShader->setMat4("projection", projection);
+    
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDepthMask(GL_FALSE);
     
     glBindVertexArray(VAO);
-    glDrawArrays(GL_POINTS, 0, particles.size());
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, activeCount);
     glBindVertexArray(0);
     
     glDepthMask(GL_TRUE);
     glDisable(GL_BLEND);
 }
 
+void ParticleSystem::sortBackToFront(const glm::mat4& view) {
+    const int count = activeCount;
+    sortDepths.resize(count);
+    sortKeys.resize(count);
+    sortKeysScratch.resize(count);
+    sortOrder.resize(count);
+    sortOrderScratch.resize(count);
+    sortedStream.resize(count);
+    
+    // View-space depth is -z; only the third row of the view matrix is needed
+    const float rx = view[0][2], ry = view[1][2], rz = view[2][2], rw = view[3][2];
+    float minDepth = 0.0f, maxDepth = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        float depth = -(rx * posX[i] + ry * posY[i] + rz * posZ[i] + rw);
+        sortDepths[i] = depth;
+        if (i == 0 || depth < minDepth) minDepth = depth;
+        if (i == 0 || depth > maxDepth) maxDepth = depth;
+    }
+    
+    // Quantise to 16 bits over this frame's depth range. Keys are inverted so
+    // an ascending sort yields far-to-near.
+    float range = maxDepth - minDepth;
+    float scale = range > 0.0f ? 65535.0f / range : 0.0f;
+    uint32_t histogramLow[256] = {0};
+    uint32_t histogramHigh[256] = {0};
+    for (int i = 0; i < count; ++i) {
+        uint16_t key = static_cast<uint16_t>(65535.0f - (sortDepths[i] - minDepth) * scale);
+        sortKeys[i] = key;
+        sortOrder[i] = i;
+        ++histogramLow[key & 0xFF];
+        ++histogramHigh[key >> 8];
+    }
+    
+    // Exclusive prefix sums give each bucket's first output slot
+    uint32_t offsetLow = 0, offsetHigh = 0;
+    for (int b = 0; b < 256; ++b) {
+        uint32_t low = histogramLow[b];
+        uint32_t high = histogramHigh[b];
+        histogramLow[b] = offsetLow;
+        histogramHigh[b] = offsetHigh;
+        offsetLow += low;
+        offsetHigh += high;
+    }
+    
+    // Two stable counting passes: low byte, then high byte
+    for (int i = 0; i < count; ++i) {
+        uint32_t slot = histogramLow[sortKeys[i] & 0xFF]++;
+        sortKeysScratch[slot] = sortKeys[i];
+        sortOrderScratch[slot] = sortOrder[i];
+    }
+    for (int i = 0; i < count; ++i) {
+        uint32_t slot = histogramHigh[sortKeysScratch[i] >> 8]++;
+        sortOrder[slot] = sortOrderScratch[i];
+    }
+    
+    for (int i = 0; i < count; ++i) {
+        sortedStream[i] = renderStream[sortOrder[i]];
+    }
+}
+
 void ParticleSystem::updateBuffers() {
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, particles.size() * sizeof(Particle), particles.data());
+    // Orphan the previous storage so the driver never waits on last frame's draw
+    glBufferData(GL_ARRAY_BUFFER, maxParticles * sizeof(ParticleVertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, activeCount * sizeof(ParticleVertex), sortedStream.data());
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void ParticleSystem::emit(const glm::vec3& position, const glm::vec3& velocity,
-                         const glm::vec4& color, float life, float size) {
-    if (particles.size() >= maxParticles) return;
+                         const glm::vec4& color, float life, float size, EffectCategory category) {
+    if (gpuSimulator) {
+        gpuSimulator->spawn(position, velocity, color, life, size);
+        return;
+    }
+    if (updateInFlight) {
+        // Workers own the arrays until the update is joined; the budget
+        // decides what fits when the queue is applied
+        if ((int)pendingSpawns.size() < maxParticles) {
+            pendingSpawns.push_back({position, velocity, color, life, size, category});
+        }
+        return;
+    }
+    spawnParticle(position, velocity, color, life, size, category);
+}
+
+void ParticleSystem::spawnParticle(const glm::vec3& position, const glm::vec3& velocity,
+                                   const glm::vec4& color, float life, float size, EffectCategory category) {
+    if (activeCount >= maxParticles && evictForCategory(category, 1) == 0) return;
     
-    Particle p;
-    p.position = position;
-    p.velocity = velocity;
-    p.color = color;
-    p.life = life;
-    p.size = size;
+    int i = activeCount++;
+    posX[i] = position.x; posY[i] = position.y; posZ[i] = position.z;
+    velX[i] = velocity.x; velY[i] = velocity.y; velZ[i] = velocity.z;
+    colR[i] = color.r; colG[i] = color.g; colB[i] = color.b; colA[i] = color.a;
+    lives[i] = life;
+    sizes[i] = size;
+    categories[i] = static_cast<uint8_t>(category);
+    budget.onSpawned(category, 1);
     
-    particles.push_back(p);
+    writeVertex(i);
 }
 
-void ParticleSystem::emitBloodSplatter(const glm::vec3& position, int count) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> angle(0.0f, 6.28318f);
-    static std::uniform_real_distribution<float> speed(2.0f, 5.0f);
-    static std::uniform_real_distribution<float> upSpeed(1.0f, 3.0f);
-    
-    for (int i = 0; i < count; i++) {
-        float a = angle(gen);
-        float s = speed(gen);
-        float up = upSpeed(gen);
+namespace {
+
+// Names of the effects behind ParticleType, in enum order
+const char* TYPE_EFFECT_NAMES[] = {
+    "blood", "dust", "water_splash", "fire", "sparkle", "smoke"
+};
+
+// Orthonormal frame around a cone axis, computed once per batch
+struct ConeFrame {
+    glm::vec3 axis;
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+    float cosAngle;
+    
+    explicit ConeFrame(const EmitterDescriptor& d) : axis(d.coneAxis), cosAngle(std::cos(d.coneAngle)) {
+        glm::vec3 helper = std::fabs(axis.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        tangent = glm::normalize(glm::cross(helper, axis));
+        bitangent = glm::cross(axis, tangent);
+    }
+};
+
+inline glm::vec3 sampleVelocity(const EmitterDescriptor& d, const ConeFrame& cone, Pcg32& random) {
+    const float TWO_PI = 6.28318f;
+    
+    switch (d.shape) {
+        case EmitterShape::SPREAD:
+            return glm::vec3(random.range(-d.spread, d.spread),
+                             random.range(d.upMin, d.upMax),
+                             random.range(-d.spread, d.spread));
         
-        glm::vec3 vel(std::cos(a) * s, up, std::sin(a) * s);
-        glm::vec4 col(0.6f, 0.0f, 0.0f, 1.0f); // Dark red
+        case EmitterShape::CONE: {
+            float cosTheta = 1.0f - random.nextFloat() * (1.0f - cone.cosAngle);
+            float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+            float phi = random.nextFloat() * TWO_PI;
+            glm::vec3 dir = cone.axis * cosTheta +
+                            (cone.tangent * std::cos(phi) + cone.bitangent * std::sin(phi)) * sinTheta;
+            return dir * random.range(d.speedMin, d.speedMax);
+        }
         
-        emit(position, vel, col, 2.0f, 0.15f);
+        default: {
+            float a = random.nextFloat() * TWO_PI;
+            float s = random.range(d.speedMin, d.speedMax);
+            float up = random.range(d.upMin, d.upMax) + s * d.upFromSpeed;
+            return glm::vec3(std::cos(a) * s, up, std::sin(a) * s);
+        }
     }
 }
 
-void ParticleSystem::emitDust(const glm::vec3& position, int count) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> angle(0.0f, 6.28318f);
-    static std::uniform_real_distribution<float> speed(0.5f, 1.5f);
-    static std::uniform_real_distribution<float> gray(0.6f, 0.8f);
-    
-    for (int i = 0; i < count; i++) {
-        float a = angle(gen);
-        float s = speed(gen);
-        float g = gray(gen);
-        
-        glm::vec3 vel(std::cos(a) * s, s * 0.5f, std::sin(a) * s);
-        glm::vec4 col(g, g, g, 0.5f);
+struct SpawnSample {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec4 color;
+    float life;
+    float size;
+};
+
+// Samples one particle of the effect. With maxAge > 0 the particle is treated
+// as born up to maxAge seconds ago and advanced with the same ballistic model
+// as the integration kernel (minus the jitter). Returns false if it would
+// already have expired.
+inline bool sampleParticle(const EmitterDescriptor& d, const ConeFrame& cone, Pcg32& random,
+                           const glm::vec3& origin, float maxAge, SpawnSample& out) {
+    const float GRAVITY = 9.8f;
+    
+    out.position = origin;
+    out.velocity = sampleVelocity(d, cone, random);
+    out.color = glm::mix(d.colorStart, d.colorEnd, random.nextFloat());
+    out.life = random.range(d.lifeMin, d.lifeMax);
+    out.size = random.range(d.sizeMin, d.sizeMax);
+    
+    if (maxAge > 0.0f) {
+        float age = random.nextFloat() * maxAge;
+        if (age >= out.life) return false;
         
-        emit(position, vel, col, 1.5f, 0.1f);
+        out.position += out.velocity * age;
+        out.position.y -= 0.5f * GRAVITY * age * age;
+        out.velocity.y -= GRAVITY * age;
+        out.life -= age;
+        out.color.a = out.life;
     }
+    return true;
 }
 
-void ParticleSystem::emitWaterSplash(const glm::vec3& position, int count) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> angle(0.0f, 6.28318f);
-    static std::uniform_real_distribution<float> speed(3.0f, 6.0f);
-    static std::uniform_real_distribution<float> upSpeed(2.0f, 5.0f);
-    
-    for (int i = 0; i < count; i++) {
-        float a = angle(gen);
-        float s = speed(gen);
-        float up = upSpeed(gen);
+} // namespace
+
+bool ParticleSystem::loadEffects(const std::string& filename) {
+    ParticleEffectLibrary loaded;
+    if (!loaded.loadFromFile(filename)) return false;
+    effects = loaded;
+    
+    // One independent stream per effect, all from a single seed
+    std::random_device rd;
+    uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    effectRngs.resize(effects.getCount());
+    for (int i = 0; i < effects.getCount(); ++i) {
+        effectRngs[i].seed(seed, i);
+    }
+    
+    for (int t = 0; t < static_cast<int>(ParticleType::COUNT); ++t) {
+        typeEffects[t] = effects.find(TYPE_EFFECT_NAMES[t]);
+        if (typeEffects[t] < 0) {
+            std::cerr << "Particle effect '" << TYPE_EFFECT_NAMES[t] << "' missing from " << filename << std::endl;
+        }
+    }
+    return true;
+}
+
+int ParticleSystem::findEffect(const std::string& name) const {
+    return effects.find(name);
+}
+
+void ParticleSystem::emitEffect(int effectId, const glm::vec3& position, int count) {
+    if (effectId < 0 || effectId >= effects.getCount()) return;
+    
+    const EmitterDescriptor& descriptor = effects.get(effectId);
+    emitN(descriptor, effectRngs[effectId], position, count < 0 ? descriptor.burstCount : count);
+}
+
+void ParticleSystem::emit(ParticleType type, const glm::vec3& position, int count) {
+    emitEffect(typeEffects[static_cast<int>(type)], position, count);
+}
+
+void ParticleSystem::emitN(const EmitterDescriptor& d, Pcg32& random, const glm::vec3& position,
+                           int count, float maxAge) {
+    count = budget.scaleEmission(d.category, count, position, 0.5f * (d.sizeMin + d.sizeMax));
+    if (count <= 0) return;
+    
+    ConeFrame cone(d);
+    SpawnSample sample;
+    
+    // The GPU or the update workers own the storage; queue through emit()
+    if (gpuSimulator || updateInFlight) {
+        for (int n = 0; n < count; ++n) {
+            if (!sampleParticle(d, cone, random, position, maxAge, sample)) continue;
+            emit(sample.position, sample.velocity, sample.color, sample.life, sample.size, d.category);
+        }
+        return;
+    }
+    
+    // Under pressure, lower priority categories give up their slots
+    int overflow = activeCount + count - maxParticles;
+    if (overflow > 0) evictForCategory(d.category, overflow);
+    
+    int first = activeCount;
+    int last = first + std::min(count, maxParticles - activeCount);
+    uint8_t category = static_cast<uint8_t>(d.category);
+    
+    int i = first;
+    for (int n = 0; n < count && i < last; ++n) {
+        if (!sampleParticle(d, cone, random, position, maxAge, sample)) continue;
         
-        glm::vec3 vel(std::cos(a) * s, up, std::sin(a) * s);
-        glm::vec4 col(0.2f, 0.5f, 0.8f, 0.8f); // Blue
+        posX[i] = sample.position.x; posY[i] = sample.position.y; posZ[i] = sample.position.z;
+        velX[i] = sample.velocity.x; velY[i] = sample.velocity.y; velZ[i] = sample.velocity.z;
+        colR[i] = sample.color.r; colG[i] = sample.color.g; colB[i] = sample.color.b; colA[i] = sample.color.a;
+        lives[i] = sample.life;
+        sizes[i] = sample.size;
+        categories[i] = category;
         
-        emit(position, vel, col, 1.0f, 0.12f);
+        writeVertex(i);
+        ++i;
     }
+    
+    budget.onSpawned(d.category, i - first);
+    activeCount = i;
+}
+
+void ParticleSystem::emitBloodSplatter(const glm::vec3& position, int count) {
+    emit(ParticleType::BLOOD, position, count);
+}
+
+void ParticleSystem::emitDust(const glm::vec3& position, int count) {
+    emit(ParticleType::DUST, position, count);
+}
+
+void ParticleSystem::emitWaterSplash(const glm::vec3& position, int count) {
+    emit(ParticleType::WATER_SPLASH, position, count);
 }
 
 void ParticleSystem::emitFire(const glm::vec3& position, int count) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> spread(-0.2f, 0.2f);
-    static std::uniform_real_distribution<float> upSpeed(1.5f, 3.0f);
-    static std::uniform_real_distribution<float> colorVar(0.0f, 1.0f);
-    
-    for (int i = 0; i < count; i++) {
-        float cv = colorVar(gen);
-        glm::vec3 vel(spread(gen), upSpeed(gen), spread(gen));
-        glm::vec4 col(1.0f, 0.5f + cv * 0.3f, 0.0f, 1.0f); // Orange/Yellow
-        
-        emit(position, vel, col, 0.8f, 0.2f);
-    }
+    emit(ParticleType::FIRE, position, count);
 }
 
 void ParticleSystem::emitSparkle(const glm::vec3& position, int count) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> angle(0.0f, 6.28318f);
-    static std::uniform_real_distribution<float> speed(1.0f, 2.0f);
-    static std::uniform_real_distribution<float> colorComp(0.7f, 1.0f);
-    
-    for (int i = 0; i < count; i++) {
-        float a = angle(gen);
-        float s = speed(gen);
-        
-        glm::vec3 vel(std::cos(a) * s, s * 0.5f, std::sin(a) * s);
-        glm::vec4 col(colorComp(gen), colorComp(gen), 1.0f, 1.0f); // Bright colors
-        
-        emit(position, vel, col, 1.0f, 0.08f);
-    }
+    emit(ParticleType::SPARKLE, position, count);
 }
 
 void ParticleSystem::emitSmoke(const glm::vec3& position, int count) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> spread(-0.3f, 0.3f);
-    static std::uniform_real_distribution<float> upSpeed(0.8f, 1.5f);
-    static std::uniform_real_distribution<float> gray(0.3f, 0.5f);
-    
-    for (int i = 0; i < count; i++) {
-        float g = gray(gen);
-        glm::vec3 vel(spread(gen), upSpeed(gen), spread(gen));
-        glm::vec4 col(g, g, g, 0.6f);
-        
-        emit(position, vel, col, 3.0f, 0.3f);
-    }
+    emit(ParticleType::SMOKE, position, count);
 }
 
 void ParticleSystem::clear() {
-    particles.clear();
+    if (gpuSimulator) {
+        gpuSimulator->clear();
+        return;
+    }
+    finishUpdate();
+    activeCount = 0;
+    budget.resetCounts();
 }
 
 int ParticleSystem::getActiveParticleCount() const {
-    return particles.size();
+    // The GPU backend can only report an upper bound without a readback
+    if (gpuSimulator) return gpuSimulator->getSlotsInUse();
+    return activeCount;
 }
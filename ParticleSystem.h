@@ -1,17 +1,24 @@
 #pragma once
 
+#include "ParticleKernels.h"
+#include "JobSystem.h"
+#include "GpuParticleSimulator.h"
+#include "ParticleEffects.h"
+#include "ParticleBudget.h"
+#include "FastRandom.h"
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <memory>
 
-struct Particle {
+class Shader;
+
+// Render-only view of a particle - the only data uploaded to the GPU
+struct ParticleVertex {
     glm::vec3 position;
-    glm::vec3 velocity;
     glm::vec4 color;
-    float life;
     float size;
-    
-    Particle() : position(0.0f), velocity(0.0f), color(1.0f), life(1.0f), size(0.1f) {}
 };
 
 enum class ParticleType {
@@ -20,41 +27,144 @@ enum class ParticleType {
     WATER_SPLASH,
     FIRE,
     SPARKLE,
-    SMOKE
+    SMOKE,
+    COUNT
+};
+
+// Where the simulation runs. GPU keeps all particle state in GL buffers
+// (transform feedback) and suits very high particle counts.
+enum class ParticleBackend {
+    CPU,
+    GPU
 };
 
 class ParticleSystem {
 private:
-    std::vector<Particle> particles;
+    ParticleBackend backend;
+    std::unique_ptr<GpuParticleSimulator> gpuSimulator;
+    
+    // Structure-of-arrays storage. Slots [0, activeCount) are live and
+    // dead particles are removed by swapping the last live one into place.
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> colR, colG, colB, colA;
+    std::vector<float> lives;
+    std::vector<float> sizes;
+    std::vector<uint8_t> categories;
+    int activeCount;
     int maxParticles;
     
-    // Rendering
-    unsigned int VAO, VBO;
+    // Packed stream mirrored from the arrays above, uploaded as-is
+    std::vector<ParticleVertex> renderStream;
+    
+    // Jitter random streams for the integration kernel, one per chunk
+    std::vector<ParticleRng> chunkRngs;
+    uint32_t rngSeed;
+    
+    // Chunked (optionally multithreaded) simulation. Each chunk integrates and
+    // compacts its own range; the survivors are gathered when the update is joined.
+    static const int CHUNK_SIZE = 4096;
+    JobSystem* currentJobs;
+    JobCounter updateCounter;
+    bool updateInFlight;
+    int chunkCount;
+    int simulatedCount;
+    std::vector<int> chunkLive;
+    std::vector<int> chunkDeaths;   // per chunk, per category
+    
+    // Emission requested while an update is in flight is applied after the join
+    struct PendingSpawn {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::vec4 color;
+        float life;
+        float size;
+        EffectCategory category;
+    };
+    std::vector<PendingSpawn> pendingSpawns;
+    
+    // Priorities, distance throttling and per-category live counts
+    ParticleBudget budget;
+    
+    // Data-driven effects, each with its own random stream
+    ParticleEffectLibrary effects;
+    std::vector<Pcg32> effectRngs;
+    int typeEffects[static_cast<int>(ParticleType::COUNT)];
+    
+    // Rendering: one camera-facing quad per particle, drawn instanced from
+    // the render stream in back-to-front order
+    unsigned int VAO, VBO, quadVBO;
+    std::unique_ptr<Shader> billboardShader;
     bool initialized;
     
+    // Depth sort scratch (LSD radix sort on 16-bit quantised view depth)
+    std::vector<float> sortDepths;
+    std::vector<uint16_t> sortKeys, sortKeysScratch;
+    std::vector<uint32_t> sortOrder, sortOrderScratch;
+    std::vector<ParticleVertex> sortedStream;
+    
+    void allocateCpuStorage();
     void initializeBuffers();
+    bool createBillboardShader();
+    void sortBackToFront(const glm::mat4& view);
     void updateBuffers();
+    void writeVertex(int index);
+    void moveParticle(int from, int to);
+    void removeParticle(int index);
+    int evictForCategory(EffectCategory category, int needed);
+    void applyPendingSpawns();
+    ParticleStreams getStreams();
+    void simulateChunk(int chunk, int begin, int end, float deltaTime);
+    void gatherChunks();
+    void spawnParticle(const glm::vec3& position, const glm::vec3& velocity,
+                       const glm::vec4& color, float life, float size, EffectCategory category);
     
 public:
-    ParticleSystem(int maxCount = 1000);
+    ParticleSystem(int maxCount = 1000, ParticleBackend requestedBackend = ParticleBackend::CPU);
     ~ParticleSystem();
     
     void initialize();
     void update(float deltaTime);
     void render(const glm::mat4& view, const glm::mat4& projection);
     
-    // Particle emission
-    void emitBloodSplatter(const glm::vec3& position, int count = 20);
-    void emitDust(const glm::vec3& position, int count = 10);
-    void emitWaterSplash(const glm::vec3& position, int count = 30);
-    void emitFire(const glm::vec3& position, int count = 15);
-    void emitSparkle(const glm::vec3& position, int count = 5);
-    void emitSmoke(const glm::vec3& position, int count = 10);
+    // Asynchronous update: kick the chunks onto the job system (or run them
+    // inline when jobs is null) and join later. render() joins automatically.
+    void beginUpdate(float deltaTime, JobSystem* jobs);
+    void finishUpdate();
+    
+    // Effect data. The built-in ParticleTypes map to the effects named
+    // blood, dust, water_splash, fire, sparkle and smoke.
+    bool loadEffects(const std::string& filename);
+    int findEffect(const std::string& name) const;
+    const ParticleEffectLibrary& getEffects() const { return effects; }
+    
+    // Particle emission (count < 0 uses the effect's burst size)
+    void emitEffect(int effectId, const glm::vec3& position, int count = -1);
+    void emit(ParticleType type, const glm::vec3& position, int count = -1);
+    void emitBloodSplatter(const glm::vec3& position, int count = -1);
+    void emitDust(const glm::vec3& position, int count = -1);
+    void emitWaterSplash(const glm::vec3& position, int count = -1);
+    void emitFire(const glm::vec3& position, int count = -1);
+    void emitSparkle(const glm::vec3& position, int count = -1);
+    void emitSmoke(const glm::vec3& position, int count = -1);
+    
+    // Batch emission: one capacity check, then every new particle is
+    // initialised in a single loop using the caller's random stream.
+    // maxAge > 0 spreads the births over the last maxAge seconds and advances
+    // the particles analytically (used to fast-forward dormant emitters).
+    void emitN(const EmitterDescriptor& descriptor, Pcg32& random,
+               const glm::vec3& position, int count, float maxAge = 0.0f);
     
     // Generic emission
     void emit(const glm::vec3& position, const glm::vec3& velocity, 
-              const glm::vec4& color, float life, float size);
+              const glm::vec4& color, float life, float size,
+              EffectCategory category = EffectCategory::AMBIENT);
     
     void clear();
     int getActiveParticleCount() const;
+    
+    // Budget. Live counts per category are tracked by the CPU backend only.
+    ParticleBudget& getBudget() { return budget; }
+    int getLiveCount(EffectCategory category) const { return budget.getLiveCount(category); }
+    ParticleBackend getBackend() const { return backend; }
 };
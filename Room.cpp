@@ -1,28 +1,59 @@
 #include "Room.h"
+#include "WorldFile.h"
 #include <iostream>
 #include <algorithm>
 
-Room::Room(const std::string& id, const std::string& name, const std::string& description)
-    : id(id), name(name), description(description), visited(false), hazard(HazardType::NONE) {}
+Room::Room(RoomId id, const std::string& key, const std::string& name, const std::string& description)
+    : id(id), file(nullptr), record(nullptr), key(key), name(name), description(description), visited(false),
+      hazard(HazardType::NONE), eventChanged(true) {}
 
-void Room::addExit(const std::string& direction, const std::string& roomId) {
-    exits[direction] = roomId;
+Room::Room(RoomId id, const WorldFile& worldFile)
+    : id(id), file(&worldFile), record(&worldFile.getRooms()[id]), visited(false),
+      hazard(static_cast<HazardType>(record->hazard)), eventChanged(false) {
+    // Items and enemies are the only parts of the record copied, since play changes them
+    const WorldItem* itemRecords = file->getItems() + record->firstItem;
+    items.reserve(record->itemCount);
+    for (uint32_t i = 0; i < record->itemCount; i++) {
+        const WorldItem& item = itemRecords[i];
+        items.push_back(std::make_shared<Item>(std::string(file->getString(item.name)),
+                                               std::string(file->getString(item.description)),
+                                               static_cast<Item::Type>(item.type), item.value, item.effect));
+    }
+    const WorldEnemy* enemyRecords = file->getEnemies() + record->firstEnemy;
+    enemies.reserve(record->enemyCount);
+    for (uint32_t i = 0; i < record->enemyCount; i++) {
+        const WorldEnemy& enemy = enemyRecords[i];
+        enemies.push_back(std::make_shared<Enemy>(std::string(file->getString(enemy.name)),
+                                                  static_cast<Enemy::Type>(enemy.type), enemy.health,
+                                                  enemy.attack, enemy.defense, enemy.goldReward));
+    }
 }
 
-std::string Room::getExit(const std::string& direction) const {
-    auto it = exits.find(direction);
-    if (it != exits.end()) {
-        return it->second;
-    }
-    return "";
+std::string_view Room::getKey() const {
+    return record ? file->getString(record->id) : std::string_view(key);
 }
 
-std::vector<std::string> Room::getAvailableExits() const {
-    std::vector<std::string> directions;
-    for (const auto& exit : exits) {
-        directions.push_back(exit.first);
-    }
-    return directions;
+std::string_view Room::getName() const {
+    return record ? file->getString(record->name) : std::string_view(name);
+}
+
+std::string_view Room::getDescription() const {
+    return record ? file->getString(record->description) : std::string_view(description);
+}
+
+std::string_view Room::getBiome() const {
+    if (!record) return biome;
+    if (record->biome == WorldFile::NO_BIOME) return std::string_view();
+    return file->getString(file->getBiomes()[record->biome].key);
+}
+
+void Room::setSpecialEvent(const std::string& event) {
+    specialEvent = event;
+    eventChanged = true;
+}
+
+std::string_view Room::getSpecialEvent() const {
+    return eventChanged ? std::string_view(specialEvent) : file->getString(record->event);
 }
 
 void Room::addItem(std::shared_ptr<Item> item) {
@@ -98,9 +129,9 @@ std::string Room::getHazardDescription() const {
     }
 }
 
-void Room::displayRoom() const {
-    std::cout << "\n=== " << name << " ===" << std::endl;
-    std::cout << description << std::endl;
+void Room::displayRoom(const RoomGraph& graph) const {
+    std::cout << "\n=== " << getName() << " ===" << std::endl;
+    std::cout << getDescription() << std::endl;
     
     if (hazard != HazardType::NONE) {
         std::cout << "\n" << getHazardDescription() << std::endl;
@@ -118,22 +149,23 @@ void Room::displayRoom() const {
     }
     
     std::cout << "\nExits: ";
-    auto exitList = getAvailableExits();
-    if (exitList.empty()) {
+    RoomGraph::ExitRange exitList = graph.getExits(id);
+    if (exitList.size() == 0) {
         std::cout << "None";
     } else {
-        for (size_t i = 0; i < exitList.size(); ++i) {
-            std::cout << exitList[i];
-            if (i < exitList.size() - 1) std::cout << ", ";
+        for (const RoomExit* exit = exitList.begin(); exit != exitList.end(); ++exit) {
+            std::cout << getDirectionName(exit->direction);
+            if (exit + 1 != exitList.end()) std::cout << ", ";
         }
     }
     std::cout << std::endl;
     
-    if (!specialEvent.empty()) {
-        std::cout << "\n" << specialEvent << std::endl;
+    std::string_view event = getSpecialEvent();
+    if (!event.empty()) {
+        std::cout << "\n" << event << std::endl;
     }
 }
 
-void Room::lookAround() const {
-    displayRoom();
+void Room::lookAround(const RoomGraph& graph) const {
+    displayRoom(graph);
 }
@@ -1,11 +1,19 @@
 #pragma once
 #include "Item.h"
 #include "Enemy.h"
+#include "RoomGraph.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <map>
 
+class WorldFile;
+struct WorldRoom;
+
+// A room in play. Rooms of the compiled world read their text in place from
+// the WorldFile, which must outlive them, and start with the items and
+// enemies of their record; rooms made in code hold their own text.
 class Room {
 public:
     enum class HazardType {
@@ -17,31 +25,32 @@ public:
     };
 
 private:
-    std::string id;
+    RoomId id;
+    const WorldFile* file;      // nullptr for rooms made in code
+    const WorldRoom* record;
+    std::string key;            // name used in the world file and by scripts
     std::string name;
     std::string description;
-    std::map<std::string, std::string> exits;
     std::vector<std::shared_ptr<Item>> items;
     std::vector<std::shared_ptr<Enemy>> enemies;
     bool visited;
     HazardType hazard;
+    bool eventChanged;          // specialEvent replaces the record's
     std::string specialEvent;
+    std::string biome;
     
 public:
-    Room(const std::string& id, const std::string& name, const std::string& description);
+    Room(RoomId id, const std::string& key, const std::string& name, const std::string& description);
+    Room(RoomId id, const WorldFile& file);     // id is the record index
     
     // Basic info
-    const std::string& getId() const { return id; }
-    const std::string& getName() const { return name; }
-    const std::string& getDescription() const { return description; }
+    RoomId getId() const { return id; }
+    std::string_view getKey() const;
+    std::string_view getName() const;
+    std::string_view getDescription() const;
     bool isVisited() const { return visited; }
     void setVisited(bool v) { visited = v; }
     
-    // Navigation
-    void addExit(const std::string& direction, const std::string& roomId);
-    std::string getExit(const std::string& direction) const;
-    std::vector<std::string> getAvailableExits() const;
-    
     // Items
     void addItem(std::shared_ptr<Item> item);
     std::shared_ptr<Item> takeItem(const std::string& itemName);
@@ -61,11 +70,16 @@ public:
     HazardType getHazard() const { return hazard; }
     std::string getHazardDescription() const;
     
+    // Biome (key into WorldManager's biome table); rooms of the world file
+    // take theirs from the record
+    void setBiome(const std::string& biomeName) { biome = biomeName; }
+    std::string_view getBiome() const;
+    
     // Special events
-    void setSpecialEvent(const std::string& event) { specialEvent = event; }
-    const std::string& getSpecialEvent() const { return specialEvent; }
+    void setSpecialEvent(const std::string& event);
+    std::string_view getSpecialEvent() const;
     
-    // Display
-    void displayRoom() const;
-    void lookAround() const;
+    // Display; exits live in the world's RoomGraph
+    void displayRoom(const RoomGraph& graph) const;
+    void lookAround(const RoomGraph& graph) const;
 };
@@ -0,0 +1,114 @@
+#include "RoomGraph.h"
+
+namespace {
+
+const char* const DIRECTION_NAMES[DIRECTION_COUNT] = {"north", "south", "east", "west", "up", "down"};
+
+} // namespace
+
+bool parseDirection(const std::string& name, Direction& direction) {
+    for (int i = 0; i < DIRECTION_COUNT; i++) {
+        if (name == DIRECTION_NAMES[i]) {
+            direction = static_cast<Direction>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* getDirectionName(Direction direction) {
+    return DIRECTION_NAMES[static_cast<int>(direction)];
+}
+
+Direction getOppositeDirection(Direction direction) {
+    // Directions come in pairs: north/south, east/west, up/down
+    return static_cast<Direction>(static_cast<int>(direction) ^ 1);
+}
+
+RoomGraph::RoomGraph()
+    : fileRows(nullptr), fileExits(nullptr), fileRoomCount(0), firstExit(1, 0), exitCount(0), version(0) {}
+
+void RoomGraph::clear() {
+    fileRows = nullptr;
+    fileExits = nullptr;
+    fileRoomCount = 0;
+    firstExit.assign(1, 0);
+    exits.clear();
+    changedRows.clear();
+    exitCount = 0;
+    version++;
+}
+
+void RoomGraph::attach(const uint32_t* rows, const RoomExit* roomExits, uint32_t roomCount) {
+    fileRows = rows;
+    fileExits = roomExits;
+    fileRoomCount = roomCount;
+    exitCount = rows[roomCount];
+    version++;
+}
+
+RoomId RoomGraph::addRoom() {
+    firstExit.push_back(static_cast<uint32_t>(exits.size()));
+    version++;
+    return getRoomCount() - 1;
+}
+
+void RoomGraph::setExit(RoomId from, Direction direction, RoomId to) {
+    version++;
+    if (from < fileRoomCount) {
+        // The attached row is read-only; change a copy of it
+        auto changed = changedRows.find(from);
+        if (changed == changedRows.end()) {
+            changed = changedRows.emplace(from, std::vector<RoomExit>(fileExits + fileRows[from],
+                                                                      fileExits + fileRows[from + 1])).first;
+        }
+        std::vector<RoomExit>& row = changed->second;
+        for (RoomExit& exit : row) {
+            if (exit.direction == direction) {
+                exit.room = to;
+                return;
+            }
+        }
+        row.push_back(RoomExit{direction, to});
+        exitCount++;
+        return;
+    }
+
+    RoomId row = from - fileRoomCount;
+    for (uint32_t i = firstExit[row]; i < firstExit[row + 1]; i++) {
+        if (exits[i].direction == direction) {
+            exits[i].room = to;
+            return;
+        }
+    }
+
+    exits.insert(exits.begin() + firstExit[row + 1], RoomExit{direction, to});
+    exitCount++;
+    for (size_t r = row + 1; r < firstExit.size(); r++) {
+        firstExit[r]++;
+    }
+}
+
+RoomId RoomGraph::getExit(RoomId room, Direction direction) const {
+    for (const RoomExit& exit : getExits(room)) {
+        if (exit.direction == direction) return exit.room;
+    }
+    return INVALID_ROOM;
+}
+
+RoomGraph::ExitRange RoomGraph::getExits(RoomId room) const {
+    if (room < fileRoomCount) {
+        if (!changedRows.empty()) {
+            auto changed = changedRows.find(room);
+            if (changed != changedRows.end()) {
+                const RoomExit* base = changed->second.data();
+                return ExitRange{base, base + changed->second.size()};
+            }
+        }
+        return ExitRange{fileExits + fileRows[room], fileExits + fileRows[room + 1]};
+    }
+
+    const RoomExit* base = exits.data();
+    RoomId row = room - fileRoomCount;
+    return ExitRange{base + firstExit[row], base + firstExit[row + 1]};
+}
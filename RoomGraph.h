@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Rooms are numbered densely from 0 in load order. Names are only looked up
+// where the player or a data file names a room; everything else passes ids.
+using RoomId = uint32_t;
+const RoomId INVALID_ROOM = 0xFFFFFFFFu;
+
+// 32 bits so that RoomExit is also the compiled world's exit record
+enum class Direction : uint32_t {
+    NORTH,
+    SOUTH,
+    EAST,
+    WEST,
+    UP,
+    DOWN
+};
+const int DIRECTION_COUNT = 6;
+
+bool parseDirection(const std::string& name, Direction& direction);     // false if not a direction
+const char* getDirectionName(Direction direction);
+Direction getOppositeDirection(Direction direction);
+
+struct RoomExit {
+    Direction direction;
+    RoomId room;
+};
+
+// Every exit in the world in one array, grouped by the room it leaves from
+// (compressed sparse rows): room r's exits are exits[firstExit[r]] up to
+// exits[firstExit[r + 1]]. A room has at most one exit per direction, so a
+// lookup scans at most DIRECTION_COUNT entries.
+//
+// A loaded world's rows and exits are read in place from the world file
+// (attach()); rooms added afterwards get rows of their own. A file room
+// whose exits change during play gets a copy of its row the first time.
+class RoomGraph {
+private:
+    const uint32_t* fileRows;           // attached rows, fileRoomCount + 1 of them
+    const RoomExit* fileExits;
+    uint32_t fileRoomCount;
+    std::vector<uint32_t> firstExit;    // rooms after the attached ones, plus one past the end
+    std::vector<RoomExit> exits;
+    std::unordered_map<RoomId, std::vector<RoomExit>> changedRows;     // file rooms changed in play
+    uint32_t exitCount;
+    uint32_t version;
+
+public:
+    // Exits of one room, for range-for
+    struct ExitRange {
+        const RoomExit* first;
+        const RoomExit* last;
+        const RoomExit* begin() const { return first; }
+        const RoomExit* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    RoomGraph();
+
+    void clear();
+    // Use roomCount rooms whose rows and exits stay valid until clear(). Only
+    // on an empty graph.
+    void attach(const uint32_t* rows, const RoomExit* roomExits, uint32_t roomCount);
+    RoomId addRoom();
+
+    // Adds or redirects an exit. Appending to the last room is constant
+    // time, which is how worlds are built in code; exits opened during play
+    // shift the rows after it.
+    void setExit(RoomId from, Direction direction, RoomId to);
+
+    RoomId getExit(RoomId room, Direction direction) const;     // INVALID_ROOM if none
+    ExitRange getExits(RoomId room) const;
+    uint32_t getRoomCount() const { return fileRoomCount + static_cast<uint32_t>(firstExit.size() - 1); }
+    uint32_t getExitCount() const { return exitCount; }
+
+    // Changes whenever an exit does, so cached paths can tell they are stale
+    uint32_t getVersion() const { return version; }
+};
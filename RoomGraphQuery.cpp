@@ -0,0 +1,346 @@
+#include "RoomGraphQuery.h"
+#include <algorithm>
+
+namespace {
+
+const uint16_t FAR = 0xFFFF;            // unreachable in the all-pairs table
+const uint8_t NO_STEP = 0xFF;
+
+} // namespace
+
+RoomGraphQuery::RoomGraphQuery(const RoomGraph& graph) : graph(graph), built(false), builtVersion(0), stamp(0) {}
+
+void RoomGraphQuery::ensureBuilt() {
+    if (built && builtVersion == graph.getVersion()) return;
+
+    distanceTable.clear();
+    nextStepTable.clear();
+    landmarks.clear();
+    fromLandmark.clear();
+    toLandmark.clear();
+    reverseFirst.clear();
+    reverseSources.clear();
+
+    if (usesAllPairs()) {
+        buildAllPairs();
+    } else {
+        buildReverse();
+        buildLandmarks();
+    }
+    built = true;
+    builtVersion = graph.getVersion();
+}
+
+// All pairs
+
+void RoomGraphQuery::buildAllPairs() {
+    size_t roomCount = graph.getRoomCount();
+    distanceTable.assign(roomCount * roomCount, FAR);
+    nextStepTable.assign(roomCount * roomCount, NO_STEP);
+    for (RoomId source = 0; source < roomCount; source++) {
+        fillAllPairsRow(source);
+    }
+}
+
+void RoomGraphQuery::fillAllPairsRow(RoomId source) {
+    size_t row = static_cast<size_t>(source) * graph.getRoomCount();
+    uint16_t* distance = &distanceTable[row];
+    uint8_t* step = &nextStepTable[row];
+
+    distance[source] = 0;
+    queue.assign(1, source);
+    for (size_t i = 0; i < queue.size(); i++) {
+        RoomId room = queue[i];
+        for (const RoomExit& exit : graph.getExits(room)) {
+            if (distance[exit.room] != FAR) continue;
+            distance[exit.room] = static_cast<uint16_t>(distance[room] + 1);
+            step[exit.room] = room == source ? static_cast<uint8_t>(exit.direction) : step[room];
+            queue.push_back(exit.room);
+        }
+    }
+}
+
+// Landmarks
+
+void RoomGraphQuery::buildReverse() {
+    uint32_t roomCount = graph.getRoomCount();
+    reverseFirst.assign(roomCount + 1, 0);
+    for (RoomId room = 0; room < roomCount; room++) {
+        for (const RoomExit& exit : graph.getExits(room)) {
+            reverseFirst[exit.room + 1]++;
+        }
+    }
+    for (uint32_t i = 0; i < roomCount; i++) {
+        reverseFirst[i + 1] += reverseFirst[i];
+    }
+
+    reverseSources.resize(graph.getExitCount());
+    std::vector<uint32_t> fill(reverseFirst.begin(), reverseFirst.end() - 1);
+    for (RoomId room = 0; room < roomCount; room++) {
+        for (const RoomExit& exit : graph.getExits(room)) {
+            reverseSources[fill[exit.room]++] = room;
+        }
+    }
+}
+
+void RoomGraphQuery::buildLandmarks() {
+    uint32_t roomCount = graph.getRoomCount();
+    int count = static_cast<int>(std::min<uint32_t>(LANDMARK_COUNT, roomCount));
+    fromLandmark.assign(static_cast<size_t>(count) * roomCount, UNREACHABLE);
+    toLandmark.assign(static_cast<size_t>(count) * roomCount, UNREACHABLE);
+
+    // Farthest-point selection: each landmark is the room furthest from all
+    // the ones before it, so they end up spread around the edges of the
+    // world, where their bounds are tightest. Rooms none of them reach count
+    // as furthest, which gives every disconnected area a landmark.
+    std::vector<uint32_t> nearest(roomCount, UNREACHABLE);
+    RoomId next = 0;
+    for (int k = 0; k < count; k++) {
+        size_t row = static_cast<size_t>(k) * roomCount;
+        landmarks.push_back(next);
+        fillLandmarkRow(next, false, &fromLandmark[row]);
+        fillLandmarkRow(next, true, &toLandmark[row]);
+
+        nearest[next] = 0;
+        uint32_t furthest = 0;
+        for (RoomId room = 0; room < roomCount; room++) {
+            nearest[room] = std::min(nearest[room], fromLandmark[row + room]);
+            if (nearest[room] > furthest) {
+                furthest = nearest[room];
+                next = room;
+            }
+        }
+        if (furthest == 0) break;
+    }
+}
+
+void RoomGraphQuery::fillLandmarkRow(RoomId landmark, bool reverse, uint32_t* distance) {
+    distance[landmark] = 0;
+    propagateDecrease(distance, landmark, reverse);
+}
+
+// Breadth-first from start, lowering every count that a path through start
+// improves. From a lone landmark this fills its row; after an exit opens it
+// repairs the row, touching only rooms that got closer.
+void RoomGraphQuery::propagateDecrease(uint32_t* distance, RoomId start, bool reverse) {
+    queue.assign(1, start);
+    for (size_t i = 0; i < queue.size(); i++) {
+        RoomId room = queue[i];
+        uint32_t next = distance[room] + 1;
+
+        if (reverse) {
+            for (uint32_t e = reverseFirst[room]; e < reverseFirst[room + 1]; e++) {
+                RoomId source = reverseSources[e];
+                if (next < distance[source]) {
+                    distance[source] = next;
+                    queue.push_back(source);
+                }
+            }
+        } else {
+            for (const RoomExit& exit : graph.getExits(room)) {
+                if (next < distance[exit.room]) {
+                    distance[exit.room] = next;
+                    queue.push_back(exit.room);
+                }
+            }
+        }
+    }
+}
+
+uint32_t RoomGraphQuery::landmarkBound(RoomId room, RoomId target) const {
+    // Triangle inequality both ways round each landmark L:
+    //   d(room, target) >= d(L, target) - d(L, room)
+    //   d(room, target) >= d(room, L) - d(target, L)
+    uint32_t roomCount = graph.getRoomCount();
+    uint32_t bound = 0;
+    for (size_t k = 0; k < landmarks.size(); k++) {
+        const uint32_t* from = &fromLandmark[k * roomCount];
+        const uint32_t* to = &toLandmark[k * roomCount];
+        if (from[room] != UNREACHABLE && from[target] != UNREACHABLE && from[target] > from[room]) {
+            bound = std::max(bound, from[target] - from[room]);
+        }
+        if (to[room] != UNREACHABLE && to[target] != UNREACHABLE && to[room] > to[target]) {
+            bound = std::max(bound, to[room] - to[target]);
+        }
+    }
+    return bound;
+}
+
+// Searches
+
+void RoomGraphQuery::beginSearch() {
+    uint32_t roomCount = graph.getRoomCount();
+    if (searchStamp.size() != roomCount) {
+        searchStamp.assign(roomCount, 0);
+        searchCost.resize(roomCount);
+        searchPrevious.resize(roomCount);
+        searchStep.resize(roomCount);
+        stamp = 0;
+    }
+    if (++stamp == 0) {
+        std::fill(searchStamp.begin(), searchStamp.end(), 0);
+        stamp = 1;
+    }
+}
+
+void RoomGraphQuery::visit(RoomId room, uint32_t cost, RoomId previous, uint8_t step) {
+    searchStamp[room] = stamp;
+    searchCost[room] = cost;
+    searchPrevious[room] = previous;
+    searchStep[room] = step;
+}
+
+bool RoomGraphQuery::search(RoomId from, RoomId to) {
+    beginSearch();
+    open.clear();
+    visit(from, 0, INVALID_ROOM, NO_STEP);
+    open.push_back(OpenRoom{landmarkBound(from, to), 0, from});
+
+    // The bound is consistent, so the first time the target comes off the
+    // heap its cost is the shortest
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end());
+        OpenRoom current = open.back();
+        open.pop_back();
+        if (current.cost > searchCost[current.room]) continue;     // superseded
+        if (current.room == to) return true;
+
+        uint32_t cost = current.cost + 1;
+        for (const RoomExit& exit : graph.getExits(current.room)) {
+            if (visited(exit.room) && searchCost[exit.room] <= cost) continue;
+            visit(exit.room, cost, current.room, static_cast<uint8_t>(exit.direction));
+            open.push_back(OpenRoom{cost + landmarkBound(exit.room, to), cost, exit.room});
+            std::push_heap(open.begin(), open.end());
+        }
+    }
+    return false;
+}
+
+void RoomGraphQuery::reachableFrom(RoomId from, uint32_t maxDistance, std::vector<Reach>& result) {
+    result.clear();
+    if (from >= graph.getRoomCount()) return;
+
+    beginSearch();
+    visit(from, 0, INVALID_ROOM, NO_STEP);
+    result.push_back(Reach{from, 0, Direction::NORTH, INVALID_ROOM, Direction::NORTH});
+
+    for (size_t i = 0; i < result.size(); i++) {
+        Reach current = result[i];
+        if (current.distance == maxDistance) break;
+
+        for (const RoomExit& exit : graph.getExits(current.room)) {
+            if (visited(exit.room)) continue;
+            visit(exit.room, current.distance + 1, current.room, static_cast<uint8_t>(exit.direction));
+            Direction first = current.distance == 0 ? exit.direction : current.firstStep;
+            result.push_back(Reach{exit.room, current.distance + 1, first, current.room, exit.direction});
+        }
+    }
+}
+
+uint32_t RoomGraphQuery::distance(RoomId from, RoomId to) {
+    uint32_t roomCount = graph.getRoomCount();
+    if (from >= roomCount || to >= roomCount) return UNREACHABLE;
+    ensureBuilt();
+
+    if (usesAllPairs()) {
+        uint16_t hops = distanceTable[static_cast<size_t>(from) * roomCount + to];
+        return hops == FAR ? UNREACHABLE : hops;
+    }
+    return search(from, to) ? searchCost[to] : UNREACHABLE;
+}
+
+bool RoomGraphQuery::nextStep(RoomId from, RoomId to, Direction& direction) {
+    uint32_t roomCount = graph.getRoomCount();
+    if (from >= roomCount || to >= roomCount || from == to) return false;
+    ensureBuilt();
+
+    if (usesAllPairs()) {
+        uint8_t step = nextStepTable[static_cast<size_t>(from) * roomCount + to];
+        if (step == NO_STEP) return false;
+        direction = static_cast<Direction>(step);
+        return true;
+    }
+
+    std::vector<Direction> steps;
+    if (!findPath(from, to, steps)) return false;
+    direction = steps.front();
+    return true;
+}
+
+bool RoomGraphQuery::findPath(RoomId from, RoomId to, std::vector<Direction>& steps) {
+    steps.clear();
+    uint32_t roomCount = graph.getRoomCount();
+    if (from >= roomCount || to >= roomCount) return false;
+    ensureBuilt();
+
+    if (usesAllPairs()) {
+        for (RoomId room = from; room != to; ) {
+            uint8_t step = nextStepTable[static_cast<size_t>(room) * roomCount + to];
+            if (step == NO_STEP) return false;
+            steps.push_back(static_cast<Direction>(step));
+            room = graph.getExit(room, static_cast<Direction>(step));
+        }
+        return true;
+    }
+
+    if (!search(from, to)) return false;
+    for (RoomId room = to; room != from; room = searchPrevious[room]) {
+        steps.push_back(static_cast<Direction>(searchStep[room]));
+    }
+    std::reverse(steps.begin(), steps.end());
+    return true;
+}
+
+// Updates
+
+void RoomGraphQuery::exitAdded(RoomId from, Direction direction, RoomId to) {
+    // Only a cache that was current just before this exit can be patched
+    if (!built || builtVersion + 1 != graph.getVersion()) {
+        built = false;
+        return;
+    }
+    builtVersion = graph.getVersion();
+    uint32_t roomCount = graph.getRoomCount();
+
+    if (usesAllPairs()) {
+        // A new exit only shortens paths, and only those that use it:
+        // source -> from -> to -> target. Row `to` and column `from` cannot
+        // change, so they can be read while the rest is written.
+        const uint16_t* toRow = &distanceTable[static_cast<size_t>(to) * roomCount];
+        for (RoomId source = 0; source < roomCount; source++) {
+            size_t row = static_cast<size_t>(source) * roomCount;
+            uint16_t toFrom = distanceTable[row + from];
+            if (toFrom == FAR) continue;
+            uint8_t first = source == from ? static_cast<uint8_t>(direction) : nextStepTable[row + from];
+
+            for (RoomId target = 0; target < roomCount; target++) {
+                if (toRow[target] == FAR) continue;
+                uint32_t through = toFrom + 1u + toRow[target];
+                if (through < distanceTable[row + target]) {
+                    distanceTable[row + target] = static_cast<uint16_t>(through);
+                    nextStepTable[row + target] = first;
+                }
+            }
+        }
+        return;
+    }
+
+    // Keep the reversed exits in step, then repair each landmark's counts
+    // from the end of the new exit that got closer
+    reverseSources.insert(reverseSources.begin() + reverseFirst[to + 1], from);
+    for (uint32_t i = to + 1; i <= roomCount; i++) {
+        reverseFirst[i]++;
+    }
+    for (size_t k = 0; k < landmarks.size(); k++) {
+        uint32_t* fromRow = &fromLandmark[k * roomCount];
+        uint32_t* toRow = &toLandmark[k * roomCount];
+        if (fromRow[from] != UNREACHABLE && fromRow[from] + 1 < fromRow[to]) {
+            fromRow[to] = fromRow[from] + 1;
+            propagateDecrease(fromRow, to, false);
+        }
+        if (toRow[to] != UNREACHABLE && toRow[to] + 1 < toRow[from]) {
+            toRow[from] = toRow[to] + 1;
+            propagateDecrease(toRow, from, true);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "RoomGraph.h"
+#include <cstdint>
+#include <vector>
+
+// Shortest paths over a RoomGraph, counted in doorways. Every exit costs the
+// same, so breadth-first search is Dijkstra here, and it is what answers
+// bounded "what is near" queries on demand.
+//
+// Point-to-point queries use a cache built on first use after the graph
+// changes. Worlds of up to ALL_PAIRS_LIMIT rooms get a full table of
+// distances and first steps, so a query is one read. Larger worlds keep
+// hop counts to and from LANDMARK_COUNT landmark rooms and answer with A*,
+// using those counts as a lower bound on the distance left (ALT).
+//
+// Exits opened through exitAdded() update either cache in place; anything
+// else that changes the graph throws it away until the next query.
+class RoomGraphQuery {
+public:
+    // A room found by reachableFrom()
+    struct Reach {
+        RoomId room;
+        uint32_t distance;
+        Direction firstStep;    // exit taken out of the source; unset at distance 0
+        RoomId previous;        // room before this one on the path; INVALID_ROOM for the source
+        Direction lastStep;     // exit of previous that leads here
+    };
+
+private:
+    // A* frontier entry. Ordered so std::push_heap builds a min-heap.
+    struct OpenRoom {
+        uint32_t estimate;      // cost so far plus the landmark bound
+        uint32_t cost;
+        RoomId room;
+        bool operator<(const OpenRoom& other) const { return estimate > other.estimate; }
+    };
+
+    const RoomGraph& graph;
+    bool built;
+    uint32_t builtVersion;      // graph version the cache matches
+
+    // Small worlds: row-major roomCount x roomCount
+    std::vector<uint16_t> distanceTable;
+    std::vector<uint8_t> nextStepTable;
+
+    // Large worlds: one row of roomCount hop counts per landmark, plus the
+    // exits reversed so hops *to* a landmark can be counted
+    std::vector<RoomId> landmarks;
+    std::vector<uint32_t> fromLandmark;
+    std::vector<uint32_t> toLandmark;
+    std::vector<uint32_t> reverseFirst;
+    std::vector<RoomId> reverseSources;
+
+    // Search scratch. A room's entries are valid only when its stamp is the
+    // current one, so nothing is cleared between searches.
+    std::vector<uint32_t> searchStamp;
+    std::vector<uint32_t> searchCost;
+    std::vector<RoomId> searchPrevious;
+    std::vector<uint8_t> searchStep;
+    std::vector<RoomId> queue;
+    std::vector<OpenRoom> open;
+    uint32_t stamp;
+
+    void ensureBuilt();
+    void buildAllPairs();
+    void fillAllPairsRow(RoomId source);
+    void buildReverse();
+    void buildLandmarks();
+    void fillLandmarkRow(RoomId landmark, bool reverse, uint32_t* distance);
+    void propagateDecrease(uint32_t* distance, RoomId start, bool reverse);
+
+    void beginSearch();
+    bool visited(RoomId room) const { return searchStamp[room] == stamp; }
+    void visit(RoomId room, uint32_t cost, RoomId previous, uint8_t step);
+    uint32_t landmarkBound(RoomId room, RoomId target) const;
+    bool search(RoomId from, RoomId to);
+
+public:
+    static constexpr uint32_t UNREACHABLE = 0xFFFFFFFFu;
+    static constexpr uint32_t ALL_PAIRS_LIMIT = 1024;   // 3 MB of tables at the limit
+    static constexpr int LANDMARK_COUNT = 8;
+
+    explicit RoomGraphQuery(const RoomGraph& graph);
+
+    // Every room within maxDistance doorways of from, nearest first; ties go
+    // in exit order, so the result is the same each time
+    void reachableFrom(RoomId from, uint32_t maxDistance, std::vector<Reach>& result);
+
+    uint32_t distance(RoomId from, RoomId to);                          // UNREACHABLE if no path
+    bool nextStep(RoomId from, RoomId to, Direction& direction);        // false if no path or from == to
+    bool findPath(RoomId from, RoomId to, std::vector<Direction>& steps);
+
+    // Tell the cache about a new exit that was just added to the graph (not
+    // one that was redirected); it is patched rather than rebuilt
+    void exitAdded(RoomId from, Direction direction, RoomId to);
+    void invalidate() { built = false; }
+
+    bool usesAllPairs() const { return graph.getRoomCount() <= ALL_PAIRS_LIMIT; }
+    const RoomGraph& getGraph() const { return graph; }
+};
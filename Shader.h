@@ -1,49 +1,29 @@
-#version 330 core
-out vec4 FragColor;
+#pragma once
 
-in vec3 FragPos;
-in vec3 Normal;
-in vec2 TexCoords;
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
 
-uniform sampler2D texture1;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-
-void main()
-{
-    vec3 color = texture(texture1, TexCoords).rgb;
-
-    vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
-
-    float diff = max(dot(norm, lightDir), 0.0);
-
-    vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16.0);
-
-    vec3 ambient = 0.2 * color;
-    vec3 diffuse = diff * color;
-    vec3 specular = vec3(0.3) * spec;
-
-    FragColor = vec4(ambient + diffuse + specular, 1.0);
-}
-    ";
+class Shader {
+private:
+    GLuint program;
+    
+    GLuint compileShader(const std::string& source, GLenum type);
+    
+public:
+    Shader();
+    ~Shader();
+    
+    bool loadFromStrings(const std::string& vertexSource, const std::string& fragmentSource);
+    bool loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath);
+    
+    void use();
+    GLint getUniformLocation(const std::string& name);
     
-    // Vertex Shader Source
-    std::string vertexShaderSource = R"(
-        #version 330 core
-        layout (location = 0) in vec3 aPos;
-        layout (location = 1) in vec3 aNormal;
-        layout (location = 2) in vec2 aTexCoords;
-        
-        out vec3 FragPos;
-        out vec3 Normal;
-        out vec2 TexCoords;
-        
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
-        
-        void main() {
-            FragPos = vec3(model * vec4(aPos, 1.0));
\ No newline at end of file
+    // Uniform setters
+    void setFloat(const std::string& name, float value);
+    void setInt(const std::string& name, int value);
+    void setVec3(const std::string& name, const glm::vec3& value);
+    void setVec3(const std::string& name, float x, float y, float z);
+    void setMat4(const std::string& name, const glm::mat4& value);
+};
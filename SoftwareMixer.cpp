@@ -0,0 +1,397 @@
+#include "SoftwareMixer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const float QUARTER_PI = 0.78539816f;
+const float TWO_PI = 6.28318531f;
+
+// Reference frequency of EFX's low-pass
+const float LOWPASS_CUTOFF = 5000.0f;
+
+int getSampleBytes(MixerSampleType type) {
+    switch (type) {
+    case MixerSampleType::U8: return 1;
+    case MixerSampleType::S16: return 2;
+    case MixerSampleType::F32: return 4;
+    }
+    return 0;
+}
+
+} // namespace
+
+MixerStream::MixerStream(size_t capacityFrames)
+    : written(0), read(0), pendingRate(0), ended(false), paused(false), gain(1.0f), sampleRate(0), phase(0.0),
+      history{}, appliedGain(0.0f), fresh(true) {
+    size_t capacity = 1;
+    while (capacity < capacityFrames) capacity *= 2;
+    ring.resize(capacity * 2);
+    mask = capacity - 1;
+}
+
+void MixerStream::flush(int rate) {
+    ended.store(false, std::memory_order_relaxed);
+    pendingRate.store(std::max(rate, 1), std::memory_order_release);
+}
+
+size_t MixerStream::write(const float* frames, size_t count) {
+    if (isFlushing()) return 0;
+
+    uint64_t head = written.load(std::memory_order_relaxed);
+    count = std::min(count, getFreeFrames());
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = static_cast<size_t>((head + i) & mask) * 2;
+        ring[slot] = frames[2 * i];
+        ring[slot + 1] = frames[2 * i + 1];
+    }
+    written.store(head + count, std::memory_order_release);
+    return count;
+}
+
+size_t MixerStream::getFreeFrames() const {
+    if (isFlushing()) return 0;
+    return static_cast<size_t>(mask + 1) - getQueuedFrames();
+}
+
+size_t MixerStream::getQueuedFrames() const {
+    uint64_t tail = read.load(std::memory_order_acquire);
+    return static_cast<size_t>(written.load(std::memory_order_acquire) - tail);
+}
+
+SoftwareMixer::SoftwareMixer(int outputRate, int voiceCount)
+    : sampleRate(outputRate), resampler(MixerResampler::LINEAR), voices(voiceCount),
+      lowpassCoefficient(1.0f - std::exp(-TWO_PI * LOWPASS_CUTOFF / static_cast<float>(outputRate))),
+      listenerX(0.0f), listenerY(0.0f), listenerZ(0.0f), listenerAt{0.0f, 0.0f, -1.0f}, listenerUp{0.0f, 1.0f, 0.0f} {
+    for (Voice& voice : voices) {
+        voice.sound = -1;
+        voice.position = 0.0;
+        voice.params = MixerVoiceParams();
+        voice.gainLeft = voice.gainRight = 0.0f;
+        voice.filterLeft = voice.filterRight = 0.0f;
+        voice.fresh = true;
+    }
+}
+
+int SoftwareMixer::addSound(const void* data, size_t bytes, int channels, MixerSampleType type, int rate) {
+    size_t frameBytes = static_cast<size_t>(getSampleBytes(type)) * static_cast<size_t>(channels);
+    if ((channels != 1 && channels != 2) || rate <= 0 || frameBytes == 0 || bytes < frameBytes) return 0;
+
+    size_t index = 0;
+    while (index < sounds.size() && sounds[index].used) index++;
+    if (index == sounds.size()) sounds.push_back(Sound());
+
+    Sound& sound = sounds[index];
+    sound.channels = channels;
+    sound.sampleRate = rate;
+    sound.frames = static_cast<int64_t>(bytes / frameBytes);
+    sound.used = true;
+
+    size_t count = static_cast<size_t>(sound.frames) * channels;
+    size_t before = static_cast<size_t>(RESAMPLER_FRAMES_BEFORE) * channels;
+    size_t after = static_cast<size_t>(RESAMPLER_FRAMES_AFTER) * channels;
+    sound.samples.resize(before + count + after);
+    float* out = sound.samples.data() + before;
+    if (type == MixerSampleType::U8) {
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < count; i++) out[i] = (static_cast<float>(in[i]) - 128.0f) / 128.0f;
+    } else if (type == MixerSampleType::S16) {
+        const int16_t* in = static_cast<const int16_t*>(data);
+        for (size_t i = 0; i < count; i++) out[i] = static_cast<float>(in[i]) / 32768.0f;
+    } else {
+        std::memcpy(out, data, count * sizeof(float));
+    }
+
+    // The resamplers read a few frames either side of the sound; wrapping
+    // around keeps loops seamless
+    for (size_t i = 0; i < before; i++) sound.samples[i] = out[(count - before % count + i) % count];
+    for (size_t i = 0; i < after; i++) out[count + i] = out[i % count];
+
+    return static_cast<int>(index) + 1;
+}
+
+void SoftwareMixer::removeSound(int id) {
+    int index = id - 1;
+    if (index < 0 || index >= static_cast<int>(sounds.size())) return;
+
+    for (Voice& voice : voices) {
+        if (voice.sound == index) voice.sound = -1;
+    }
+    sounds[index].used = false;
+    sounds[index].samples.clear();
+    sounds[index].samples.shrink_to_fit();
+}
+
+float SoftwareMixer::getSoundDuration(int id) const {
+    int index = id - 1;
+    if (index < 0 || index >= static_cast<int>(sounds.size()) || !sounds[index].used) return 0.0f;
+    return static_cast<float>(sounds[index].frames) / static_cast<float>(sounds[index].sampleRate);
+}
+
+void SoftwareMixer::play(int voice, int sound, float offsetSeconds, const MixerVoiceParams& params) {
+    int index = sound - 1;
+    if (voice < 0 || voice >= static_cast<int>(voices.size())) return;
+    if (index < 0 || index >= static_cast<int>(sounds.size()) || !sounds[index].used) return;
+
+    const Sound& data = sounds[index];
+    double position = static_cast<double>(std::max(offsetSeconds, 0.0f)) * data.sampleRate;
+    if (position >= static_cast<double>(data.frames)) {
+        if (!params.looping) {
+            voices[voice].sound = -1;
+            return;
+        }
+        position = std::fmod(position, static_cast<double>(data.frames));
+    }
+
+    Voice& target = voices[voice];
+    target.sound = index;
+    target.position = position;
+    target.params = params;
+    target.filterLeft = target.filterRight = 0.0f;
+    target.fresh = true;
+}
+
+void SoftwareMixer::setVoicePosition(int voice, float x, float y, float z) {
+    if (voice < 0 || voice >= static_cast<int>(voices.size())) return;
+    voices[voice].params.x = x;
+    voices[voice].params.y = y;
+    voices[voice].params.z = z;
+}
+
+void SoftwareMixer::setVoiceGain(int voice, float gain, float gainHF) {
+    if (voice < 0 || voice >= static_cast<int>(voices.size())) return;
+    voices[voice].params.gain = gain;
+    voices[voice].params.gainHF = gainHF;
+}
+
+void SoftwareMixer::stop(int voice) {
+    if (voice < 0 || voice >= static_cast<int>(voices.size())) return;
+    voices[voice].sound = -1;
+}
+
+void SoftwareMixer::stopAll() {
+    for (Voice& voice : voices) {
+        voice.sound = -1;
+    }
+}
+
+MixerStream* SoftwareMixer::addStream(size_t capacityFrames) {
+    streams.push_back(std::make_unique<MixerStream>(capacityFrames));
+    return streams.back().get();
+}
+
+void SoftwareMixer::setListener(float x, float y, float z, const float orientation[6]) {
+    listenerX = x;
+    listenerY = y;
+    listenerZ = z;
+    std::copy(orientation, orientation + 3, listenerAt);
+    std::copy(orientation + 3, orientation + 6, listenerUp);
+}
+
+void SoftwareMixer::computeGains(const Voice& voice, const Sound& sound, float& left, float& right) const {
+    const MixerVoiceParams& p = voice.params;
+
+    // Offset from the listener, and how far it lies to the listener's right.
+    // Relative sources are already in the listener's frame, as in OpenAL.
+    float dx = p.x, dy = p.y, dz = p.z;
+    float side = p.x;
+    if (!p.relative) {
+        dx -= listenerX;
+        dy -= listenerY;
+        dz -= listenerZ;
+
+        // right = at x up
+        float rx = listenerAt[1] * listenerUp[2] - listenerAt[2] * listenerUp[1];
+        float ry = listenerAt[2] * listenerUp[0] - listenerAt[0] * listenerUp[2];
+        float rz = listenerAt[0] * listenerUp[1] - listenerAt[1] * listenerUp[0];
+        float length = std::sqrt(rx * rx + ry * ry + rz * rz);
+        side = length > 0.0f ? (dx * rx + dy * ry + dz * rz) / length : 0.0f;
+    }
+
+    // AL_INVERSE_DISTANCE_CLAMPED with reference distance and rolloff of 1
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    float gain = p.gain / std::max(distance, 1.0f);
+
+    if (sound.channels == 2) {
+        left = right = gain;
+        return;
+    }
+
+    // Equal-power pan: centred sounds get -3 dB on each side
+    float pan = distance > 0.0f ? std::max(-1.0f, std::min(1.0f, side / distance)) : 0.0f;
+    float angle = (pan + 1.0f) * QUARTER_PI;
+    left = gain * std::cos(angle);
+    right = gain * std::sin(angle);
+}
+
+void SoftwareMixer::mixVoice(Voice& voice, float* bus, int frames) {
+    const Sound& sound = sounds[voice.sound];
+    float step = voice.params.pitch * static_cast<float>(sound.sampleRate) / static_cast<float>(sampleRate);
+    if (!(step > 0.0f)) {
+        voice.sound = -1;
+        return;
+    }
+
+    // Ramp from last block's gains so moving sounds do not click
+    float targetLeft, targetRight;
+    computeGains(voice, sound, targetLeft, targetRight);
+    if (voice.fresh) {
+        voice.gainLeft = targetLeft;
+        voice.gainRight = targetRight;
+        voice.fresh = false;
+    }
+    float leftStep = (targetLeft - voice.gainLeft) / static_cast<float>(frames);
+    float rightStep = (targetRight - voice.gainRight) / static_cast<float>(frames);
+    
+    bool filtered = voice.params.gainHF < 1.0f;
+    float* target = bus;
+    if (filtered) {
+        size_t samples = static_cast<size_t>(frames) * 2;
+        if (scratch.size() < samples) scratch.resize(samples);
+        std::fill(scratch.begin(), scratch.begin() + samples, 0.0f);
+        target = scratch.data();
+    } else {
+        voice.filterLeft = voice.filterRight = 0.0f;
+    }
+
+    const float* filter = resampler == MixerResampler::POLYPHASE ? getPolyphaseFilter(step) : nullptr;
+    double length = static_cast<double>(sound.frames);
+    double last = length - 1.0;
+    int done = 0;
+    while (done < frames) {
+        if (voice.position >= length) {
+            if (!voice.params.looping) {
+                voice.sound = -1;
+                break;
+            }
+            voice.position = std::fmod(voice.position, length);
+        }
+
+        // Longest stretch before interpolation would run past the end
+        double fit = voice.position <= last ? std::floor((last - voice.position) / step) + 1.0 : 1.0;
+        int count = static_cast<int>(std::min(fit, static_cast<double>(frames - done)));
+
+        MixSegment segment;
+        segment.samples = sound.samples.data() + RESAMPLER_FRAMES_BEFORE * sound.channels;
+        segment.channels = sound.channels;
+        segment.position = voice.position;
+        segment.step = step;
+        segment.gainLeft = voice.gainLeft + leftStep * static_cast<float>(done);
+        segment.gainRight = voice.gainRight + rightStep * static_cast<float>(done);
+        segment.gainLeftStep = leftStep;
+        segment.gainRightStep = rightStep;
+        segment.filter = filter;
+        mixSegment(segment, target + 2 * done, count);
+
+        voice.position += static_cast<double>(count) * step;
+        done += count;
+    }
+
+    voice.gainLeft = targetLeft;
+    voice.gainRight = targetRight;
+    
+    // Over the whole block even if the sound ended, so the filter rings out
+    if (filtered) applyLowpass(voice, bus, frames);
+}
+
+void SoftwareMixer::applyLowpass(Voice& voice, float* bus, int frames) {
+    // Low band plus the rest scaled by gainHF: a shelf, so gainHF = 1 is flat
+    float a = lowpassCoefficient;
+    float highGain = std::max(voice.params.gainHF, 0.0f);
+    float left = voice.filterLeft, right = voice.filterRight;
+    for (int i = 0; i < frames; i++) {
+        float inLeft = scratch[2 * i], inRight = scratch[2 * i + 1];
+        left += a * (inLeft - left);
+        right += a * (inRight - right);
+        bus[2 * i] += left + highGain * (inLeft - left);
+        bus[2 * i + 1] += right + highGain * (inRight - right);
+    }
+    voice.filterLeft = left;
+    voice.filterRight = right;
+}
+
+void SoftwareMixer::mixStream(MixerStream& stream, float* bus, int frames) {
+    // A flush drops everything the producer had written when it asked
+    int rate = stream.pendingRate.load(std::memory_order_acquire);
+    if (rate > 0) {
+        stream.read.store(stream.written.load(std::memory_order_acquire), std::memory_order_release);
+        stream.sampleRate = rate;
+        stream.phase = 0.0;
+        std::fill(stream.history, stream.history + RESAMPLER_FRAMES_BEFORE * 2, 0.0f);
+        stream.fresh = true;
+        stream.pendingRate.compare_exchange_strong(rate, 0, std::memory_order_acq_rel);
+    }
+    if (stream.sampleRate <= 0 || stream.paused.load(std::memory_order_relaxed) || stream.isFlushing()) return;
+
+    float step = static_cast<float>(stream.sampleRate) / static_cast<float>(sampleRate);
+    bool ended = stream.ended.load(std::memory_order_acquire);
+    uint64_t start = stream.read.load(std::memory_order_relaxed);
+    int64_t queued = static_cast<int64_t>(stream.written.load(std::memory_order_acquire) - start);
+
+    // Mid-stream the resamplers' look-ahead must already be queued, with a
+    // frame to spare for the kernels' float positions. At the end it is
+    // silence, so the last frames play too.
+    int64_t readable = ended ? queued + RESAMPLER_FRAMES_AFTER + 2 : queued;
+    auto lastRead = [&](int count) {
+        return static_cast<int64_t>(std::floor(stream.phase + static_cast<double>(count - 1) * step)) +
+               RESAMPLER_FRAMES_AFTER + 1;
+    };
+    auto consumed = [&](int count) {
+        return static_cast<int64_t>(std::floor(stream.phase + static_cast<double>(count) * step));
+    };
+    int count = static_cast<int>(std::min<double>(frames, std::max(0.0, (queued - stream.phase) / step + 1.0)));
+    while (count > 0 && (lastRead(count) >= readable || consumed(count) > queued)) count--;
+
+    float target = stream.gain.load(std::memory_order_relaxed);
+    if (stream.fresh) {
+        stream.appliedGain = target;
+        stream.fresh = false;
+    }
+    float gainStep = (target - stream.appliedGain) / static_cast<float>(frames);
+    if (count == 0) {
+        stream.appliedGain = target;
+        return;
+    }
+
+    // History, then the queued frames the block reads, then silence
+    int64_t copied = std::min(queued, std::max(lastRead(count) + 1, consumed(count)));
+    int64_t length = std::max(lastRead(count) + 1, copied);
+    window.assign(static_cast<size_t>(RESAMPLER_FRAMES_BEFORE + length) * 2, 0.0f);
+    std::copy(stream.history, stream.history + RESAMPLER_FRAMES_BEFORE * 2, window.begin());
+    float* frameData = window.data() + RESAMPLER_FRAMES_BEFORE * 2;
+    for (int64_t i = 0; i < copied; i++) {
+        size_t slot = static_cast<size_t>((start + static_cast<uint64_t>(i)) & stream.mask) * 2;
+        frameData[2 * i] = stream.ring[slot];
+        frameData[2 * i + 1] = stream.ring[slot + 1];
+    }
+
+    MixSegment segment;
+    segment.samples = frameData;
+    segment.channels = 2;
+    segment.position = stream.phase;
+    segment.step = step;
+    segment.gainLeft = segment.gainRight = stream.appliedGain;
+    segment.gainLeftStep = segment.gainRightStep = gainStep;
+    segment.filter = resampler == MixerResampler::POLYPHASE ? getPolyphaseFilter(step) : nullptr;
+    mixSegment(segment, bus, count);
+
+    int64_t advance = consumed(count);
+    stream.phase = stream.phase + static_cast<double>(count) * step - static_cast<double>(advance);
+    std::copy(window.begin() + advance * 2, window.begin() + (advance + RESAMPLER_FRAMES_BEFORE) * 2,
+              stream.history);
+    stream.appliedGain = target;
+    stream.read.store(start + static_cast<uint64_t>(advance), std::memory_order_release);
+}
+
+void SoftwareMixer::mix(float* bus, int frames) {
+    std::fill(bus, bus + static_cast<size_t>(frames) * 2, 0.0f);
+    if (frames <= 0) return;
+
+    for (Voice& voice : voices) {
+        if (voice.sound >= 0) mixVoice(voice, bus, frames);
+    }
+    for (auto& stream : streams) {
+        mixStream(*stream, bus, frames);
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "MixerKernels.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class MixerSampleType {
+    U8,
+    S16,
+    F32
+};
+
+// Parameters of a voice that can change while it plays
+struct MixerVoiceParams {
+    float x, y, z;
+    bool relative;          // position is relative to the listener
+    float gain;
+    float gainHF;           // high-frequency gain of a low-pass, 1 = unfiltered
+    float pitch;
+    bool looping;
+};
+
+// Interleaved stereo frames pushed by one producer thread, such as a music
+// stream, and played by the mixer at their own rate. The producer calls only
+// the public functions, which are lock-free and safe while the mixer runs.
+class MixerStream {
+private:
+    friend class SoftwareMixer;
+
+    std::vector<float> ring;
+    uint64_t mask;                      // capacity in frames, minus one
+    std::atomic<uint64_t> written;      // frames, advanced by the producer
+    std::atomic<uint64_t> read;         // frames, advanced by the mixer
+    std::atomic<int> pendingRate;       // > 0 until the mixer has done a flush
+    std::atomic<bool> ended;
+    std::atomic<bool> paused;
+    std::atomic<float> gain;
+
+    // Mixer side
+    int sampleRate;                     // 0 until the first flush
+    double phase;                       // fractional frame past `read`
+    float history[RESAMPLER_FRAMES_BEFORE * 2];     // frames just before `read`
+    float appliedGain;
+    bool fresh;                         // no ramp on the first block
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit MixerStream(size_t capacityFrames);
+
+    // Drop everything queued and expect frames at sampleRate from now on.
+    // Nothing is accepted until the mixer has caught up.
+    void flush(int sampleRate);
+    bool isFlushing() const { return pendingRate.load(std::memory_order_acquire) != 0; }
+
+    // Returns the frames accepted
+    size_t write(const float* frames, size_t count);
+    size_t getFreeFrames() const;
+    size_t getQueuedFrames() const;
+
+    // Nothing more is coming before the next flush: play out the frames the
+    // resamplers would otherwise hold back as look-ahead
+    void finish() { ended.store(true, std::memory_order_release); }
+
+    void setPaused(bool value) { paused.store(value, std::memory_order_relaxed); }
+    void setGain(float value) { gain.store(value, std::memory_order_relaxed); }
+};
+
+// In-house replacement for OpenAL's mixing: a fixed set of voices, resampled
+// and panned into an interleaved stereo float bus. Mono sounds are placed in
+// 3D with the same inverse-distance model (reference distance 1, rolloff 1)
+// and listener frame OpenAL uses, then equal-power panned; stereo sounds are
+// attenuated but not panned, as in OpenAL. The low-pass is a one-pole shelf
+// at 5 kHz, like EFX's AL_FILTER_LOWPASS. Streams are mixed in on top of the
+// voices, unpanned. Not thread safe: the audio thread owns it.
+class SoftwareMixer {
+private:
+    struct Sound {
+        std::vector<float> samples;     // interleaved, padded for the resamplers at both ends
+        int channels;
+        int sampleRate;
+        int64_t frames;
+        bool used;
+    };
+
+    struct Voice {
+        int sound;                      // -1 when idle
+        double position;                // in source frames
+        MixerVoiceParams params;
+        float gainLeft, gainRight;      // applied at the end of the last block
+        float filterLeft, filterRight;  // low-pass state
+        bool fresh;                     // no ramp on the first block
+    };
+
+    int sampleRate;
+    MixerResampler resampler;
+    std::vector<Sound> sounds;
+    std::vector<Voice> voices;
+    std::vector<std::unique_ptr<MixerStream>> streams;
+    
+    // Streams are copied here with their history so the kernels can read
+    // them in one piece
+    std::vector<float> window;
+    
+    // Filtered voices are mixed here first, then low-passed into the bus
+    std::vector<float> scratch;
+    float lowpassCoefficient;
+
+    float listenerX, listenerY, listenerZ;
+    float listenerAt[3];
+    float listenerUp[3];
+
+    void computeGains(const Voice& voice, const Sound& sound, float& left, float& right) const;
+    void mixVoice(Voice& voice, float* bus, int frames);
+    void applyLowpass(Voice& voice, float* bus, int frames);
+    void mixStream(MixerStream& stream, float* bus, int frames);
+
+public:
+    SoftwareMixer(int outputRate, int voiceCount);
+
+    int getSampleRate() const { return sampleRate; }
+
+    // Linear by default; polyphase costs more per voice but does not dull
+    // or alias resampled sounds
+    void setResampler(MixerResampler type) { resampler = type; }
+    MixerResampler getResampler() const { return resampler; }
+    int getVoiceCount() const { return static_cast<int>(voices.size()); }
+
+    // Convert a sound to float and keep it. Returns an id > 0, or 0 if the
+    // data is unusable. Ids of removed sounds are reused.
+    int addSound(const void* data, size_t bytes, int channels, MixerSampleType type, int rate);
+    void removeSound(int id);
+    float getSoundDuration(int id) const;
+
+    // Start sound on voice slot `voice` (replacing whatever it played),
+    // offsetSeconds into the sound
+    void play(int voice, int sound, float offsetSeconds, const MixerVoiceParams& params);
+    void setVoicePosition(int voice, float x, float y, float z);
+    void setVoiceGain(int voice, float gain, float gainHF);
+    void stop(int voice);
+    void stopAll();
+    bool isPlaying(int voice) const { return voices[voice].sound >= 0; }
+
+    void setListener(float x, float y, float z, const float orientation[6]);
+
+    // Add a stream holding up to capacityFrames. Call before the mixer is
+    // shared with another thread; streams live as long as the mixer.
+    MixerStream* addStream(size_t capacityFrames);
+
+    // Overwrite bus with frames of interleaved stereo
+    void mix(float* bus, int frames);
+};
@@ -0,0 +1,108 @@
+#include "SoundPropagation.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Room layout, matching the renderer and the exit triggers in GameEngine
+const float ROOM_HALF_SIZE = 10.0f;
+const float ROOM_SIZE = 2.0f * ROOM_HALF_SIZE;      // door to door across a room
+const float CEILING_HEIGHT = 4.0f;
+const float FLOOR_DEPTH = 2.0f;
+
+// Each doorway lets through this much of the sound, and less of its highs
+const float DOORWAY_GAIN = 0.7f;
+const float DOORWAY_GAINHF = 0.5f;
+
+// Path beyond the doorway at which a sound is halved. Gentler than the
+// mixer's inverse distance so a fight next door stays audible.
+const float PATH_FALLOFF = 10.0f;
+
+} // namespace
+
+SoundPropagation::SoundPropagation() : listenerRoom(INVALID_ROOM), graphVersion(0) {}
+
+bool SoundPropagation::setListenerRoom(RoomGraphQuery& query, RoomId roomId) {
+    const RoomGraph& graph = query.getGraph();
+    if (roomId == listenerRoom && graphVersion == graph.getVersion() && !reachable.empty()) return false;
+
+    listenerRoom = roomId;
+    graphVersion = graph.getVersion();
+    paths.assign(graph.getRoomCount(), RoomPath{-1, Direction::NORTH, Direction::NORTH, false});
+    reachable.clear();
+
+    // The first time a room is reached is by the fewest doorways; ties
+    // always go the same way
+    query.reachableFrom(roomId, MAX_HOPS, search);
+    for (const RoomGraphQuery::Reach& reach : search) {
+        RoomPath& path = paths[reach.room];
+        path.hops = static_cast<int>(reach.distance);
+        path.arrivalExit = reach.firstStep;
+        reachable.push_back(reach.room);
+        if (reach.distance == 0) continue;
+
+        // The way back is the door the sound leaves by; one-way exits have
+        // none, so the sound is taken from the room centre
+        Direction back = getOppositeDirection(reach.lastStep);
+        path.hasEntry = graph.getExit(reach.room, back) == reach.previous;
+        if (!path.hasEntry) {
+            for (const RoomExit& other : graph.getExits(reach.room)) {
+                if (other.room == reach.previous) {
+                    back = other.direction;
+                    path.hasEntry = true;
+                    break;
+                }
+            }
+        }
+        path.entryExit = back;
+    }
+    return true;
+}
+
+void SoundPropagation::clear() {
+    paths.clear();
+    reachable.clear();
+    listenerRoom = INVALID_ROOM;
+}
+
+SoundRoute SoundPropagation::route(RoomId roomId, const glm::vec3& position) const {
+    SoundRoute route;
+    route.audible = false;
+    route.hops = 0;
+    route.position = position;
+    route.pathLength = 0.0f;
+    route.gain = 0.0f;
+    route.gainHF = 1.0f;
+
+    if (roomId >= paths.size() || paths[roomId].hops < 0) return route;
+
+    const RoomPath& path = paths[roomId];
+    route.audible = true;
+    route.hops = path.hops;
+    if (path.hops == 0) {
+        route.gain = 1.0f;
+        return route;
+    }
+
+    // From the doorway we hear it through: across every room in between,
+    // then from the door of the sound's room to the sound
+    glm::vec3 entry = path.hasEntry ? getDoorway(path.entryExit) : glm::vec3(0.0f);
+    route.position = getDoorway(path.arrivalExit);
+    route.pathLength = static_cast<float>(path.hops - 1) * ROOM_SIZE + glm::length(position - entry);
+    route.gain = std::pow(DOORWAY_GAIN, static_cast<float>(path.hops)) *
+                 PATH_FALLOFF / (PATH_FALLOFF + route.pathLength);
+    route.gainHF = std::pow(DOORWAY_GAINHF, static_cast<float>(path.hops));
+    return route;
+}
+
+glm::vec3 SoundPropagation::getDoorway(Direction direction) {
+    switch (direction) {
+    case Direction::NORTH: return glm::vec3(0.0f, 0.0f, -ROOM_HALF_SIZE);
+    case Direction::SOUTH: return glm::vec3(0.0f, 0.0f, ROOM_HALF_SIZE);
+    case Direction::EAST: return glm::vec3(ROOM_HALF_SIZE, 0.0f, 0.0f);
+    case Direction::WEST: return glm::vec3(-ROOM_HALF_SIZE, 0.0f, 0.0f);
+    case Direction::UP: return glm::vec3(0.0f, CEILING_HEIGHT, 0.0f);
+    case Direction::DOWN: return glm::vec3(0.0f, -FLOOR_DEPTH, 0.0f);
+    }
+    return glm::vec3(0.0f);
+}
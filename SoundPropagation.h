@@ -0,0 +1,57 @@
+#pragma once
+
+#include "RoomGraph.h"
+#include "RoomGraphQuery.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// How a sound in some room reaches the listener: where to play it in the
+// listener room's frame and how much to muffle it
+struct SoundRoute {
+    bool audible;               // within MAX_HOPS exits of the listener
+    int hops;                   // doorways crossed, 0 in the listener's room
+    glm::vec3 position;         // the doorway it arrives through, or the sound itself
+    float pathLength;           // metres from that doorway to the sound
+    float gain;                 // on top of the mixer's distance attenuation
+    float gainHF;               // high-frequency gain, 1 = unfiltered
+};
+
+// Carries sounds through doorways instead of through walls. Paths over the
+// room exit graph are found breadth-first (RoomGraphQuery::reachableFrom)
+// from the listener's room when the listener changes room or an exit
+// changes, and cached per RoomId, so routing a sound is one array read. Every room shares the renderer's
+// layout: a 20 m square centred on the origin with its exits in the middle
+// of each wall.
+class SoundPropagation {
+private:
+    struct RoomPath {
+        int hops;                   // -1 if out of range
+        Direction arrivalExit;      // exit of the listener's room the path leaves by
+        Direction entryExit;        // exit of this room the path enters by
+        bool hasEntry;              // false for one-way exits
+    };
+
+    std::vector<RoomPath> paths;            // indexed by RoomId
+    std::vector<RoomId> reachable;          // rooms within MAX_HOPS, nearest first
+    std::vector<RoomGraphQuery::Reach> search;
+    RoomId listenerRoom;
+    uint32_t graphVersion;
+
+public:
+    static const int MAX_HOPS = 3;
+
+    SoundPropagation();
+
+    // Recomputes paths if roomId differs from the current listener room or
+    // the graph has changed since. Returns true when it did.
+    bool setListenerRoom(RoomGraphQuery& query, RoomId roomId);
+    RoomId getListenerRoom() const { return listenerRoom; }
+    const std::vector<RoomId>& getReachableRooms() const { return reachable; }
+    void clear();
+
+    // Route for a sound at position (in its room's frame) in roomId
+    SoundRoute route(RoomId roomId, const glm::vec3& position) const;
+
+    // Where an exit sits in its room
+    static glm::vec3 getDoorway(Direction direction);
+};
@@ -0,0 +1,167 @@
+#include "Soundscape.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+
+namespace {
+
+// Ambient sounds keep clear of the walls so they never sit in a doorway
+const float SCATTER_EXTENT = 8.0f;
+
+// A one-shot that cannot play (not loaded, out of budget) tries again soon
+// rather than waiting a whole interval
+const float RETRY_DELAY = 0.5f;
+
+} // namespace
+
+Soundscape::Soundscape() : time(0.0) {}
+
+glm::vec3 Soundscape::getLoopPosition(std::string_view roomKey, const std::string& file) {
+    // Fixed per room and sound so a loop is always in the same place
+    Pcg32 placement(std::hash<std::string_view>()(roomKey), std::hash<std::string>()(file));
+    return glm::vec3(placement.range(-SCATTER_EXTENT, SCATTER_EXTENT), 1.0f,
+                     placement.range(-SCATTER_EXTENT, SCATTER_EXTENT));
+}
+
+void Soundscape::setListenerRoom(const WorldManager& world, const SoundPropagation& propagation,
+                                 AudioEngine& audio) {
+    // Rooms in range, nearest first
+    std::vector<RoomId> nearby;
+    for (RoomId id : propagation.getReachableRooms()) {
+        if (propagation.route(id, glm::vec3(0.0f)).hops > AMBIENT_RANGE) break;
+        if (!world.getRoomBiome(id).empty()) nearby.push_back(id);
+    }
+
+    // One-shot emitters for rooms still in range keep their place in the
+    // schedule; new rooms start at a random point in their first interval
+    std::map<std::pair<RoomId, std::string>, double> previous;
+    for (const Event& event : schedule) {
+        const OneShotEmitter& emitter = emitters[event.emitter];
+        previous[{emitter.roomId, emitter.sound.file}] = event.time;
+    }
+
+    std::vector<OneShotEmitter> nextEmitters;
+    std::vector<Event> nextSchedule;
+    std::vector<Loop> nextLoops;
+
+    for (RoomId roomId : nearby) {
+        std::string_view roomKey = world.getRoomKey(roomId);
+        const BiomeData* biome = world.findBiome(world.getRoomBiome(roomId));
+        if (!biome) continue;
+
+        for (const AmbientSound& sound : biome->ambientSounds) {
+            if (sound.loop) {
+                bool taken = std::any_of(nextLoops.begin(), nextLoops.end(),
+                                         [&sound](const Loop& loop) { return loop.sound.file == sound.file; });
+                if (!taken && static_cast<int>(nextLoops.size()) < MAX_LOOPS) {
+                    nextLoops.push_back(Loop{roomId, sound, getLoopPosition(roomKey, sound.file),
+                                             INVALID_PLAYBACK});
+                }
+                continue;
+            }
+
+            OneShotEmitter emitter;
+            emitter.roomId = roomId;
+            emitter.sound = sound;
+            emitter.random = Pcg32(std::hash<std::string_view>()(roomKey), std::hash<std::string>()(sound.file));
+
+            auto it = previous.find({roomId, sound.file});
+            double next = it != previous.end() ? it->second : time + emitter.random.range(0.0f, sound.maxInterval);
+            nextSchedule.push_back(Event{next, static_cast<int>(nextEmitters.size())});
+            nextEmitters.push_back(emitter);
+        }
+    }
+
+    // Loops that are still wanted carry on, moved to their new room; the rest
+    // stop, and new ones start
+    for (Loop& loop : nextLoops) {
+        auto it = std::find_if(loops.begin(), loops.end(),
+                               [&loop](const Loop& old) { return old.sound.file == loop.sound.file; });
+        if (it == loops.end() || it->playback == INVALID_PLAYBACK) {
+            startLoop(loop, propagation, audio);
+            continue;
+        }
+
+        loop.playback = it->playback;
+        it->playback = INVALID_PLAYBACK;
+        SoundRoute route = propagation.route(loop.roomId, loop.position);
+        audio.setPlaybackPosition(loop.playback, route.position.x, route.position.y, route.position.z);
+        audio.setPlaybackOcclusion(loop.playback, route.gain, route.gainHF);
+    }
+    for (const Loop& loop : loops) {
+        if (loop.playback != INVALID_PLAYBACK) audio.stopPlayback(loop.playback);
+    }
+
+    emitters.swap(nextEmitters);
+    schedule.swap(nextSchedule);
+    loops.swap(nextLoops);
+    std::make_heap(schedule.begin(), schedule.end());
+}
+
+void Soundscape::startLoop(Loop& loop, const SoundPropagation& propagation, AudioEngine& audio) {
+    SoundHandle handle = audio.getSoundHandle(loop.sound.file);
+    if (!audio.isSoundReady(handle)) return;
+
+    SoundRoute route = propagation.route(loop.roomId, loop.position);
+    loop.playback = audio.playSoundOccluded(handle, route.position.x, route.position.y, route.position.z,
+                                            loop.sound.volume, route.gain, route.gainHF, VoicePriority::AMBIENT,
+                                            true);
+}
+
+void Soundscape::fire(OneShotEmitter& emitter, const SoundPropagation& propagation, AudioEngine& audio) {
+    const AmbientSound& sound = emitter.sound;
+    glm::vec3 position(emitter.random.range(-SCATTER_EXTENT, SCATTER_EXTENT), emitter.random.range(0.5f, 3.0f),
+                       emitter.random.range(-SCATTER_EXTENT, SCATTER_EXTENT));
+    float pitch = emitter.random.range(sound.minPitch, sound.maxPitch);
+
+    SoundRoute route = propagation.route(emitter.roomId, position);
+    if (!route.audible) return;
+
+    SoundHandle handle = audio.getSoundHandle(sound.file);
+    PlaybackId playback = audio.playSoundOccluded(handle, route.position.x, route.position.y, route.position.z,
+                                                  sound.volume, route.gain, route.gainHF, VoicePriority::AMBIENT,
+                                                  false, pitch);
+    if (playback != INVALID_PLAYBACK) {
+        oneShotEnds.push_back(time + audio.getSoundDuration(handle) / pitch);
+    }
+}
+
+void Soundscape::update(float deltaTime, const SoundPropagation& propagation, AudioEngine& audio) {
+    time += deltaTime;
+
+    // Loops whose sound was still loading
+    for (Loop& loop : loops) {
+        if (loop.playback == INVALID_PLAYBACK) startLoop(loop, propagation, audio);
+    }
+
+    oneShotEnds.erase(std::remove_if(oneShotEnds.begin(), oneShotEnds.end(),
+                                     [this](double end) { return end <= time; }),
+                      oneShotEnds.end());
+
+    for (int fired = 0; fired < MAX_EVENTS_PER_UPDATE && !schedule.empty(); fired++) {
+        if (schedule.front().time > time) break;
+
+        std::pop_heap(schedule.begin(), schedule.end());
+        Event& event = schedule.back();
+        OneShotEmitter& emitter = emitters[event.emitter];
+
+        bool ready = audio.isSoundReady(audio.getSoundHandle(emitter.sound.file));
+        if (ready && static_cast<int>(oneShotEnds.size()) < MAX_ONE_SHOTS) {
+            fire(emitter, propagation, audio);
+            event.time = time + emitter.random.range(emitter.sound.minInterval, emitter.sound.maxInterval);
+        } else {
+            event.time = time + RETRY_DELAY;
+        }
+        std::push_heap(schedule.begin(), schedule.end());
+    }
+}
+
+void Soundscape::clear(AudioEngine& audio) {
+    for (const Loop& loop : loops) {
+        if (loop.playback != INVALID_PLAYBACK) audio.stopPlayback(loop.playback);
+    }
+    emitters.clear();
+    schedule.clear();
+    oneShotEnds.clear();
+    loops.clear();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "AudioEngine.h"
+#include "FastRandom.h"
+#include "RoomGraph.h"
+#include "SoundPropagation.h"
+#include "WorldManager.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Plays the ambient layers of the biomes around the listener. Each room within
+// AMBIENT_RANGE doorways gets one emitter per one-shot layer; their next
+// firing times sit in a min-heap, so an update only touches emitters that are
+// due, and at most MAX_EVENTS_PER_UPDATE of those. Loops are shared: each
+// loop sound plays once, from the nearest room that has it, up to MAX_LOOPS.
+// Rooms further away have no emitters at all. Everything plays through
+// SoundPropagation, so neighbouring rooms are heard through their doorways.
+class Soundscape {
+private:
+    struct OneShotEmitter {
+        RoomId roomId;
+        AmbientSound sound;
+        Pcg32 random;
+    };
+
+    struct Loop {
+        RoomId roomId;
+        AmbientSound sound;
+        glm::vec3 position;
+        PlaybackId playback;        // INVALID_PLAYBACK until its sound has loaded
+    };
+
+    // Next firing of an emitter. Ordered so std::push_heap builds a min-heap.
+    struct Event {
+        double time;
+        int emitter;
+        bool operator<(const Event& other) const { return time > other.time; }
+    };
+
+    std::vector<OneShotEmitter> emitters;
+    std::vector<Event> schedule;
+    std::vector<double> oneShotEnds;    // when each playing one-shot finishes
+    std::vector<Loop> loops;
+    double time;
+
+    static glm::vec3 getLoopPosition(std::string_view roomKey, const std::string& file);
+    void startLoop(Loop& loop, const SoundPropagation& propagation, AudioEngine& audio);
+    void fire(OneShotEmitter& emitter, const SoundPropagation& propagation, AudioEngine& audio);
+
+public:
+    static const int AMBIENT_RANGE = 2;         // doorways; matches the audio prefetch
+    static const int MAX_LOOPS = 4;
+    static const int MAX_ONE_SHOTS = 6;
+    static const int MAX_EVENTS_PER_UPDATE = 4;
+
+    Soundscape();
+
+    // Rebuild emitters around the listener. Call after the propagation paths
+    // change, i.e. when the listener changes room.
+    void setListenerRoom(const WorldManager& world, const SoundPropagation& propagation, AudioEngine& audio);
+    void update(float deltaTime, const SoundPropagation& propagation, AudioEngine& audio);
+    void clear(AudioEngine& audio);
+
+    int getEmitterCount() const { return static_cast<int>(emitters.size()); }
+    int getLoopCount() const { return static_cast<int>(loops.size()); }
+};
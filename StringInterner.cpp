@@ -0,0 +1,35 @@
+#include "StringInterner.h"
+#include <iostream>
+
+uint32_t StringInterner::intern(const std::string& text) {
+    uint32_t hash = hashString(text);
+    auto it = idsByHash.find(hash);
+    if (it != idsByHash.end()) {
+        if (strings[it->second] != text) {
+            std::cerr << "String hash collision between '" << strings[it->second] << "' and '" << text
+                      << "'" << std::endl;
+            return INVALID_ID;
+        }
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(text);
+    idsByHash[hash] = id;
+    return id;
+}
+
+uint32_t StringInterner::find(const std::string& text) const {
+    uint32_t id = findHash(hashString(text));
+    return (id != INVALID_ID && strings[id] == text) ? id : INVALID_ID;
+}
+
+uint32_t StringInterner::findHash(uint32_t hash) const {
+    auto it = idsByHash.find(hash);
+    return it != idsByHash.end() ? it->second : INVALID_ID;
+}
+
+void StringInterner::clear() {
+    idsByHash.clear();
+    strings.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 32-bit FNV-1a. constexpr, so hashString("footstep") costs nothing at run time.
+constexpr uint32_t hashString(const char* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr uint32_t hashString(const char* text) {
+    size_t length = 0;
+    while (text[length] != '\0') ++length;
+    return hashString(text, length);
+}
+
+inline uint32_t hashString(const std::string& text) {
+    return hashString(text.data(), text.size());
+}
+
+// Maps strings to dense ids 0, 1, 2... in first-seen order, so ids can index
+// flat arrays directly. Ids stay valid for the interner's lifetime.
+class StringInterner {
+private:
+    std::unordered_map<uint32_t, uint32_t> idsByHash;
+    std::vector<std::string> strings;
+
+public:
+    static const uint32_t INVALID_ID = 0xFFFFFFFFu;
+
+    // Returns the existing id or assigns the next one. Two names with the same
+    // hash are reported and the second is refused.
+    uint32_t intern(const std::string& text);
+
+    // Lookups that never allocate or add entries
+    uint32_t find(const std::string& text) const;
+    uint32_t findHash(uint32_t hash) const;
+
+    const std::string& getString(uint32_t id) const { return strings[id]; }
+    uint32_t size() const { return static_cast<uint32_t>(strings.size()); }
+    void clear();
+};
@@ -0,0 +1,183 @@
+#include "VoicePool.h"
+#include <iostream>
+
+namespace {
+
+// Retire one-shots a little after their nominal end so the driver has
+// certainly finished with the source before it is reused
+const double RETIRE_SLACK = 0.05;
+
+} // namespace
+
+VoicePool::VoicePool() : epoch(Clock::now()), manualClock(false), manualTime(0.0), stats() {}
+
+VoicePool::~VoicePool() {
+    release();
+}
+
+double VoicePool::now() const {
+    if (manualClock) return manualTime;
+    return std::chrono::duration<double>(Clock::now() - epoch).count();
+}
+
+void VoicePool::setManualClock(bool manual) {
+    // Carry on from the current time so nothing jumps
+    manualTime = now();
+    manualClock = manual;
+}
+
+int VoicePool::initialize(int count, bool createSources) {
+    release();
+
+    for (int i = 0; i < count; i++) {
+        if (!createSources) {
+            voices.push_back({0, false, false, VoicePriority::AMBIENT, 0.0f, NO_OWNER, 0.0, 0.0});
+            continue;
+        }
+
+#ifdef ECHOES_HAVE_OPENAL
+        ALuint source;
+        alGenSources(1, &source);
+        if (alGetError() != AL_NO_ERROR) {
+            std::cerr << "Failed to create audio source " << i << " of " << count << std::endl;
+            break;
+        }
+
+        // Set default source properties
+        alSourcef(source, AL_PITCH, 1.0f);
+        alSourcef(source, AL_GAIN, 1.0f);
+        alSource3f(source, AL_POSITION, 0.0f, 0.0f, 0.0f);
+        alSource3f(source, AL_VELOCITY, 0.0f, 0.0f, 0.0f);
+        alSourcei(source, AL_LOOPING, AL_FALSE);
+
+        voices.push_back({source, false, false, VoicePriority::AMBIENT, 0.0f, NO_OWNER, 0.0, 0.0});
+#endif
+    }
+
+    // Pop from the back, so voice 0 is handed out first
+    for (int i = static_cast<int>(voices.size()) - 1; i >= 0; i--) {
+        freeList.push_back(i);
+    }
+
+    stats = VoiceStats();
+    stats.total = static_cast<int>(voices.size());
+    return stats.total;
+}
+
+void VoicePool::release() {
+#ifdef ECHOES_HAVE_OPENAL
+    for (Voice& voice : voices) {
+        if (voice.source == 0) continue;
+        alSourceStop(voice.source);
+        alDeleteSources(1, &voice.source);
+    }
+#endif
+    voices.clear();
+    freeList.clear();
+    stats.total = 0;
+    stats.active = 0;
+}
+
+void VoicePool::retire(int index) {
+    voices[index].active = false;
+    freeList.push_back(index);
+    stats.active--;
+}
+
+int VoicePool::findVictim(VoicePriority priority, float audibility, double time) const {
+    // Lowest priority first, then whatever is least audible right now. A
+    // one-shot near its end counts as quieter, so older sounds go first.
+    // Equal priority only gives way to a louder newcomer.
+    int victim = -1;
+    VoicePriority victimPriority = priority;
+    float victimScore = 0.0f;
+
+    for (int i = 0; i < static_cast<int>(voices.size()); i++) {
+        const Voice& voice = voices[i];
+        if (!voice.active || voice.priority > priority) continue;
+
+        float remaining = 1.0f;
+        if (!voice.looping && voice.endTime > voice.startTime) {
+            remaining = static_cast<float>((voice.endTime - time) / (voice.endTime - voice.startTime));
+        }
+        float score = voice.audibility * remaining;
+        if (voice.priority == priority && score >= audibility) continue;
+
+        if (victim < 0 || voice.priority < victimPriority ||
+            (voice.priority == victimPriority && score < victimScore)) {
+            victim = i;
+            victimPriority = voice.priority;
+            victimScore = score;
+        }
+    }
+    return victim;
+}
+
+int VoicePool::acquire(VoicePriority priority, float audibility, float duration, bool looping,
+                       uint32_t owner, uint32_t* evictedOwner) {
+    double time = now();
+    int index;
+
+    if (evictedOwner) *evictedOwner = NO_OWNER;
+
+    if (!freeList.empty()) {
+        index = freeList.back();
+        freeList.pop_back();
+        stats.active++;
+    } else {
+        index = findVictim(priority, audibility, time);
+        if (index < 0) {
+            stats.dropped++;
+            return -1;
+        }
+#ifdef ECHOES_HAVE_OPENAL
+        if (voices[index].source != 0) alSourceStop(voices[index].source);
+#endif
+        if (evictedOwner) *evictedOwner = voices[index].owner;
+        stats.stolen++;
+    }
+
+    Voice& voice = voices[index];
+    voice.active = true;
+    voice.looping = looping;
+    voice.priority = priority;
+    voice.audibility = audibility;
+    voice.owner = owner;
+    voice.startTime = time;
+    voice.endTime = time + duration + RETIRE_SLACK;
+
+    stats.started++;
+    if (stats.active > stats.peakActive) stats.peakActive = stats.active;
+    return index;
+}
+
+bool VoicePool::wouldAccept(VoicePriority priority, float audibility) const {
+    return !freeList.empty() || findVictim(priority, audibility, now()) >= 0;
+}
+
+void VoicePool::stop(int voice) {
+    if (voice < 0 || voice >= static_cast<int>(voices.size()) || !voices[voice].active) return;
+#ifdef ECHOES_HAVE_OPENAL
+    if (voices[voice].source != 0) {
+        alSourceStop(voices[voice].source);
+        alSourcei(voices[voice].source, AL_BUFFER, 0);   // so the buffer can be deleted
+    }
+#endif
+    retire(voice);
+}
+
+void VoicePool::stopAll() {
+    for (int i = 0; i < static_cast<int>(voices.size()); i++) {
+        stop(i);
+    }
+}
+
+void VoicePool::update() {
+    double time = now();
+    for (int i = 0; i < static_cast<int>(voices.size()); i++) {
+        const Voice& voice = voices[i];
+        if (voice.active && !voice.looping && time >= voice.endTime) {
+            retire(i);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "AudioConfig.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// How important a sound is when voices run out. A new sound may take over a
+// voice playing at a lower priority, or at the same priority if the new
+// sound is more audible, never at a higher one.
+enum class VoicePriority : uint8_t {
+    AMBIENT,
+    LOW,
+    NORMAL,
+    HIGH,
+    CRITICAL
+};
+
+struct VoiceStats {
+    int total;
+    int active;
+    int peakActive;
+    int started;
+    int stolen;
+    int dropped;            // requests refused because every voice outranked them
+
+    float getUtilisation() const { return total > 0 ? static_cast<float>(active) / total : 0.0f; }
+};
+
+// Fixed set of OpenAL sources with their state mirrored on the CPU. Finished
+// voices are retired from their known length instead of polling
+// AL_SOURCE_STATE, and a free list makes finding a voice O(1).
+class VoicePool {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Voice {
+        ALuint source;
+        bool active;
+        bool looping;
+        VoicePriority priority;
+        float audibility;           // gain after distance attenuation
+        uint32_t owner;             // caller's tag for whoever holds the voice
+        double startTime;
+        double endTime;             // when a one-shot finishes, in pool seconds
+    };
+
+    std::vector<Voice> voices;
+    std::vector<int> freeList;
+    Clock::time_point epoch;
+    bool manualClock;
+    double manualTime;
+    VoiceStats stats;
+
+    void retire(int index);
+    int findVictim(VoicePriority priority, float audibility, double time) const;
+
+public:
+    VoicePool();
+    ~VoicePool();
+
+    VoicePool(const VoicePool&) = delete;
+    VoicePool& operator=(const VoicePool&) = delete;
+
+    // Creates up to count sources; returns how many were created. Without
+    // sources the pool only does the bookkeeping, for running with no output.
+    int initialize(int count, bool createSources = true);
+    void release();
+
+    static const uint32_t NO_OWNER = 0;
+
+    // Reserve a voice for a sound lasting duration seconds (ignored when
+    // looping). Steals the least audible voice of equal or lower priority
+    // when none is free, reporting the stolen voice's owner through
+    // evictedOwner. Returns the voice index, or -1 if the request lost.
+    int acquire(VoicePriority priority, float audibility, float duration, bool looping,
+                uint32_t owner = NO_OWNER, uint32_t* evictedOwner = nullptr);
+    ALuint getSource(int voice) const { return voices[voice].source; }
+
+    // Whether acquire() would succeed right now, without touching the stats
+    bool wouldAccept(VoicePriority priority, float audibility) const;
+    
+    // Refresh a voice's audibility as it or the listener moves
+    void setAudibility(int voice, float audibility) { voices[voice].audibility = audibility; }
+
+    // Seconds since the pool was created; the clock voice lifetimes run on
+    double now() const;
+    
+    // Offline rendering runs faster than real time, so time only moves when
+    // the renderer says how much audio it has produced
+    void setManualClock(bool manual);
+    void advanceClock(double seconds) { manualTime += seconds; }
+
+    // Stop a voice early and return it to the free list
+    void stop(int voice);
+    void stopAll();
+
+    // Return one-shots that have run their course to the free list
+    void update();
+
+    const VoiceStats& getStats() const { return stats; }
+};
@@ -0,0 +1,131 @@
+#include "WavFile.h"
+#include <cstring>
+
+namespace {
+
+const uint16_t FORMAT_PCM = 0x0001;
+const uint16_t FORMAT_IEEE_FLOAT = 0x0003;
+const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+// RIFF is little-endian; read byte by byte so unaligned fields are safe
+uint16_t readU16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readU32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool parseFormat(const unsigned char* chunk, uint32_t chunkSize, WavInfo& info, std::string& error) {
+    if (chunkSize < 16) {
+        error = "fmt chunk too small";
+        return false;
+    }
+
+    uint16_t formatTag = readU16(chunk);
+    info.channels = readU16(chunk + 2);
+    info.sampleRate = readU32(chunk + 4);
+    info.blockAlign = readU16(chunk + 12);
+    uint16_t bitsPerSample = readU16(chunk + 14);
+
+    if (formatTag == FORMAT_EXTENSIBLE) {
+        // cbSize(2) validBits(2) channelMask(4) then the SubFormat GUID,
+        // whose first two bytes are the real format tag
+        if (chunkSize < 40) {
+            error = "extensible fmt chunk too small";
+            return false;
+        }
+        formatTag = readU16(chunk + 24);
+    }
+
+    if (formatTag == FORMAT_PCM) {
+        switch (bitsPerSample) {
+            case 8:  info.encoding = WavEncoding::PCM_U8; break;
+            case 16: info.encoding = WavEncoding::PCM_S16; break;
+            case 24: info.encoding = WavEncoding::PCM_S24; break;
+            default:
+                error = "unsupported PCM bit depth " + std::to_string(bitsPerSample);
+                return false;
+        }
+    } else if (formatTag == FORMAT_IEEE_FLOAT && bitsPerSample == 32) {
+        info.encoding = WavEncoding::FLOAT32;
+    } else {
+        error = "unsupported format tag " + std::to_string(formatTag);
+        return false;
+    }
+
+    if (info.channels != 1 && info.channels != 2) {
+        error = "only mono and stereo are supported";
+        return false;
+    }
+    if (info.blockAlign != info.channels * (bitsPerSample / 8)) {
+        error = "inconsistent block alignment";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseWav(const unsigned char* data, size_t size, WavInfo& info, std::string& error) {
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    bool haveFormat = false;
+    bool haveData = false;
+    size_t offset = 12;
+
+    while (offset + 8 <= size) {
+        const unsigned char* header = data + offset;
+        uint32_t chunkSize = readU32(header + 4);
+        const unsigned char* body = header + 8;
+        size_t available = size - offset - 8;
+
+        if (std::memcmp(header, "fmt ", 4) == 0) {
+            if (chunkSize > available) {
+                error = "truncated fmt chunk";
+                return false;
+            }
+            if (!parseFormat(body, chunkSize, info, error)) return false;
+            haveFormat = true;
+        } else if (std::memcmp(header, "data", 4) == 0) {
+            // Writers that stream often leave the size unpatched; trust the file
+            size_t bytes = chunkSize < available ? chunkSize : available;
+            info.samples = body;
+            info.sampleBytes = bytes;
+            haveData = true;
+        }
+
+        if (haveFormat && haveData) break;
+
+        // Chunks are padded to an even size
+        size_t advance = 8 + static_cast<size_t>(chunkSize) + (chunkSize & 1);
+        if (advance > size - offset) break;
+        offset += advance;
+    }
+
+    if (!haveFormat || !haveData) {
+        error = haveFormat ? "no data chunk" : "no fmt chunk";
+        return false;
+    }
+
+    // Whole sample frames only
+    info.sampleBytes -= info.sampleBytes % info.blockAlign;
+    return true;
+}
+
+float sampleFromS24(const unsigned char* sample) {
+    int32_t value = static_cast<int32_t>((static_cast<uint32_t>(sample[0]) << 8) |
+                                         (static_cast<uint32_t>(sample[1]) << 16) |
+                                         (static_cast<uint32_t>(sample[2]) << 24));
+    return static_cast<float>(value) / 2147483648.0f;
+}
+
+int16_t floatToS16(float value) {
+    if (value > 1.0f) value = 1.0f;
+    if (value < -1.0f) value = -1.0f;
+    return static_cast<int16_t>(value * 32767.0f);
+}
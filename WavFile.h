@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Sample encodings a WAV file can carry that the audio engine understands
+enum class WavEncoding {
+    PCM_U8,
+    PCM_S16,
+    PCM_S24,
+    FLOAT32
+};
+
+// Description of a parsed RIFF/WAVE file. `samples` points into the caller's
+// buffer (usually a MappedFile); nothing is copied.
+struct WavInfo {
+    WavEncoding encoding;
+    uint16_t channels;
+    uint32_t sampleRate;
+    uint16_t blockAlign;
+    const unsigned char* samples;
+    size_t sampleBytes;
+};
+
+// Walks the RIFF chunks in [data, data + size), so fmt and data may appear in
+// any order with LIST, fact and other chunks around them. Handles plain and
+// WAVE_FORMAT_EXTENSIBLE headers. On failure returns false and sets error.
+bool parseWav(const unsigned char* data, size_t size, WavInfo& info, std::string& error);
+
+// Conversions for the encodings OpenAL cannot take as they are
+float sampleFromS24(const unsigned char* sample);   // packed little-endian 24-bit to [-1, 1)
+int16_t floatToS16(float value);                    // clamps to [-1, 1] first
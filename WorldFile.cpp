@@ -0,0 +1,561 @@
+#include "WorldFile.h"
+#include "Enemy.h"
+#include "Item.h"
+#include "Room.h"
+#include "RoomGraph.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// "a | b | c" into trimmed fields
+std::vector<std::string> splitFields(const std::string& value) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t bar = value.find('|', start);
+        fields.push_back(trim(value.substr(start, bar == std::string::npos ? std::string::npos : bar - start)));
+        if (bar == std::string::npos) break;
+        start = bar + 1;
+    }
+    return fields;
+}
+
+bool parseColor(const std::string& value, float color[3]) {
+    std::istringstream stream(value);
+    return static_cast<bool>(stream >> color[0] >> color[1] >> color[2]);
+}
+
+bool parseHazard(const std::string& value, uint32_t& hazard) {
+    Room::HazardType type;
+    if (value == "none") type = Room::HazardType::NONE;
+    else if (value == "poison") type = Room::HazardType::POISON;
+    else if (value == "cursed") type = Room::HazardType::CURSED;
+    else if (value == "cold") type = Room::HazardType::COLD;
+    else if (value == "hot") type = Room::HazardType::HOT;
+    else return false;
+    hazard = static_cast<uint32_t>(type);
+    return true;
+}
+
+bool parseItemType(const std::string& value, uint32_t& type) {
+    Item::Type itemType;
+    if (value == "weapon") itemType = Item::Type::WEAPON;
+    else if (value == "potion") itemType = Item::Type::POTION;
+    else if (value == "key") itemType = Item::Type::KEY;
+    else if (value == "treasure") itemType = Item::Type::TREASURE;
+    else if (value == "quest") itemType = Item::Type::QUEST_ITEM;
+    else return false;
+    type = static_cast<uint32_t>(itemType);
+    return true;
+}
+
+bool parseEnemyType(const std::string& value, uint32_t& type) {
+    Enemy::Type enemyType;
+    if (value == "goblin") enemyType = Enemy::Type::GOBLIN;
+    else if (value == "wolf") enemyType = Enemy::Type::WOLF;
+    else if (value == "skeleton") enemyType = Enemy::Type::SKELETON;
+    else if (value == "ghost") enemyType = Enemy::Type::GHOST;
+    else if (value == "boss") enemyType = Enemy::Type::BOSS;
+    else return false;
+    type = static_cast<uint32_t>(enemyType);
+    return true;
+}
+
+// Everything parsed so far, in the shape it is written out. Names that other
+// records refer to are resolved to indices once the whole file is read.
+class WorldBuilder {
+private:
+    std::string strings;
+    std::unordered_map<std::string, WorldString> stringIndex;
+
+public:
+    std::vector<WorldBiome> biomes;
+    std::vector<WorldAmbient> ambients;
+    std::vector<WorldRoom> rooms;
+    std::vector<RoomExit> exits;
+    std::vector<uint32_t> exitRows;                 // per room, where its exits start
+    std::vector<WorldItem> items;
+    std::vector<WorldEnemy> enemies;
+
+    std::unordered_map<std::string, uint32_t> biomeByKey;
+    std::unordered_map<std::string, uint32_t> roomById;
+    std::vector<std::string> roomBiomes;            // per room, resolved at the end
+    std::vector<std::string> exitTargets;           // per exit, resolved at the end
+    std::vector<int> exitLines;
+    std::string startRoom;
+
+    // Equal strings are stored once
+    WorldString addString(const std::string& text) {
+        auto it = stringIndex.find(text);
+        if (it != stringIndex.end()) return it->second;
+
+        WorldString string = {static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+        strings += text;
+        stringIndex[text] = string;
+        return string;
+    }
+
+    const std::string& getStrings() const { return strings; }
+};
+
+bool parseBiomeProperty(WorldBuilder& world, WorldBiome& biome, const std::string& key, const std::string& value) {
+    std::istringstream stream(value);
+
+    if (key == "name") {
+        biome.name = world.addString(value);
+        return true;
+    }
+    if (key == "music") {
+        biome.music = world.addString(value);
+        return true;
+    }
+    if (key == "sky") return parseColor(value, biome.skyColor);
+    if (key == "ambient_light") return parseColor(value, biome.ambientLight);
+    if (key == "fog_color") return parseColor(value, biome.fogColor);
+    if (key == "fog_density") return static_cast<bool>(stream >> biome.fogDensity);
+
+    if (key == "ambient_loop" || key == "ambient_sound") {
+        WorldAmbient ambient = {};
+        std::string file;
+        ambient.loop = key == "ambient_loop" ? 1 : 0;
+        ambient.minPitch = ambient.maxPitch = 1.0f;
+        if (!(stream >> file >> ambient.volume)) return false;
+        if (!ambient.loop) {
+            if (!(stream >> ambient.minInterval >> ambient.maxInterval)) return false;
+            if (!(stream >> ambient.minPitch)) ambient.minPitch = 1.0f;
+            if (!(stream >> ambient.maxPitch)) ambient.maxPitch = ambient.minPitch;
+        }
+        ambient.file = world.addString(file);
+        world.ambients.push_back(ambient);
+        biome.ambientCount++;
+        return true;
+    }
+    return false;
+}
+
+bool parseRoomProperty(WorldBuilder& world, WorldRoom& room, std::string& description, const std::string& key,
+                       const std::string& value, int lineNumber) {
+    std::istringstream stream(value);
+
+    if (key == "name") {
+        room.name = world.addString(value);
+        return true;
+    }
+    if (key == "description") {
+        // Long descriptions may continue over several lines
+        if (!description.empty()) description += ' ';
+        description += value;
+        return true;
+    }
+    if (key == "event") {
+        room.event = world.addString(value);
+        return true;
+    }
+    if (key == "biome") {
+        world.roomBiomes.back() = value;
+        return true;
+    }
+    if (key == "hazard") return parseHazard(value, room.hazard);
+
+    if (key == "exit") {
+        std::string name, target;
+        Direction direction;
+        if (!(stream >> name >> target) || !parseDirection(name, direction)) return false;
+        for (uint32_t i = world.exitRows.back(); i < world.exits.size(); i++) {
+            if (world.exits[i].direction == direction) return false;     // one exit per direction
+        }
+        world.exits.push_back(RoomExit{direction, 0});
+        world.exitTargets.push_back(target);
+        world.exitLines.push_back(lineNumber);
+        return true;
+    }
+    if (key == "item") {
+        // type value [effect] | name | description
+        std::vector<std::string> fields = splitFields(value);
+        if (fields.size() != 3) return false;
+
+        WorldItem item = {};
+        std::string type;
+        std::istringstream numbers(fields[0]);
+        if (!(numbers >> type >> item.value) || !parseItemType(type, item.type)) return false;
+        if (!(numbers >> item.effect)) item.effect = 0;
+        item.name = world.addString(fields[1]);
+        item.description = world.addString(fields[2]);
+        world.items.push_back(item);
+        room.itemCount++;
+        return true;
+    }
+    if (key == "enemy") {
+        // type health attack defense gold | name
+        std::vector<std::string> fields = splitFields(value);
+        if (fields.size() != 2) return false;
+
+        WorldEnemy enemy = {};
+        std::string type;
+        std::istringstream numbers(fields[0]);
+        if (!(numbers >> type >> enemy.health >> enemy.attack >> enemy.defense >> enemy.goldReward)) return false;
+        if (!parseEnemyType(type, enemy.type)) return false;
+        enemy.name = world.addString(fields[1]);
+        world.enemies.push_back(enemy);
+        room.enemyCount++;
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+void writeTable(FILE* out, const std::vector<T>& records) {
+    if (!records.empty()) fwrite(records.data(), sizeof(T), records.size(), out);
+}
+
+} // namespace
+
+WorldFile::WorldFile() : header(nullptr) {}
+
+bool WorldFile::compile(const std::string& sourceFile, const std::string& binaryFile) {
+    std::ifstream source(sourceFile);
+    if (!source.is_open()) {
+        std::cerr << "Failed to open world file: " << sourceFile << std::endl;
+        return false;
+    }
+
+    enum class Section { NONE, WORLD, BIOME, ROOM };
+    Section section = Section::NONE;
+    WorldBuilder world;
+    std::string description;
+    bool valid = true;
+
+    auto report = [&](int lineNumber, const std::string& message) {
+        std::cerr << sourceFile << ":" << lineNumber << ": " << message << std::endl;
+        valid = false;
+    };
+    auto finishRoom = [&]() {
+        if (section == Section::ROOM) world.rooms.back().description = world.addString(description);
+        description.clear();
+    };
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(source, line)) {
+        ++lineNumber;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        if (line.front() == '[' && line.back() == ']') {
+            finishRoom();
+            std::istringstream header(line.substr(1, line.size() - 2));
+            std::string kind, name;
+            header >> kind >> name;
+
+            if (kind == "world") {
+                section = Section::WORLD;
+            } else if (kind == "biome" && !name.empty() && !world.biomeByKey.count(name)) {
+                world.biomeByKey[name] = static_cast<uint32_t>(world.biomes.size());
+                WorldBiome biome = {};
+                biome.key = biome.name = world.addString(name);
+                biome.firstAmbient = static_cast<uint32_t>(world.ambients.size());
+                world.biomes.push_back(biome);
+                section = Section::BIOME;
+            } else if (kind == "room" && !name.empty() && !world.roomById.count(name)) {
+                world.roomById[name] = static_cast<uint32_t>(world.rooms.size());
+                WorldRoom room = {};
+                room.id = room.name = world.addString(name);
+                room.biome = NO_BIOME;
+                room.firstItem = static_cast<uint32_t>(world.items.size());
+                room.firstEnemy = static_cast<uint32_t>(world.enemies.size());
+                world.rooms.push_back(room);
+                world.exitRows.push_back(static_cast<uint32_t>(world.exits.size()));
+                world.roomBiomes.push_back("");
+                section = Section::ROOM;
+            } else {
+                report(lineNumber, "expected [world], [biome key] or [room id], each key once");
+                section = Section::NONE;
+            }
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (section == Section::NONE || equals == std::string::npos) {
+            report(lineNumber, "expected a section or key = value");
+            continue;
+        }
+
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        bool parsed = false;
+        switch (section) {
+        case Section::WORLD:
+            parsed = key == "start";
+            if (parsed) world.startRoom = value;
+            break;
+        case Section::BIOME:
+            parsed = parseBiomeProperty(world, world.biomes.back(), key, value);
+            break;
+        case Section::ROOM:
+            parsed = parseRoomProperty(world, world.rooms.back(), description, key, value, lineNumber);
+            break;
+        case Section::NONE:
+            break;
+        }
+        if (!parsed) report(lineNumber, "invalid '" + key + "'");
+    }
+    finishRoom();
+
+    // Resolve names now that every room and biome is known
+    for (size_t i = 0; i < world.exits.size(); i++) {
+        auto it = world.roomById.find(world.exitTargets[i]);
+        if (it == world.roomById.end()) {
+            report(world.exitLines[i], "exit to unknown room '" + world.exitTargets[i] + "'");
+            continue;
+        }
+        world.exits[i].room = it->second;
+    }
+    for (size_t i = 0; i < world.rooms.size(); i++) {
+        if (world.roomBiomes[i].empty()) continue;
+        auto it = world.biomeByKey.find(world.roomBiomes[i]);
+        if (it == world.biomeByKey.end()) {
+            std::cerr << sourceFile << ": room uses unknown biome '" << world.roomBiomes[i] << "'" << std::endl;
+            valid = false;
+            continue;
+        }
+        world.rooms[i].biome = it->second;
+    }
+    auto start = world.roomById.find(world.startRoom);
+    if (start == world.roomById.end()) {
+        std::cerr << sourceFile << ": [world] start must name a room" << std::endl;
+        valid = false;
+    }
+    if (!valid) return false;
+    world.exitRows.push_back(static_cast<uint32_t>(world.exits.size()));
+
+    std::vector<std::pair<std::string, uint32_t>> byId(world.roomById.begin(), world.roomById.end());
+    std::sort(byId.begin(), byId.end());
+    std::vector<uint32_t> roomIndex;
+    roomIndex.reserve(byId.size());
+    for (const auto& room : byId) {
+        roomIndex.push_back(room.second);
+    }
+
+    // Tables back to back after the header; every record is a multiple of
+    // four bytes, so they all stay aligned
+    WorldHeader header = {};
+    std::memcpy(header.magic, "EWLD", 4);
+    header.version = VERSION;
+    header.startRoom = start->second;
+
+    uint32_t offset = sizeof(WorldHeader);
+    auto place = [&offset](uint32_t count, size_t recordSize, uint32_t& countField, uint32_t& offsetField) {
+        countField = count;
+        offsetField = offset;
+        offset += static_cast<uint32_t>(count * recordSize);
+    };
+    place(static_cast<uint32_t>(world.biomes.size()), sizeof(WorldBiome), header.biomeCount, header.biomeOffset);
+    place(static_cast<uint32_t>(world.ambients.size()), sizeof(WorldAmbient), header.ambientCount,
+          header.ambientOffset);
+    place(static_cast<uint32_t>(world.rooms.size()), sizeof(WorldRoom), header.roomCount, header.roomOffset);
+    uint32_t rowCount, indexCount;
+    place(static_cast<uint32_t>(world.exitRows.size()), sizeof(uint32_t), rowCount, header.exitRowOffset);
+    place(static_cast<uint32_t>(roomIndex.size()), sizeof(uint32_t), indexCount, header.roomIndexOffset);
+    place(static_cast<uint32_t>(world.exits.size()), sizeof(RoomExit), header.exitCount, header.exitOffset);
+    place(static_cast<uint32_t>(world.items.size()), sizeof(WorldItem), header.itemCount, header.itemOffset);
+    place(static_cast<uint32_t>(world.enemies.size()), sizeof(WorldEnemy), header.enemyCount, header.enemyOffset);
+    header.stringBytes = static_cast<uint32_t>(world.getStrings().size());
+    header.stringOffset = offset;
+    header.fileSize = offset + header.stringBytes;
+
+    FILE* out = fopen(binaryFile.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Failed to create compiled world: " << binaryFile << std::endl;
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    writeTable(out, world.biomes);
+    writeTable(out, world.ambients);
+    writeTable(out, world.rooms);
+    writeTable(out, world.exitRows);
+    writeTable(out, roomIndex);
+    writeTable(out, world.exits);
+    writeTable(out, world.items);
+    writeTable(out, world.enemies);
+    fwrite(world.getStrings().data(), 1, world.getStrings().size(), out);
+    bool written = ferror(out) == 0;
+    written = fclose(out) == 0 && written;
+
+    if (!written) {
+        std::cerr << "Failed to write compiled world: " << binaryFile << std::endl;
+        std::remove(binaryFile.c_str());
+        return false;
+    }
+    std::cout << "Compiled " << sourceFile << ": " << world.rooms.size() << " rooms, " << world.exits.size()
+              << " exits" << std::endl;
+    return true;
+}
+
+bool WorldFile::open(const std::string& binaryFile) {
+    close();
+    if (!file.open(binaryFile, MappedAccess::RANDOM)) return false;
+
+    if (!validate(binaryFile)) {
+        file.close();
+        return false;
+    }
+    header = reinterpret_cast<const WorldHeader*>(file.data());
+    return true;
+}
+
+bool WorldFile::validate(const std::string& filename) {
+    auto fail = [&filename](const char* reason) {
+        std::cerr << "Invalid compiled world (" << reason << "): " << filename << std::endl;
+        return false;
+    };
+
+    size_t size = file.size();
+    if (size < sizeof(WorldHeader)) return fail("truncated");
+    const WorldHeader& h = *reinterpret_cast<const WorldHeader*>(file.data());
+    if (std::memcmp(h.magic, "EWLD", 4) != 0) return fail("not a world file");
+    if (h.version != VERSION) return fail("old version");
+    if (h.fileSize != size) return fail("size mismatch");
+
+    auto tableFits = [size](uint32_t count, uint32_t offset, size_t recordSize) {
+        return offset % 4 == 0 && offset <= size && count <= (size - offset) / recordSize;
+    };
+    if (!tableFits(h.biomeCount, h.biomeOffset, sizeof(WorldBiome)) ||
+        !tableFits(h.ambientCount, h.ambientOffset, sizeof(WorldAmbient)) ||
+        !tableFits(h.roomCount, h.roomOffset, sizeof(WorldRoom)) ||
+        !tableFits(h.roomCount + 1, h.exitRowOffset, sizeof(uint32_t)) ||
+        !tableFits(h.roomCount, h.roomIndexOffset, sizeof(uint32_t)) ||
+        !tableFits(h.exitCount, h.exitOffset, sizeof(RoomExit)) ||
+        !tableFits(h.itemCount, h.itemOffset, sizeof(WorldItem)) ||
+        !tableFits(h.enemyCount, h.enemyOffset, sizeof(WorldEnemy)) ||
+        !tableFits(h.stringBytes, h.stringOffset, 1)) {
+        return fail("table out of bounds");
+    }
+    if (h.startRoom >= h.roomCount) return fail("bad start room");
+
+    // After this every reference is known to be in range
+    auto stringFits = [&h](const WorldString& s) {
+        return s.offset <= h.stringBytes && s.length <= h.stringBytes - s.offset;
+    };
+    auto runFits = [](uint32_t first, uint32_t count, uint32_t total) {
+        return first <= total && count <= total - first;
+    };
+
+    const unsigned char* base = file.data();
+    const WorldBiome* biomes = reinterpret_cast<const WorldBiome*>(base + h.biomeOffset);
+    for (uint32_t i = 0; i < h.biomeCount; i++) {
+        const WorldBiome& b = biomes[i];
+        if (!stringFits(b.key) || !stringFits(b.name) || !stringFits(b.music) ||
+            !runFits(b.firstAmbient, b.ambientCount, h.ambientCount)) {
+            return fail("bad biome");
+        }
+    }
+    const WorldAmbient* ambients = reinterpret_cast<const WorldAmbient*>(base + h.ambientOffset);
+    for (uint32_t i = 0; i < h.ambientCount; i++) {
+        if (!stringFits(ambients[i].file)) return fail("bad ambient sound");
+    }
+    const WorldRoom* rooms = reinterpret_cast<const WorldRoom*>(base + h.roomOffset);
+    for (uint32_t i = 0; i < h.roomCount; i++) {
+        const WorldRoom& r = rooms[i];
+        if (!stringFits(r.id) || !stringFits(r.name) || !stringFits(r.description) || !stringFits(r.event) ||
+            (r.biome != NO_BIOME && r.biome >= h.biomeCount) ||
+            r.hazard > static_cast<uint32_t>(Room::HazardType::HOT) ||
+            !runFits(r.firstItem, r.itemCount, h.itemCount) || !runFits(r.firstEnemy, r.enemyCount, h.enemyCount)) {
+            return fail("bad room");
+        }
+    }
+    const uint32_t* rows = reinterpret_cast<const uint32_t*>(base + h.exitRowOffset);
+    if (rows[0] != 0 || rows[h.roomCount] != h.exitCount) return fail("bad exit rows");
+    for (uint32_t i = 0; i < h.roomCount; i++) {
+        if (rows[i] > rows[i + 1]) return fail("bad exit rows");
+    }
+    const RoomExit* exits = reinterpret_cast<const RoomExit*>(base + h.exitOffset);
+    for (uint32_t i = 0; i < h.exitCount; i++) {
+        if (static_cast<uint32_t>(exits[i].direction) >= DIRECTION_COUNT || exits[i].room >= h.roomCount) {
+            return fail("bad exit");
+        }
+    }
+    // Strictly increasing ids make findRoom's binary search exact
+    const uint32_t* index = reinterpret_cast<const uint32_t*>(base + h.roomIndexOffset);
+    const char* strings = reinterpret_cast<const char*>(base + h.stringOffset);
+    auto roomId = [&](uint32_t room) {
+        return std::string_view(strings + rooms[room].id.offset, rooms[room].id.length);
+    };
+    for (uint32_t i = 0; i < h.roomCount; i++) {
+        if (index[i] >= h.roomCount || (i > 0 && !(roomId(index[i - 1]) < roomId(index[i])))) {
+            return fail("bad room index");
+        }
+    }
+    const WorldItem* items = reinterpret_cast<const WorldItem*>(base + h.itemOffset);
+    for (uint32_t i = 0; i < h.itemCount; i++) {
+        if (!stringFits(items[i].name) || !stringFits(items[i].description) ||
+            items[i].type > static_cast<uint32_t>(Item::Type::QUEST_ITEM)) {
+            return fail("bad item");
+        }
+    }
+    const WorldEnemy* enemies = reinterpret_cast<const WorldEnemy*>(base + h.enemyOffset);
+    for (uint32_t i = 0; i < h.enemyCount; i++) {
+        if (!stringFits(enemies[i].name) || enemies[i].type > static_cast<uint32_t>(Enemy::Type::BOSS)) {
+            return fail("bad enemy");
+        }
+    }
+    return true;
+}
+
+void WorldFile::close() {
+    file.close();
+    header = nullptr;
+}
+
+const WorldBiome* WorldFile::getBiomes() const {
+    return reinterpret_cast<const WorldBiome*>(file.data() + header->biomeOffset);
+}
+
+const WorldAmbient* WorldFile::getAmbients() const {
+    return reinterpret_cast<const WorldAmbient*>(file.data() + header->ambientOffset);
+}
+
+const WorldRoom* WorldFile::getRooms() const {
+    return reinterpret_cast<const WorldRoom*>(file.data() + header->roomOffset);
+}
+
+const uint32_t* WorldFile::getExitRows() const {
+    return reinterpret_cast<const uint32_t*>(file.data() + header->exitRowOffset);
+}
+
+const RoomExit* WorldFile::getExits() const {
+    return reinterpret_cast<const RoomExit*>(file.data() + header->exitOffset);
+}
+
+const uint32_t* WorldFile::getRoomIndex() const {
+    return reinterpret_cast<const uint32_t*>(file.data() + header->roomIndexOffset);
+}
+
+const WorldItem* WorldFile::getItems() const {
+    return reinterpret_cast<const WorldItem*>(file.data() + header->itemOffset);
+}
+
+const WorldEnemy* WorldFile::getEnemies() const {
+    return reinterpret_cast<const WorldEnemy*>(file.data() + header->enemyOffset);
+}
+
+std::string_view WorldFile::getString(const WorldString& string) const {
+    const char* strings = reinterpret_cast<const char*>(file.data() + header->stringOffset);
+    return std::string_view(strings + string.offset, string.length);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "RoomGraph.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Compiled world: fixed-size little-endian records in flat tables, addressed
+// by index, with every string in one table at the end. It is memory-mapped
+// and read in place; open() checks every offset and index once, so nothing
+// needs checking afterwards. Rooms own contiguous runs of the item and enemy
+// tables. Exits are RoomExit records grouped by room, with a table of where
+// each room's row starts, so RoomGraph uses the pair as they are; rooms are
+// also listed in order of id for lookups by name.
+//
+// Source form (world.txt): "[world]", "[biome key]" and "[room id]" sections
+// of "key = value" lines, '#' comments. See world.txt for the keys.
+
+struct WorldString {
+    uint32_t offset;            // into the string table
+    uint32_t length;
+};
+
+struct WorldHeader {
+    char magic[4];              // "EWLD"
+    uint32_t version;
+    uint32_t fileSize;
+    uint32_t startRoom;
+    uint32_t biomeCount, biomeOffset;
+    uint32_t ambientCount, ambientOffset;
+    uint32_t roomCount, roomOffset;
+    uint32_t exitRowOffset;     // roomCount + 1 row starts into the exit table
+    uint32_t roomIndexOffset;   // roomCount room indices, sorted by id
+    uint32_t exitCount, exitOffset;
+    uint32_t itemCount, itemOffset;
+    uint32_t enemyCount, enemyOffset;
+    uint32_t stringBytes, stringOffset;
+};
+
+struct WorldBiome {
+    WorldString key;
+    WorldString name;
+    WorldString music;
+    float skyColor[3];
+    float ambientLight[3];
+    float fogColor[3];
+    float fogDensity;
+    uint32_t firstAmbient, ambientCount;
+};
+
+struct WorldAmbient {
+    WorldString file;
+    uint32_t loop;
+    float volume;
+    float minInterval, maxInterval;
+    float minPitch, maxPitch;
+};
+
+struct WorldRoom {
+    WorldString id;
+    WorldString name;
+    WorldString description;
+    WorldString event;
+    uint32_t biome;             // NO_BIOME for none
+    uint32_t hazard;            // Room::HazardType
+    uint32_t firstItem, itemCount;
+    uint32_t firstEnemy, enemyCount;
+};
+
+static_assert(sizeof(RoomExit) == 8, "RoomExit is the exit record");
+
+struct WorldItem {
+    WorldString name;
+    WorldString description;
+    uint32_t type;              // Item::Type
+    int32_t value;
+    int32_t effect;
+};
+
+struct WorldEnemy {
+    WorldString name;
+    uint32_t type;              // Enemy::Type
+    int32_t health, attack, defense, goldReward;
+};
+
+class WorldFile {
+private:
+    MappedFile file;
+    const WorldHeader* header;
+
+    bool validate(const std::string& filename);
+
+public:
+    static const uint32_t VERSION = 3;
+    static const uint32_t NO_BIOME = 0xFFFFFFFFu;
+
+    WorldFile();
+
+    // Parse a source file and write its compiled form. Reports problems with
+    // file:line on std::cerr and writes nothing if there were any.
+    static bool compile(const std::string& sourceFile, const std::string& binaryFile);
+
+    bool open(const std::string& binaryFile);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    const WorldHeader& getHeader() const { return *header; }
+    const WorldBiome* getBiomes() const;
+    const WorldAmbient* getAmbients() const;
+    const WorldRoom* getRooms() const;
+    const uint32_t* getExitRows() const;
+    const RoomExit* getExits() const;
+    const uint32_t* getRoomIndex() const;
+    const WorldItem* getItems() const;
+    const WorldEnemy* getEnemies() const;
+    std::string_view getString(const WorldString& string) const;
+};
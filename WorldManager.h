@@ -1,11 +1,27 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include "Room.h"
+#include "RoomGraph.h"
+#include "RoomGraphQuery.h"
+#include "WorldFile.h"
+
+// One layer of a biome's soundscape. Loops play continuously; one-shots
+// fire every minInterval to maxInterval seconds at a random spot in the room,
+// with a random pitch in minPitch to maxPitch.
+struct AmbientSound {
+    std::string file;
+    bool loop;
+    float volume;
+    float minInterval, maxInterval;
+    float minPitch, maxPitch;
+};
 
 struct BiomeData {
     std::string name;
@@ -14,41 +30,57 @@ struct BiomeData {
     glm::vec3 fogColor;
     float fogDensity;
     std::string musicTrack;
-    std::vector<std::string> ambientSounds;
+    std::vector<AmbientSound> ambientSounds;
 };
 
+// Owns every room. Rooms are stored by RoomId and their exits in one
+// RoomGraph, so moving between rooms is an exit lookup and an array index;
+// room keys are only resolved through findRoom().
+//
+// A loaded world is read in place from its WorldFile: the graph uses the
+// file's exit table, and a Room or BiomeData is only made the first time it
+// is asked for, for the state that changes in play. Rooms made in code are
+// made at once.
 class WorldManager {
 private:
-    std::map<std::string, std::shared_ptr<Room>> rooms;
-    std::map<std::string, BiomeData> biomes;
+    std::vector<std::unique_ptr<Room>> rooms;           // indexed by RoomId, made on first use
+    std::unordered_map<std::string, RoomId> roomIndex;  // key to id, for rooms made in code
+    RoomGraph graph;
+    RoomGraphQuery query;                               // over graph
+    mutable std::vector<std::unique_ptr<BiomeData>> biomes;    // per biome record, made on first use
+    WorldFile worldFile;
+    RoomId startRoom;
     
-    void createBiomes();
-    void createExpandedWorld();
-    void createVillageArea();
-    void createForestArea();
-    void createCaveArea();
-    void createCastleArea();
-    void createDesertArea();
-    void createMountainArea();
-    void createUnderwaterArea();
-    void createBridges();
+    static bool compileIfStale(const std::string& sourceFile, const std::string& binaryFile);
+    uint32_t getFileRoomCount() const { return worldFile.isOpen() ? worldFile.getHeader().roomCount : 0; }
     
 public:
     WorldManager();
     ~WorldManager() = default;
     
-    void initialize();
-    std::map<std::string, std::shared_ptr<Room>>& getRooms() { return rooms; }
-    BiomeData getBiome(const std::string& biomeName);
+    // Load the world from a source file, compiling it to a .bin next to it
+    // when that is missing or older. False if neither can be loaded.
+    bool initialize(const std::string& filename = "world.txt");
+    void clear();
     
-    // Room creation helpers
-    std::shared_ptr<Room> createRoom(const std::string& id, const std::string& name, 
-                                     const std::string& description, const std::string& biome);
-    void connectRooms(const std::string& room1, const std::string& room2, 
-                     const std::string& direction1, const std::string& direction2);
+    // Rooms
+    RoomId addRoom(const std::string& key, const std::string& name, const std::string& description,
+                   const std::string& biome = "");
+    void addExit(RoomId from, Direction direction, RoomId to);
+    Room* getRoom(RoomId id);
+    RoomId findRoom(std::string_view key) const;       // INVALID_ROOM if unknown
+    uint32_t getRoomCount() const { return graph.getRoomCount(); }
+    // Without making the room
+    std::string_view getRoomKey(RoomId id) const;
+    std::string_view getRoomBiome(RoomId id) const;
+    bool hasLivingBoss(RoomId id) const;
+    const RoomGraph& getGraph() const { return graph; }
+    RoomGraphQuery& getQuery() { return query; }
+    RoomId getStartRoom() const { return startRoom; }
+    void setStartRoom(RoomId room) { startRoom = room; }
     
-    // Populate world with items and enemies
-    void populateWorld();
-    void addQuestItems();
-    void addSecrets();
+    // Biomes
+    BiomeData getBiome(std::string_view biomeName) const;
+    const BiomeData* findBiome(std::string_view biomeName) const;       // nullptr if unknown
+    const WorldFile& getWorldFile() const { return worldFile; }
 };
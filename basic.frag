@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+
+uniform sampler2D texture1;
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+
+void main()
+{
+    vec3 color = texture(texture1, TexCoord).rgb;
+
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(lightPos - FragPos);
+
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16.0);
+
+    vec3 ambient = 0.2 * color;
+    vec3 diffuse = diff * color;
+    vec3 specular = vec3(0.3) * spec;
+
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
@@ -0,0 +1,184 @@
+// Microbenchmark for the particle integration kernels.
+//
+// Compares the original array-of-structs loop (std::vector::erase plus two
+// std::uniform_real_distribution draws per particle) against the SoA kernels
+// at each SIMD level, at 1k, 10k and 100k live particles.
+//
+// Build: make bench   (or: g++ -std=c++17 -O2 -I. benchmarks/ParticleBenchmark.cpp
+//                            ParticleKernels.cpp CpuFeatures.cpp)
+
+#include "ParticleKernels.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 200;
+const float DT = 1.0f / 60.0f;
+
+// Reference: the loop ParticleSystem::update used before the SoA rework
+struct Vec3 { float x, y, z; };
+struct Vec4 { float r, g, b, a; };
+struct LegacyParticle {
+    Vec3 position;
+    Vec3 velocity;
+    Vec4 color;
+    float life;
+    float size;
+};
+
+float randomLife(std::mt19937& gen) {
+    std::uniform_real_distribution<float> dist(0.2f, 3.0f);
+    return dist(gen);
+}
+
+double runLegacy(int count) {
+    std::mt19937 seedGen(1234);
+    std::vector<LegacyParticle> particles;
+    particles.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        particles.push_back({{0, 0, 0}, {1, 3, 1}, {1, 1, 1, 1}, randomLife(seedGen), 0.1f});
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        for (auto it = particles.begin(); it != particles.end();) {
+            it->life -= DT;
+            if (it->life <= 0.0f) {
+                it = particles.erase(it);
+            } else {
+                it->position.x += it->velocity.x * DT;
+                it->position.y += it->velocity.y * DT;
+                it->position.z += it->velocity.z * DT;
+                it->velocity.y -= 9.8f * DT;
+                it->color.a = it->life;
+                it->velocity.x += dis(gen) * DT * 0.5f;
+                it->velocity.z += dis(gen) * DT * 0.5f;
+                ++it;
+            }
+        }
+        // Respawn to hold the live count steady
+        while ((int)particles.size() < count) {
+            particles.push_back({{0, 0, 0}, {1, 3, 1}, {1, 1, 1, 1}, randomLife(seedGen), 0.1f});
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / FRAMES;
+}
+
+struct SoAStorage {
+    std::vector<float> posX, posY, posZ, velX, velY, velZ, colA, life;
+    int active;
+
+    explicit SoAStorage(int count)
+        : posX(count), posY(count), posZ(count), velX(count), velY(count), velZ(count),
+          colA(count), life(count), active(0) {}
+
+    ParticleStreams streams() {
+        return {posX.data(), posY.data(), posZ.data(), velX.data(), velY.data(), velZ.data(),
+                colA.data(), life.data()};
+    }
+
+    void spawn(int i, float lifetime) {
+        posX[i] = posY[i] = posZ[i] = 0.0f;
+        velX[i] = 1.0f; velY[i] = 3.0f; velZ[i] = 1.0f;
+        colA[i] = 1.0f;
+        life[i] = lifetime;
+    }
+
+    void move(int from, int to) {
+        posX[to] = posX[from]; posY[to] = posY[from]; posZ[to] = posZ[from];
+        velX[to] = velX[from]; velY[to] = velY[from]; velZ[to] = velZ[from];
+        colA[to] = colA[from]; life[to] = life[from];
+    }
+};
+
+double runKernel(int count, ParticleKernelLevel level, SoAStorage* result) {
+    setParticleKernelLevel(level);
+
+    std::mt19937 seedGen(1234);
+    SoAStorage soa(count);
+    for (int i = 0; i < count; ++i) soa.spawn(i, randomLife(seedGen));
+    soa.active = count;
+
+    ParticleRng rng;
+    rng.seed(42);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        integrateParticles(soa.streams(), 0, soa.active, DT, rng);
+
+        // Swap-and-pop compaction, as in ParticleSystem::update
+        int i = 0;
+        while (i < soa.active) {
+            if (soa.life[i] <= 0.0f) {
+                --soa.active;
+                if (i != soa.active) soa.move(soa.active, i);
+                continue;
+            }
+            ++i;
+        }
+        while (soa.active < count) soa.spawn(soa.active++, randomLife(seedGen));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    if (result) *result = soa;
+    return std::chrono::duration<double, std::milli>(end - start).count() / FRAMES;
+}
+
+bool sameResults(const SoAStorage& a, const SoAStorage& b) {
+    if (a.active != b.active) return false;
+    for (int i = 0; i < a.active; ++i) {
+        if (a.posX[i] != b.posX[i] || a.posY[i] != b.posY[i] || a.posZ[i] != b.posZ[i] ||
+            a.velX[i] != b.velX[i] || a.velZ[i] != b.velZ[i] || a.life[i] != b.life[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    const int counts[] = {1000, 10000, 100000};
+    const ParticleKernelLevel levels[] = {
+        ParticleKernelLevel::SCALAR, ParticleKernelLevel::SSE41, ParticleKernelLevel::AVX2
+    };
+
+    std::printf("Particle integration, %d frames at dt=1/60 (ms per frame)\n\n", FRAMES);
+    std::printf("%10s %12s", "particles", "legacy AoS");
+    for (ParticleKernelLevel level : levels) {
+        std::printf(" %12s", getParticleKernelName(level));
+    }
+    std::printf("\n");
+
+    bool consistent = true;
+    for (int count : counts) {
+        std::printf("%10d %12.3f", count, runLegacy(count));
+
+        SoAStorage reference(0);
+        for (ParticleKernelLevel level : levels) {
+            if (!isParticleKernelLevelSupported(level)) {
+                std::printf(" %12s", "n/a");
+                continue;
+            }
+            SoAStorage result(0);
+            std::printf(" %12.3f", runKernel(count, level, &result));
+            if (level == ParticleKernelLevel::SCALAR) {
+                reference = result;
+            } else if (!sameResults(reference, result)) {
+                consistent = false;
+            }
+        }
+        std::printf("\n");
+    }
+
+    std::printf("\nSIMD results %s the scalar kernel\n", consistent ? "match" : "DIFFER FROM");
+    return consistent ? 0 : 1;
+}